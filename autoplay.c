@@ -0,0 +1,304 @@
+/*
+ * autoplay.c
+ *
+ * Author: William Sawyer
+ *
+ * The bot described in autoplay.h. Each search is breadth first from
+ * the player, each square queued carrying the direction of the first
+ * step towards it, so the bot only has to remember that one direction
+ * once a goal is reached. It moves one square, then searches again.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "autoplay.h"
+
+#if AUTOPLAY
+
+#include "game.h"
+#include "levels.h"
+#include "timer0.h"
+
+// queued squares keep the first direction in the top 2 bits of x
+#if WORLD_MAX_WIDTH > 64
+#error "autoplay can't queue squares of worlds wider than 64"
+#endif
+
+// the most squares waiting to be looked at, if the queue fills squares
+// are dropped and a goal may not be found
+#define QUEUE_LENGTH	32
+
+// what the bot is doing
+#define BOT_SEEK		0	// heading for a diamond or the exit
+#define BOT_ESCAPE		1	// checking it can get out of range of a bomb
+							// before planting it
+#define BOT_RETREAT		2	// getting out of range of its bomb
+#define BOT_WAIT		3	// waiting for the bomb to go off
+
+// progress of a search
+#define SEARCH_IDLE		0	// none started since the last move
+#define SEARCH_RUNNING	1
+#define SEARCH_DONE		2	// direction holds the result
+
+#define NO_DIRECTION	0xFF
+
+#define NUM_DIRECTIONS	4
+static const int8_t directions[NUM_DIRECTIONS][2] =
+		{{0,1}, {0,-1}, {1,0}, {-1,0}};
+
+static uint8_t active;
+static uint8_t state;
+static uint32_t next_move_time;
+static uint8_t bomb_x, bomb_y;
+
+static uint8_t search;
+static uint8_t direction;		// first step towards the goal found
+static uint8_t through_walls;	// breakable walls may be bombed on the way
+static uint8_t visited[WORLD_MAX_WIDTH * WORLD_MAX_HEIGHT / 8];
+static uint8_t queue_x[QUEUE_LENGTH], queue_y[QUEUE_LENGTH];
+static uint8_t queue_start, queue_length;
+
+// the squares a seek is looking for, uncollected diamonds or the exit
+static uint8_t goal_x[MAX_DIAMONDS], goal_y[MAX_DIAMONDS];
+static uint8_t num_goals;
+
+// the playing field, as it was when the search started
+static const uint8_t* terrain;
+static uint8_t width, height;
+static uint8_t exit_x, exit_y, exit_present;
+
+static uint8_t terrain_at(uint8_t x, uint8_t y) {
+	uint16_t i = (uint16_t)y * width + x;
+	return (terrain[i >> 2] >> ((i & 3) << 1)) & 3;
+}
+
+static uint8_t distance(uint8_t x1, uint8_t y1, uint8_t x2, uint8_t y2) {
+	return (x1 > x2 ? x1 - x2 : x2 - x1) + (y1 > y2 ? y1 - y2 : y2 - y1);
+}
+
+static uint8_t is_goal(uint8_t x, uint8_t y) {
+	if (state != BOT_SEEK) {
+		// out of range of the bomb
+		return distance(x, y, bomb_x, bomb_y) > 1;
+	}
+	for (uint8_t i = 0; i < num_goals; i++) {
+		if (goal_x[i] == x && goal_y[i] == y) {
+			return 1;
+		}
+	}
+	return 0;
+}
+
+// queues the square (x,y), reached from (from_x,from_y), if it can be
+// moved to and hasn't been seen yet
+static void visit(uint8_t x, uint8_t y, uint8_t first, uint8_t from_x,
+		uint8_t from_y) {
+	// squares off the left or bottom wrap round to 255
+	if (x >= width || y >= height) {
+		return;
+	}
+	uint16_t i = (uint16_t)y * width + x;
+	uint8_t mask = 1 << (i & 7);
+	if (visited[i >> 3] & mask) {
+		return;
+	}
+	uint8_t kind = terrain[i >> 2] >> ((i & 3) << 1) & 3;
+	if (kind == TERRAIN_UNBREAKABLE) {
+		return;
+	}
+	if (kind != TERRAIN_EMPTY && !(through_walls && state == BOT_SEEK
+			&& !(exit_present
+			&& distance(from_x, from_y, exit_x, exit_y) <= 1))) {
+		// the wall would be bombed from (from_x,from_y), and never where
+		// the blast would destroy the exit
+		return;
+	}
+	visited[i >> 3] |= mask;
+	if (is_goal(x, y)) {
+		direction = first;
+		search = SEARCH_DONE;
+		return;
+	}
+	if (queue_length == QUEUE_LENGTH) {
+		return;
+	}
+	uint8_t end = queue_start + queue_length++;
+	if (end >= QUEUE_LENGTH) {
+		end -= QUEUE_LENGTH;
+	}
+	queue_x[end] = x | first << 6;
+	queue_y[end] = y;
+}
+
+static void start_search(void) {
+	uint8_t player_x = get_player_x();
+	uint8_t player_y = get_player_y();
+	terrain = get_terrain_data();
+	width = get_world_width();
+	height = get_world_height();
+	exit_present = get_exit(&exit_x, &exit_y);
+	if (state == BOT_SEEK) {
+		num_goals = 0;
+		for (uint8_t i = 0; i < get_diamonds_available(); i++) {
+			if (get_diamond(i, &goal_x[num_goals], &goal_y[num_goals])) {
+				num_goals++;
+			}
+		}
+		if (num_goals == 0 && exit_present) {
+			goal_x[0] = exit_x;
+			goal_y[0] = exit_y;
+			num_goals = 1;
+		}
+	}
+	memset(visited, 0, ((uint16_t)width * height + 7) / 8);
+	visited[((uint16_t)player_y * width + player_x) >> 3] |=
+			1 << ((player_y * width + player_x) & 7);
+	queue_start = 0;
+	queue_length = 0;
+	direction = NO_DIRECTION;
+	search = SEARCH_RUNNING;
+	for (uint8_t d = 0; d < NUM_DIRECTIONS && search == SEARCH_RUNNING; d++) {
+		visit(player_x + directions[d][0], player_y + directions[d][1], d,
+				player_x, player_y);
+	}
+}
+
+// looks at up to AUTOPLAY_SEARCH_SQUARES more squares
+static void continue_search(void) {
+	for (uint8_t n = 0; n < AUTOPLAY_SEARCH_SQUARES; n++) {
+		if (search != SEARCH_RUNNING) {
+			return;
+		}
+		if (queue_length == 0) {
+			// nowhere left to look
+			search = SEARCH_DONE;
+			return;
+		}
+		uint8_t x = queue_x[queue_start] & 0x3F;
+		uint8_t first = queue_x[queue_start] >> 6;
+		uint8_t y = queue_y[queue_start];
+		if (++queue_start == QUEUE_LENGTH) {
+			queue_start = 0;
+		}
+		queue_length--;
+		for (uint8_t d = 0; d < NUM_DIRECTIONS; d++) {
+			visit(x + directions[d][0], y + directions[d][1], first, x, y);
+		}
+	}
+}
+
+// moves the player in the direction found, if it is time to
+static uint8_t step(uint32_t current_time) {
+	if (!TIME_REACHED(current_time, next_move_time)) {
+		return 0;
+	}
+	next_move_time = current_time + AUTOPLAY_STEP_DELAY;
+	search = SEARCH_IDLE;
+	return move_player(directions[direction][0], directions[direction][1]);
+}
+
+uint8_t autoplay_toggle(void) {
+	active = !active;
+	autoplay_reset();
+	return active;
+}
+
+void autoplay_reset(void) {
+	// the bot may take over with a bomb already lit
+	state = BOT_WAIT;
+	search = SEARCH_IDLE;
+	next_move_time = 0;
+}
+
+uint8_t autoplay_active(void) {
+	return active;
+}
+
+uint8_t autoplay_update(uint32_t current_time) {
+	if (!active) {
+		return 0;
+	}
+	if (changing_level()) {
+		state = BOT_SEEK;
+		search = SEARCH_IDLE;
+		return 0;
+	}
+	if (search == SEARCH_RUNNING) {
+		continue_search();
+		return 0;
+	}
+
+	uint8_t player_x = get_player_x();
+	uint8_t player_y = get_player_y();
+	switch (state) {
+		case BOT_WAIT:
+			if (!bombs_in_play()) {
+				state = BOT_SEEK;
+				search = SEARCH_IDLE;
+			}
+			return 0;
+		case BOT_SEEK:
+			if (search == SEARCH_IDLE) {
+				if (get_score() == get_diamonds_available()
+						&& get_exit(&exit_x, &exit_y)
+						&& player_x == exit_x && player_y == exit_y) {
+					// every diamond is collected, step out of the level
+					direction = 2;
+					return step(current_time);
+				}
+				through_walls = 0;
+				start_search();
+				return 0;
+			}
+			if (direction == NO_DIRECTION) {
+				if (!through_walls) {
+					// try again, bombing through walls
+					through_walls = 1;
+					start_search();
+				} else if (TIME_REACHED(current_time, next_move_time)) {
+					// nowhere to go for now
+					next_move_time = current_time + AUTOPLAY_STEP_DELAY;
+					search = SEARCH_IDLE;
+				}
+				return 0;
+			}
+			if (terrain_at(player_x + directions[direction][0],
+					player_y + directions[direction][1]) == TERRAIN_EMPTY) {
+				return step(current_time);
+			}
+			// there is a wall in the way, make sure there is a way out of
+			// range of a bomb here before planting it
+			bomb_x = player_x;
+			bomb_y = player_y;
+			state = BOT_ESCAPE;
+			start_search();
+			return 0;
+		case BOT_ESCAPE:
+			if (direction == NO_DIRECTION) {
+				// no way out, look again after the next move
+				state = BOT_SEEK;
+				next_move_time = current_time + AUTOPLAY_STEP_DELAY;
+				search = SEARCH_IDLE;
+				return 0;
+			}
+			plant_bomb(current_time);
+			state = BOT_RETREAT;
+			return step(current_time);
+		case BOT_RETREAT:
+			if (distance(player_x, player_y, bomb_x, bomb_y) > 1) {
+				state = BOT_WAIT;
+			} else if (search == SEARCH_IDLE) {
+				start_search();
+			} else if (direction == NO_DIRECTION) {
+				// trapped
+				state = BOT_WAIT;
+			} else {
+				return step(current_time);
+			}
+			return 0;
+	}
+	return 0;
+}
+
+#endif /* AUTOPLAY */
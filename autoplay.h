@@ -0,0 +1,72 @@
+/*
+ * autoplay.h
+ *
+ * Author: William Sawyer
+ *
+ * A bot which plays the game by itself, as a demo and to soak test
+ * boards. It heads for the nearest diamond, and once they are all
+ * collected for the exit, by a breadth first search over the packed
+ * playing field. When the only way on is through a breakable wall it
+ * plants a bomb next to it, first checking that it can get out of the
+ * blast, then moves out of range (see in_danger()) and waits for the
+ * explosion. It never bombs next to the exit, which an explosion would
+ * destroy. While it is on, a game which ends starts again by itself.
+ *
+ * The search is spread over passes of the game loop, each call looking
+ * at no more than AUTOPLAY_SEARCH_SQUARES squares, so a pass never takes
+ * much longer than a tick (1 ms) with the bot on. It keeps a bit for each
+ * square of the largest world and a short queue, about 300 bytes of RAM
+ * in all, so it is only compiled in when AUTOPLAY is defined to 1.
+ */
+
+#ifndef AUTOPLAY_H_
+#define AUTOPLAY_H_
+
+#include <stdint.h>
+
+#include "profile.h"
+
+#ifndef AUTOPLAY
+#define AUTOPLAY 0
+#endif
+
+#if AUTOPLAY && PROFILE
+#error "the bot and the profiler don't both fit in RAM"
+#endif
+
+// the most squares looked at in each call of autoplay_update()
+#define AUTOPLAY_SEARCH_SQUARES	16
+
+// the least game time between the bot's moves, in ms
+#define AUTOPLAY_STEP_DELAY		150
+
+#if AUTOPLAY
+
+/* Turn the bot on or off, returns whether it is now on.
+ */
+uint8_t autoplay_toggle(void);
+
+/* Return 1 if the bot is on.
+ */
+uint8_t autoplay_active(void);
+
+/* Forget what the bot was doing, for when a game starts.
+ */
+void autoplay_reset(void);
+
+/* Let the bot search or make its next move, if it is on. 'current_time'
+ * is the game time. Returns the number of squares the player moved.
+ * Call this from the game loop.
+ */
+uint8_t autoplay_update(uint32_t current_time);
+
+#else
+
+#define autoplay_toggle()				0
+#define autoplay_active()				0
+#define autoplay_reset()
+#define autoplay_update(current_time)	0
+
+#endif /* AUTOPLAY */
+
+#endif /* AUTOPLAY_H_ */
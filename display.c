@@ -1,85 +1,141 @@
-/*
- * display.c
- *
- * Author: Luke Kamols
- */ 
-
-#include <stdio.h>
-#include <avr/pgmspace.h>
-
-#include "display.h"
-#include "pixel_colour.h"
-#include "ledmatrix.h"
-
-// constant value used to display 'D <> M' on launch
-static const uint8_t miners_display[MATRIX_NUM_COLUMNS] = 
-		{125, 69, 69, 57, 0, 16, 56, 124, 56, 16, 0, 125, 33, 17, 33, 125};
-
-void initialise_display(void) {
-	// clear the LED matrix
-	ledmatrix_clear();
-}
-
-void start_display(void) {
-	PixelColour colour;
-	MatrixColumn column_colour_data;
-	uint8_t col_data;
-		
-	ledmatrix_clear(); // start by clearing the LED matrix
-	for (uint8_t col = 0; col < MATRIX_NUM_COLUMNS; col++) {
-		col_data = miners_display[col];
-		// using the LSB as the colour determining bit, 1 is red, 0 is green
-		if (col_data & 0x01) {
-			colour = COLOUR_RED;
-		} else {
-			colour = COLOUR_GREEN;
-		}
-		// go through the top 7 bits (not the bottom one as that was our colour bit)
-		// and set any to be the correct colour
-		for(uint8_t i=7; i>=1; i--) {
-			// If the relevant font bit is set, we make this a coloured pixel, else blank
-			if(col_data & 0x80) {
-				column_colour_data[i] = colour;
-				} else {
-				column_colour_data[i] = 0;
-			}
-			col_data <<= 1;
-		}
-		column_colour_data[0] = 0;
-		ledmatrix_update_column(col, column_colour_data);
-	}
-}
-
-void update_square_colour(uint8_t x, uint8_t y, uint8_t object) {
-	// first check that this is a square within the game field
-	// if outside the game field, don't update anything
-	if (x < 0 || x >= WIDTH || y < 0 || y >= HEIGHT) {
-		return;
-	}
-	
-	// determine which colour corresponds to this object
-	PixelColour colour;
-	if (object == PLAYER) {
-		colour = MATRIX_COLOUR_PLAYER;
-	} else if (object == FACING) {
-		colour = MATRIX_COLOUR_FACING;
-	} else if (object == INSPECTED) {
-		colour = MATRIX_COLOUR_BREAKABLE;
-	} else if (object == BREAKABLE || object == UNBREAKABLE) {
-		colour = MATRIX_COLOUR_WALL;
-	} else if (object == DIAMOND) {
-		colour = MATRIX_COLOUR_DIAMOND;
-	} else if (object == UNDISCOVERED) {
-		colour = MATRIX_COLOUR_UNDISCOVERED;
-	} else if (object == BOMB) {
-		colour = MATRIX_COLOUR_BOMB;
-	} else if (object == EXPLOSION) {
-		colour = MATRIX_COLOUR_EXPLOSION;
-	} else {
-		// anything unexpected (or empty) will be black
-		colour = MATRIX_COLOUR_EMPTY;
-	}
-
-	// update the pixel at the given location with this colour
-	ledmatrix_update_pixel(x, y, colour);
+/*
+ * display.c
+ *
+ * Author: Luke Kamols
+ */ 
+
+#include <stdio.h>
+#include <avr/pgmspace.h>
+
+#include "display.h"
+#include "game.h"
+#include "pixel_colour.h"
+#include "ledmatrix.h"
+#include "images.h"
+#include "profile.h"
+
+const ObjectProperties object_properties[NUM_OBJECTS] PROGMEM = 
+		{
+			// EMPTY_SQUARE
+			{OBJECT_WALKABLE | OBJECT_OPEN, MATRIX_COLOUR_EMPTY},
+			// PLAYER
+			{0, MATRIX_COLOUR_PLAYER},
+			// FACING
+			{0, MATRIX_COLOUR_FACING},
+			// BREAKABLE
+			{OBJECT_DESTRUCTIBLE | OBJECT_BREAKABLE | OBJECT_INSPECTABLE, 
+					MATRIX_COLOUR_WALL},
+			// UNBREAKABLE
+			{0, MATRIX_COLOUR_WALL},
+			// DIAMOND
+			{OBJECT_WALKABLE | OBJECT_OPEN | OBJECT_COLLECTABLE, 
+					MATRIX_COLOUR_DIAMOND},
+			// UNDISCOVERED
+			{0, MATRIX_COLOUR_UNDISCOVERED},
+			// INSPECTED
+			{OBJECT_DESTRUCTIBLE | OBJECT_BREAKABLE, MATRIX_COLOUR_BREAKABLE},
+			// BOMB
+			{OBJECT_WALKABLE, MATRIX_COLOUR_BOMB},
+			// EXPLOSION
+			{0, MATRIX_COLOUR_EXPLOSION},
+			// EXIT (looks like an empty square)
+			{OBJECT_WALKABLE | OBJECT_OPEN | OBJECT_DESTRUCTIBLE, MATRIX_COLOUR_EMPTY}
+		};
+
+// the playing field square shown at the bottom left of the display
+static uint8_t camera_x, camera_y;
+
+void initialise_display(void) {
+	// clear the LED matrix
+	ledmatrix_clear();
+}
+
+void start_display(void) {
+	// show 'D <> M' on launch
+	ledmatrix_show_image(miners_image);
+}
+
+void update_square_colour(uint8_t x, uint8_t y, uint8_t object) {
+	// first check that this square is on the display
+	// if it isn't, don't update anything - squares left of or below
+	// the camera wrap around to large values
+	uint8_t display_x = x - camera_x;
+	uint8_t display_y = y - camera_y;
+	if (display_x >= WIDTH || display_y >= HEIGHT) {
+		return;
+	}
+	PROFILE_ENTER(PROFILE_SQUARE);
+	
+	// determine which colour corresponds to this object
+	PixelColour colour = object_colour(object);
+
+	// update the pixel at the given location with this colour
+	ledmatrix_update_pixel(display_x, display_y, colour);
+	PROFILE_EXIT(PROFILE_SQUARE);
+}
+
+void set_camera(uint8_t x, uint8_t y) {
+	camera_x = x;
+	camera_y = y;
+}
+
+uint8_t get_camera_x(void) {
+	return camera_x;
+}
+
+uint8_t get_camera_y(void) {
+	return camera_y;
+}
+
+void redraw_display(void) {
+	// a row at a time, a whole MatrixData would put 128 bytes on the stack
+	MatrixRow row;
+	for (uint8_t y = 0; y < HEIGHT; y++) {
+		for (uint8_t x = 0; x < WIDTH; x++) {
+			row[x] = object_colour(get_display_object(camera_x + x, 
+					camera_y + y));
+		}
+		ledmatrix_update_row(y, row);
+	}
+}
+
+void scroll_camera(int8_t dx, int8_t dy) {
+	MatrixColumn column;
+	MatrixRow row;
+	uint8_t display_x, display_y;
+	
+	if (dx) {
+		camera_x += dx;
+		// moving the camera right moves everything shown left, exposing
+		// the rightmost column
+		if (dx > 0) {
+			ledmatrix_shift_display_left();
+			display_x = WIDTH - 1;
+		} else {
+			ledmatrix_shift_display_right();
+			display_x = 0;
+		}
+		for (uint8_t y = 0; y < HEIGHT; y++) {
+			column[y] = object_colour(get_display_object(camera_x + display_x,
+					camera_y + y));
+		}
+		ledmatrix_update_column(display_x, column);
+	}
+	if (dy) {
+		camera_y += dy;
+		// moving the camera up moves everything shown down, exposing
+		// the top row
+		if (dy > 0) {
+			ledmatrix_shift_display_down();
+			display_y = HEIGHT - 1;
+		} else {
+			ledmatrix_shift_display_up();
+			display_y = 0;
+		}
+		for (uint8_t x = 0; x < WIDTH; x++) {
+			row[x] = object_colour(get_display_object(camera_x + x, 
+					camera_y + display_y));
+		}
+		ledmatrix_update_row(display_y, row);
+	}
 }
\ No newline at end of file
@@ -1,58 +1,122 @@
-/*
- * display.h
- *
- * Author: Luke Kamols
- */ 
-
-#ifndef DISPLAY_H_
-#define DISPLAY_H_
-
-#include "pixel_colour.h"
-
-// display dimensions, these match the size of the playing field
-#define WIDTH  16
-#define HEIGHT 8
-
-// object definitions
-#define EMPTY_SQUARE	0
-#define PLAYER			1
-#define FACING			2
-#define BREAKABLE	 	3
-#define UNBREAKABLE		4
-#define DIAMOND			5
-#define UNDISCOVERED	6
-#define INSPECTED		7
-#define BOMB			8
-#define EXPLOSION		9
-#define EXIT			10
-
-// matrix colour definitions
-#define MATRIX_COLOUR_EMPTY			COLOUR_BLACK
-#define MATRIX_COLOUR_PLAYER		COLOUR_RED
-#define MATRIX_COLOUR_FACING		COLOUR_LIGHT_RED
-#define MATRIX_COLOUR_BREAKABLE     COLOUR_LIGHT_GREEN
-#define MATRIX_COLOUR_WALL			COLOUR_YELLOW
-#define MATRIX_COLOUR_DIAMOND		COLOUR_GREEN
-#define MATRIX_COLOUR_UNDISCOVERED	COLOUR_LIGHT_YELLOW
-#define MATRIX_COLOUR_BOMB			COLOUR_ORANGE
-#define MATRIX_COLOUR_EXPLOSION		COLOUR_LIGHT_ORANGE
-
-/*
- * initialise the display for the playing field
- */
-void initialise_display(void);
-
-/*
- * display a start screen
- */
-void start_display(void);
-
-/*
- * updates the colour at square (x, y) to be the colour
- * of the object 'object'
- * 'object' is expected to be EMPTY_SQUARE, PLAYER, FACING, 
- * BREAKABLE, UNBREAKABLE, DIAMOND or UNDISCOVERED
- */
-void update_square_colour(uint8_t x, uint8_t y, uint8_t object);
-
+/*
+ * display.h
+ *
+ * Author: Luke Kamols
+ */ 
+
+#ifndef DISPLAY_H_
+#define DISPLAY_H_
+
+#include <avr/pgmspace.h>
+
+#include "pixel_colour.h"
+
+// display dimensions, the display is a window onto a part of the 
+// playing field, which may be larger
+#define WIDTH  16
+#define HEIGHT 8
+
+// object definitions
+#define EMPTY_SQUARE	0
+#define PLAYER			1
+#define FACING			2
+#define BREAKABLE	 	3
+#define UNBREAKABLE		4
+#define DIAMOND			5
+#define UNDISCOVERED	6
+#define INSPECTED		7
+#define BOMB			8
+#define EXPLOSION		9
+#define EXIT			10
+#define NUM_OBJECTS		11
+
+// matrix colour definitions
+#define MATRIX_COLOUR_EMPTY			COLOUR_BLACK
+#define MATRIX_COLOUR_PLAYER		COLOUR_RED
+#define MATRIX_COLOUR_FACING		COLOUR_LIGHT_RED
+#define MATRIX_COLOUR_BREAKABLE     COLOUR_LIGHT_GREEN
+#define MATRIX_COLOUR_WALL			COLOUR_YELLOW
+#define MATRIX_COLOUR_DIAMOND		COLOUR_GREEN
+#define MATRIX_COLOUR_UNDISCOVERED	COLOUR_LIGHT_YELLOW
+#define MATRIX_COLOUR_BOMB			COLOUR_ORANGE
+#define MATRIX_COLOUR_EXPLOSION		COLOUR_LIGHT_ORANGE
+
+// object property flags
+#define OBJECT_WALKABLE		0x01	// the player can move onto it
+#define OBJECT_OPEN			0x02	// visibility spreads through it
+#define OBJECT_DESTRUCTIBLE	0x04	// an explosion clears it
+#define OBJECT_BREAKABLE	0x08	// inspecting it in cheat mode clears it
+#define OBJECT_INSPECTABLE	0x10	// inspecting it outside cheat mode marks it
+#define OBJECT_COLLECTABLE	0x20	// the player picks it up by walking onto it
+
+// the properties of each object, indexed by object code (see display.c)
+typedef struct {
+	uint8_t flags;
+	PixelColour colour;
+} ObjectProperties;
+
+extern const ObjectProperties object_properties[NUM_OBJECTS] PROGMEM;
+
+/*
+ * returns the property flags of 'object', unknown objects have none
+ */
+static inline uint8_t object_flags(uint8_t object) {
+	if (object >= NUM_OBJECTS) {
+		return 0;
+	}
+	return pgm_read_byte(&object_properties[object].flags);
+}
+
+/*
+ * returns the colour 'object' is shown as, unknown objects are shown
+ * as empty squares
+ */
+static inline PixelColour object_colour(uint8_t object) {
+	if (object >= NUM_OBJECTS) {
+		return MATRIX_COLOUR_EMPTY;
+	}
+	return pgm_read_byte(&object_properties[object].colour);
+}
+
+/*
+ * initialise the display for the playing field
+ */
+void initialise_display(void);
+
+/*
+ * display a start screen
+ */
+void start_display(void);
+
+/*
+ * updates the colour at square (x, y) of the playing field to be the 
+ * colour of the object 'object', squares not currently on the display
+ * are ignored
+ * 'object' is expected to be one of the object definitions above
+ */
+void update_square_colour(uint8_t x, uint8_t y, uint8_t object);
+
+/*
+ * moves the display so that its bottom left corner shows square (x, y)
+ * of the playing field, nothing is redrawn
+ */
+void set_camera(uint8_t x, uint8_t y);
+
+// return the playing field coordinates of the bottom left of the display
+uint8_t get_camera_x(void);
+uint8_t get_camera_y(void);
+
+/*
+ * redraws the whole display from get_display_object (see game.h), sent
+ * to the matrix as a single update
+ */
+void redraw_display(void);
+
+/*
+ * moves the display by (dx, dy) squares, each of which should be -1, 0
+ * or 1. The matrix is shifted and only the newly exposed column and row 
+ * are sent, using get_display_object (see game.h)
+ */
+void scroll_camera(int8_t dx, int8_t dy);
+
 #endif 
\ No newline at end of file
@@ -1,438 +1,1100 @@
-/*
- * game.c
- *
- * Contains functions relating to the play of Diamond Miners
- *
- * Author: Luke Kamols
- */ 
-
-
-#include "game.h"
-#include "display.h"
-#include "terminalio.h"
-#include "avr\pgmspace.h"
-#include "timer0.h"
-
-#include <stdlib.h>
-#include <stdio.h>
-
-#define PLAYER_START_X  0
-#define PLAYER_START_Y  0
-#define FACING_START_X  1
-#define FACING_START_Y  0
-#define CHEAT_START     0
-
-// game level layouts
-// the values 0, 3, 4 and 5 are defined in display.h
-// note that this is not laid out in such a way that level_n_layout[x][y]
-// does not correspond to an (x,y) coordinate but is a better visual
-// representation
-static const uint8_t level_1_layout[HEIGHT][WIDTH] = 
-		{
-			{0, 3, 0, 3, 0, 0, 0, 4, 4, 0, 0, 4, 0, 4, 0, 4},
-			{0, 4, 0, 4, 0, 0, 0, 3, 4, 4, 3, 4, 0, 3, 0, 4},
-			{0, 4, 0, 4, 4, 4, 4, 0, 3, 0, 0, 0, 0, 4, 0, 4},
-			{5, 4, 0, 4, 0, 0, 3, 0, 0, 4, 0, 0, 0, 4, 0, 10},
-			{4, 4, 3, 4, 5, 0, 4, 0, 0, 4, 3, 4, 0, 0, 4, 4},
-			{0, 0, 0, 4, 4, 4, 4, 0, 4, 0, 0, 0, 4, 3, 0, 4},
-			{0, 0, 0, 3, 0, 0, 3, 0, 3, 0, 3, 0, 3, 0, 0, 4},
-			{0, 0, 0, 4, 0, 0, 3, 0, 4, 0, 0, 3, 3, 0, 5, 4} 
-		};
-#define NUM_L1_DIAMONDS 3
-static const uint8_t l1_diamonds[NUM_L1_DIAMONDS][2] = {{0, 4}, {4, 3}, {14, 0}};
-
-static const uint8_t level_2_layout[HEIGHT][WIDTH] =
-		{
-			{4, 4, 3, 4, 4, 0, 4, 4, 3, 3, 3, 4, 0, 3, 0, 4},
-			{0, 0, 0, 5, 3, 0, 0, 4, 4, 4, 0, 4, 5, 4, 0, 4},
-			{3, 4, 4, 4, 4, 0, 3, 0, 0, 3, 0, 4, 0, 4, 0, 3},
-			{0, 3, 0, 4, 0, 0, 0, 0, 0, 4, 0, 4, 0, 3, 0, 3},
-			{4, 4, 4, 4, 0, 0, 4, 4, 3, 4, 0, 0, 4, 4, 4, 0},
-			{0, 0, 0, 3, 0, 0, 4, 5, 0, 4, 0, 0, 0, 0, 3, 3},
-			{0, 0, 0, 4, 3, 3, 0, 0, 0, 4, 0, 4, 4, 4, 4, 10},
-			{0, 0, 0, 4, 3, 4, 4, 4, 4, 4, 0, 3, 5, 0, 4, 0},
-		};
-#define NUM_L2_DIAMONDS	4
-static const uint8_t l2_diamonds[NUM_L2_DIAMONDS][2] = {{3, 7}, {7, 3}, {12, 0}, {12, 7}};
-		
-#define NUM_DIRECTIONS 8
-static const uint8_t directions[NUM_DIRECTIONS][2] = {{0,1}, {0,-1}, {1,0}, {-1,0}};
-
-// variables for the current state of the game
-uint8_t playing_field[WIDTH][HEIGHT]; // what is currently located at each square
-uint8_t visible[WIDTH][HEIGHT]; // whether each square is currently visible
-uint8_t player_x, player_y;
-uint8_t facing_x, facing_y, facing_visible;
-uint8_t bomb_x, bomb_y, bomb_planted, bomb_visible, det_x, det_y;
-uint8_t cheating;
-uint8_t level;
-uint8_t total_score = 0;
-uint8_t score;
-uint8_t diamonds_available;
-uint8_t game_over;
-
-// function prototypes for this file
-void discoverable_dfs(uint8_t x, uint8_t y);
-void initialise_terminal_display(void);
-void initialise_game_display(void);
-void initialise_game_state(uint8_t level, uint8_t score);
-void collect_diamond(uint8_t x, uint8_t y);
-void finish_level(void);
-
-/*
- * initialise the game state, sets up the playing field, visibility
- * the player and the player direction indicator
- */
-void initialise_game_state(uint8_t current_level, uint8_t current_score) {
-	// initialise the player position and the facing position
-	player_x = PLAYER_START_X;
-	player_y = PLAYER_START_Y;
-	facing_x = FACING_START_X;
-	facing_y = FACING_START_Y;
-	facing_visible = 1;
-	bomb_planted = 0;
-    cheating = CHEAT_START;
-	level = current_level + 1;
-	total_score += current_score;
-	score = 0;
-	if (level % 2 == 0) {
-		diamonds_available = NUM_L2_DIAMONDS;
-		} else {
-		diamonds_available = NUM_L1_DIAMONDS;
-	}
-	game_over = 0;
-	
-	// go through and initialise the state of the playing_field
-	for (int x = 0; x < WIDTH; x++) {
-		for (int y = 0; y < HEIGHT; y++) {
-			// initialise this square based on the starting layout
-			// the indices here are to ensure the starting layout
-			// could be easily visualised when declared
-			if (level % 2 == 1) {
-				playing_field[x][y] = level_1_layout[HEIGHT - 1 - y][x];
-			} else if (level % 2 == 0) {
-				playing_field[x][y] = level_2_layout[HEIGHT - 1 -y][x];
-			}
-			// set all squares to start not visible, this will be
-			// updated once the display is initialised as well
-			visible[x][y] = 0;
-		}
-	}	
-}
-
-/*
- * initialise the display of the game, shows the player and the player
- * direction indicator. 
- * executes a visibility search from the player's starting location
- */
-void initialise_game_display(void) {
-	// initialise the display
-	initialise_display();
-	// make the entire playing field undiscovered to start
-	for (int x = 0; x < WIDTH; x++) {
-		for (int y = 0; y < HEIGHT; y++) {
-			update_square_colour(x, y, UNDISCOVERED);
-		}
-	}
-	// now explore visibility from the starting location
-	discoverable_dfs(player_x, player_y);
-	// make the player and facing square visible
-	update_square_colour(player_x, player_y, PLAYER);
-	update_square_colour(facing_x, facing_y, FACING);
-}
-
-void initialise_terminal_display(void) {
-	clear_terminal();
-	move_terminal_cursor(LEVEL_X, LEVEL_Y);
-	printf_P(PSTR("Level: %d"), level);
-	move_terminal_cursor(SCORE_X, SCORE_Y);
-	printf_P(PSTR("Diamonds Collected: %d of %d"), score, diamonds_available);
-	move_terminal_cursor(CHEAT_X, CHEAT_Y);
-	printf_P(PSTR("Cheat Mode: Disabled"));
-	move_terminal_cursor(0, 0); // gets cursor out of the way
-}
-
-void initialise_game(uint8_t level, uint8_t score) {
-	// to initialise the game, we need to initialise the state (variables),
-	// the display and the terminal
-	initialise_game_state(level, score);
-	initialise_game_display();
-	initialise_terminal_display();
-}
-
-uint8_t in_bounds(uint8_t x, uint8_t y) {
-	// a square is in bounds if 0 <= x < WIDTH && 0 <= y < HEIGHT
-	return x >= 0 && x < WIDTH && y >= 0 && y < HEIGHT;
-}
-
-uint8_t get_object_at(uint8_t x, uint8_t y) {
-	// check the bounds, anything outside the bounds
-	// will be considered an unbreakable wall
-	if (!in_bounds(x,y)) {
-		return UNBREAKABLE;
-	} else {
-		//if in the bounds, just index into the array
-		return playing_field[x][y];
-	}
-}
-
-void flash_facing(void) {
-	// only flash the facing cursor if it is in bounds
-	if (in_bounds(facing_x, facing_y)) {
-		if (facing_visible) {
-			// we need to flash the facing cursor off, it should be replaced by
-			// the colour of the piece which is at that location
-			uint8_t piece_at_cursor = get_object_at(facing_x, facing_y);
-			update_square_colour(facing_x, facing_y, piece_at_cursor);
-		
-		} else {
-			// we need to flash the facing cursor on
-			update_square_colour(facing_x, facing_y, FACING);
-		}
-		facing_visible = 1 - facing_visible;
-	}
-}
-
-uint8_t move_player(int8_t dx, int8_t dy) {
-	uint8_t valid = 0;
-	// remove the display of the player at the current location
-	// and the player direction indicator and replace them each
-	// with whatever else is at those locations
-    update_square_colour(player_x, player_y, get_object_at(player_x, player_y));
-	update_square_colour(facing_x, facing_y, get_object_at(facing_x, facing_y));
-	
-	if (get_object_at(player_x, player_y) == EXIT && dx == 1 && dy == 0) {
-		if (level % 2 == 1 && score == 3) {
-			finish_level();
-		} else if (level % 2 == 0 && score == 4) {
-			finish_level();
-		}
-	}
-
-	// if the player can move, update the position of the player
-    uint8_t dest_object = get_object_at(player_x + dx, player_y + dy);
-    if (dest_object == DIAMOND || dest_object == EMPTY_SQUARE
-			|| dest_object == BOMB || dest_object == EXIT) {
-        player_x += dx;
-        player_y += dy;
-		valid = 1;
-    }
-
-    // update direction indicator
-    facing_x = player_x + dx;
-	facing_y = player_y + dy;
-
-    // display the player at the new location
-    update_square_colour(player_x, player_y, PLAYER);
-	
-	if (get_object_at(player_x, player_y) == DIAMOND) {
-		collect_diamond(player_x, player_y);
-	}
-
-    // restart player direction indicator flashing cycle
-    facing_visible = 1;
-    flash_facing();
-	
-	return valid;
-}
-
-void inspect_facing(void) {
-	uint8_t inspected = get_object_at(facing_x, facing_y);
-    if (cheating) {
-        if (inspected == BREAKABLE || inspected == INSPECTED) {
-			playing_field[facing_x][facing_y] = EMPTY_SQUARE;
-			discoverable_dfs(facing_x, facing_y);
-        }
-	} else {
-		if (inspected == BREAKABLE) {
-			playing_field[facing_x][facing_y] = INSPECTED;
-			visible[facing_x][facing_y] = 1;
-			update_square_colour(facing_x, facing_y, INSPECTED);
-        }
-    }
-}
-
-void toggle_cheat(void) {
-    cheating = 1 - cheating;
-	update_cheat(cheating);
-}
-
-// checks if the player is on a diamond. If they are, remove the
-// diamond, increment their score and update terminal "scoreboard"
-void collect_diamond(uint8_t x, uint8_t y) {
-    playing_field[x][y] = EMPTY_SQUARE;
-    score++;
-    update_score(score);
-}
-
-uint32_t detect_diamond() {
-    uint8_t diamond_x, diamond_y, x_diff, y_diff, distance, shortest;
-	shortest = 5;
-
-	if (level % 2 == 1) {
-		for (int i = 0; i < NUM_L1_DIAMONDS; i++) {
-			diamond_x = l1_diamonds[i][0];
-			diamond_y = l1_diamonds[i][1];
-			if (get_object_at(diamond_x, diamond_y) == DIAMOND) {
-				x_diff = abs(player_x - diamond_x);
-				y_diff = abs(player_y - diamond_y);
-				distance = x_diff + y_diff;
-				if (distance < shortest) {
-					shortest = distance;
-				}
-			}
-		}
-	} else if (level % 2 == 0) {
-		for (int i = 0; i < NUM_L2_DIAMONDS; i++) {
-			diamond_x = l2_diamonds[i][0];
-			diamond_y = l2_diamonds[i][1];
-			if (get_object_at(diamond_x, diamond_y) == DIAMOND) {
-				x_diff = abs(player_x - diamond_x);
-				y_diff = abs(player_y - diamond_y);
-				distance = x_diff + y_diff;
-				if (distance < shortest) {
-					shortest = distance;
-				}
-			}
-		}
-	}
-
-	if (shortest == 4) {
-        return 750;
-    } else if (shortest == 3) {
-        return 500;
-    } else if (shortest == 2) {
-        return 250;
-    } else if (shortest == 1) {
-        return 125;
-    }
-	
-	return 0;
-}
-
-uint8_t plant_bomb(void) {
-	if (!bomb_planted) {
-		bomb_x = player_x;
-		bomb_y = player_y;
-		playing_field[bomb_x][bomb_y] = BOMB;
-		bomb_planted = 1;
-		bomb_visible = 1;
-		return 1;
-	}
-	return 0;
-}
-
-uint8_t flash_bomb(void) {
-	if (bomb_visible) {
-		update_square_colour(bomb_x, bomb_y, EMPTY_SQUARE);
-	} else {
-		update_square_colour(bomb_x, bomb_y, BOMB);
-	}
-	bomb_visible = 1 - bomb_visible;
-	return bomb_visible;
-}
-
-void detonate_bomb(void) {
-	uint8_t x_adj, y_adj, exploded;
-	playing_field[bomb_x][bomb_y] = EMPTY_SQUARE;
-	update_square_colour(bomb_x, bomb_y, EMPTY_SQUARE);
-	for (int i = 0; i < NUM_DIRECTIONS; i++) {
-		x_adj = bomb_x + directions[i][0];
-		y_adj = bomb_y + directions[i][1];
-		// if this square is in bounds, it should be exploded
-		if (in_bounds(x_adj, y_adj)) {
-			exploded = get_object_at(x_adj, y_adj);
-			if (exploded == BREAKABLE || exploded == INSPECTED
-					|| exploded == EXIT) {
-				playing_field[x_adj][y_adj] = EMPTY_SQUARE;
-				discoverable_dfs(x_adj, y_adj);
-			}
-			update_square_colour(x_adj, y_adj, EXPLOSION);
-		}
-	}
-	if (in_danger()) {
-		game_over = 1;
-	}
-	bomb_planted = 0;
-	det_x = bomb_x;
-	det_y = bomb_y;
-}
-
-void clear_explosion() {
-	uint8_t x_adj, y_adj;
-	for (int i = 0; i < NUM_DIRECTIONS; i++) {
-		x_adj = det_x + directions[i][0];
-		y_adj = det_y + directions[i][1];
-		// if this square is in bounds, it should be exploded
-		if (in_bounds(x_adj, y_adj)) {
-			update_square_colour(x_adj, y_adj, get_object_at(x_adj, y_adj));
-		}
-	}
-}
-
-uint8_t in_danger(void) {
-	uint8_t x_adj, y_adj;
-	if (bomb_x == player_x && bomb_y == player_y) {
-		return 1;
-	}
-	for (int i = 0; i < NUM_DIRECTIONS; i++) {
-		x_adj = bomb_x + directions[i][0];
-		y_adj = bomb_y + directions[i][1];
-		// if the player is next to the bomb, they are in danger
-		if (x_adj == player_x && y_adj == player_y) {
-			return 1;
-		}
-	}
-	return 0;
-}
-
-uint32_t pause_game(void) {
-	move_terminal_cursor(PAUSED_X, PAUSED_Y);
-	printf_P(PSTR("Game paused"));
-	move_terminal_cursor(0, 0);
-	return get_current_time();
-}
-
-void unpause_game(uint32_t pause_time) {
-	move_terminal_cursor(PAUSED_X, PAUSED_Y);
-	clear_to_end_of_line();
-	move_terminal_cursor(0, 0);
-	set_current_time(pause_time);
-}
-
-void finish_level(void) {
-	initialise_game(level, score);
-}
-
-uint8_t is_game_over(void) {
-	// initially the game never ends
-	return game_over;
-}
-
-/*
- * given an (x,y) coordinate, perform a depth first search to make any
- * squares reachable from here visible. If a wall is broken at a position
- * (x,y), this function should be called with coordinates (x,y)
- * YOU SHOULD NOT NEED TO MODIFY THIS FUNCTION
- */
-void discoverable_dfs(uint8_t x, uint8_t y) {
-	uint8_t x_adj, y_adj, object_here;
-	// set the current square to be visible and update display
-	visible[x][y] = 1;
-	object_here = get_object_at(x, y);
-	update_square_colour(x, y, object_here);
-	// we can continue exploring from this square if it is empty
-	if (object_here == EMPTY_SQUARE || object_here == DIAMOND || object_here == EXIT) {
-		// consider all 4 adjacent square
-		for (int i = 0; i < NUM_DIRECTIONS; i++) {
-			x_adj = x + directions[i][0];
-			y_adj = y + directions[i][1];
-			// if this square is not visible yet, it should be explored
-			if (in_bounds(x_adj, y_adj) && !visible[x_adj][y_adj]) {
-				// this recursive call implements a depth first search
-				// the visible array ensures termination
-				discoverable_dfs(x_adj, y_adj);
-			}
-		}
-	}
-}
\ No newline at end of file
+/*
+ * game.c
+ *
+ * Contains functions relating to the play of Diamond Miners
+ *
+ * Author: Luke Kamols
+ */ 
+
+
+#include "game.h"
+#include "display.h"
+#include "terminalio.h"
+#include "gameclock.h"
+#include "profile.h"
+#include "levels.h"
+#include "save.h"
+#include "marquee.h"
+#include "render.h"
+#include "trace.h"
+#include "timer0.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <avr/pgmspace.h>
+
+#define PLAYER_START_X  0
+#define PLAYER_START_Y  0
+#define FACING_START_X  1
+#define FACING_START_Y  0
+#define CHEAT_START     0
+
+// how long the player direction indicator is shown and hidden for
+#define FACING_FLASH_DELAY	500
+
+// how long a bomb is first shown and hidden for, and how much quicker
+// it flashes each time it is shown
+#define BOMB_FLASH_DELAY	350
+#define BOMB_FLASH_SPEEDUP	75
+
+// the steps of moving on to the next level, see update_level_change()
+#define LEVEL_PLAYING	0
+#define LEVEL_FINISHED	1 // the player has left by the exit
+#define LEVEL_TALLY		2 // the level's score is scrolling across the display
+#define LEVEL_LOAD		3 // the next level is set up
+#define LEVEL_REVEAL	4 // the next level is shown
+
+#define BOMB_UNUSED		0
+#define BOMB_LIT		1 // waiting to explode
+#define BOMB_EXPLODED	2 // explosion still being displayed
+
+typedef struct {
+	uint8_t x, y;
+	uint8_t state;
+	uint8_t visible;
+	uint16_t flash_delay; // 0 once the bomb has stopped flashing
+	uint32_t fuse_time; // when the bomb explodes
+	uint32_t next_flash;
+	uint32_t clear_time; // when the explosion is removed from the display
+} Bomb;
+
+#define NUM_DIRECTIONS 4
+static const uint8_t directions[NUM_DIRECTIONS][2] = {{0,1}, {0,-1}, {1,0}, {-1,0}};
+
+// how close the player may get to the edge of the display before the 
+// camera scrolls to follow them
+#define CAMERA_MARGIN_X	4
+#define CAMERA_MARGIN_Y	2
+
+// the most squares discoverable_dfs keeps waiting to be explored
+#define DFS_STACK_SIZE	32
+
+// the object each terrain value is shown as
+static const uint8_t terrain_objects[4] PROGMEM = 
+		{EMPTY_SQUARE, BREAKABLE, UNBREAKABLE, INSPECTED};
+
+// variables for the current state of the game
+// the terrain at each square, packed 2 bits per square as in levels.h
+uint8_t terrain[WORLD_MAX_WIDTH * WORLD_MAX_HEIGHT / 4];
+// whether each square is currently visible, packed 1 bit per square
+uint8_t visible[WORLD_MAX_WIDTH * WORLD_MAX_HEIGHT / 8];
+uint8_t world_width, world_height;
+const Level* level_data; // the layout of the current level, in flash
+uint16_t diamonds_collected; // bit i is set once diamond i is collected
+uint8_t exit_present;
+uint8_t player_x, player_y;
+uint8_t camera_x, camera_y; // the square shown at the bottom left of the display
+uint8_t facing_x, facing_y, facing_visible;
+uint32_t last_facing_flash_time;
+Bomb bombs[MAX_BOMBS];
+uint8_t bombs_lit; // number of bombs waiting to explode
+uint32_t next_bomb_event; // earliest time any bomb needs attention
+uint8_t cheating;
+uint8_t level;
+uint8_t total_score = 0;
+uint8_t score;
+uint8_t diamonds_available;
+uint8_t game_over;
+uint8_t level_state;
+uint32_t last_level_step_time;
+
+// function prototypes for this file
+void discoverable_dfs(uint8_t x, uint8_t y);
+void initialise_terminal_display(void);
+void initialise_game_display(void);
+void initialise_game_state(uint8_t level, uint8_t score);
+void collect_diamond(uint8_t x, uint8_t y);
+static uint8_t in_danger_from(Bomb* bomb);
+static uint8_t lit_bomb_at(uint8_t x, uint8_t y);
+static uint8_t camera_target(uint8_t position, uint8_t camera, uint8_t view,
+		uint8_t margin, uint8_t world);
+static void update_camera(void);
+static void load_level(void);
+static void light_bomb(Bomb* bomb, uint8_t x, uint8_t y);
+
+/*
+ * initialise the game state, sets up the playing field, visibility
+ * the player and the player direction indicator
+ */
+void initialise_game_state(uint8_t current_level, uint8_t current_score) {
+	// initialise the player position and the facing position
+	player_x = PLAYER_START_X;
+	player_y = PLAYER_START_Y;
+	facing_x = FACING_START_X;
+	facing_y = FACING_START_Y;
+	facing_visible = 1;
+	last_facing_flash_time = get_game_time();
+	for (uint8_t i = 0; i < MAX_BOMBS; i++) {
+		bombs[i].state = BOMB_UNUSED;
+	}
+	bombs_lit = 0;
+	next_bomb_event = UINT32_MAX;
+    cheating = CHEAT_START;
+	level = current_level + 1;
+	if (current_level == 0) {
+		// this is a new game
+		total_score = 0;
+	}
+	total_score += current_score;
+	score = 0;
+	game_over = 0;
+	level_state = LEVEL_PLAYING;
+	
+	load_level();
+	TRACE_EVENT(TRACE_LEVEL, level);
+	diamonds_collected = 0;
+	exit_present = 1;
+	
+	// copy the terrain out of flash, it is stored in the same format
+	uint16_t terrain_size = (uint16_t)world_width * world_height / 4;
+	memcpy_P(terrain, (const uint8_t*)pgm_read_ptr(&level_data->terrain), 
+			terrain_size);
+	// and what can be seen from the start square, which is worked out
+	// when the levels are compiled (see host/levelc.c)
+	memcpy_P(visible, (const uint8_t*)pgm_read_ptr(&level_data->visible),
+			terrain_size / 2);
+	save_mark_all();
+}
+
+// looks up the layout of the current level
+static void load_level(void) {
+	// levels repeat once they have all been played
+	level_data = &levels[(level - 1) % NUM_LEVELS];
+	world_width = pgm_read_byte(&level_data->width);
+	world_height = pgm_read_byte(&level_data->height);
+	diamonds_available = pgm_read_byte(&level_data->num_diamonds);
+}
+
+/*
+ * initialise the display of the game, shows the player and the player
+ * direction indicator. 
+ */
+void initialise_game_display(void) {
+	camera_x = camera_target(player_x, 0, WIDTH, CAMERA_MARGIN_X, world_width);
+	camera_y = camera_target(player_y, 0, HEIGHT, CAMERA_MARGIN_Y, world_height);
+	// the squares the player can see came with the level, so the whole
+	// display is drawn in one go
+	render_redraw(camera_x, camera_y);
+}
+
+void initialise_terminal_display(void) {
+	// anything still waiting to be shown is out of date
+	render_flush();
+	clear_terminal();
+	move_terminal_cursor(LEVEL_X, LEVEL_Y);
+	PROFILE_CALL(PROFILE_PRINTF, printf_P(PSTR("Level: %d"), level));
+	move_terminal_cursor(SCORE_X, SCORE_Y);
+	PROFILE_CALL(PROFILE_PRINTF, printf_P(PSTR("Diamonds Collected: %d of %d"), 
+			score, diamonds_available));
+	move_terminal_cursor(CHEAT_X, CHEAT_Y);
+	PROFILE_CALL(PROFILE_PRINTF, printf_P(PSTR("Cheat Mode: Disabled")));
+	update_speed(game_clock_get_scale());
+	move_terminal_cursor(0, 0); // gets cursor out of the way
+}
+
+void initialise_game(uint8_t level, uint8_t score) {
+	// to initialise the game, we need to initialise the state (variables),
+	// the display and the terminal
+	initialise_game_state(level, score);
+	initialise_game_display();
+	initialise_terminal_display();
+	render_resync();
+}
+
+uint8_t in_bounds(uint8_t x, uint8_t y) {
+	// a square is in bounds if 0 <= x < world_width && 0 <= y < world_height
+	// coordinates left of or below the world wrap around to large values
+	return x < world_width && y < world_height;
+}
+
+// returns the index of square (x,y) in the packed terrain and visible arrays
+static inline uint16_t square_index(uint8_t x, uint8_t y) {
+	return (uint16_t)y * world_width + x;
+}
+
+static uint8_t get_terrain(uint8_t x, uint8_t y) {
+	uint16_t i = square_index(x, y);
+	return (terrain[i >> 2] >> ((i & 3) << 1)) & 3;
+}
+
+static void set_terrain(uint8_t x, uint8_t y, uint8_t value) {
+	uint16_t i = square_index(x, y);
+	uint8_t shift = (i & 3) << 1;
+	terrain[i >> 2] = (terrain[i >> 2] & ~(3 << shift)) | (value << shift);
+	save_mark_dirty(SAVE_TERRAIN_OFFSET + (i >> 2));
+}
+
+uint8_t is_visible(uint8_t x, uint8_t y) {
+	uint16_t i = square_index(x, y);
+	return (visible[i >> 3] >> (i & 7)) & 1;
+}
+
+static void set_visible(uint8_t x, uint8_t y) {
+	uint16_t i = square_index(x, y);
+	visible[i >> 3] |= 1 << (i & 7);
+	save_mark_dirty(SAVE_VISIBLE_OFFSET + (i >> 3));
+}
+
+// returns the index of the diamond which starts at (x,y), or MAX_DIAMONDS
+// if no diamond starts there
+static uint8_t diamond_at(uint8_t x, uint8_t y) {
+	for (uint8_t i = 0; i < diamonds_available; i++) {
+		if (pgm_read_byte(&level_data->diamonds[i][0]) == x 
+				&& pgm_read_byte(&level_data->diamonds[i][1]) == y) {
+			return i;
+		}
+	}
+	return MAX_DIAMONDS;
+}
+
+uint8_t get_object_at(uint8_t x, uint8_t y) {
+	// check the bounds, anything outside the bounds
+	// will be considered an unbreakable wall
+	if (!in_bounds(x,y)) {
+		return UNBREAKABLE;
+	}
+	uint8_t object = pgm_read_byte(&terrain_objects[get_terrain(x, y)]);
+	if (object != EMPTY_SQUARE) {
+		return object;
+	}
+	// bombs, the exit and diamonds all sit on empty terrain
+	if (lit_bomb_at(x, y) != MAX_BOMBS) {
+		return BOMB;
+	}
+	if (exit_present && x == pgm_read_byte(&level_data->exit_x) 
+			&& y == pgm_read_byte(&level_data->exit_y)) {
+		return EXIT;
+	}
+	uint8_t diamond = diamond_at(x, y);
+	if (diamond != MAX_DIAMONDS && !(diamonds_collected & (1 << diamond))) {
+		return DIAMOND;
+	}
+	return EMPTY_SQUARE;
+}
+
+void set_object_at(uint8_t x, uint8_t y, uint8_t object) {
+	if (!in_bounds(x, y)) {
+		return;
+	}
+	switch (object) {
+		case BREAKABLE:
+			set_terrain(x, y, TERRAIN_BREAKABLE);
+			break;
+		case UNBREAKABLE:
+			set_terrain(x, y, TERRAIN_UNBREAKABLE);
+			break;
+		case INSPECTED:
+			set_terrain(x, y, TERRAIN_INSPECTED);
+			break;
+		case EMPTY_SQUARE: {
+			set_terrain(x, y, TERRAIN_EMPTY);
+			// clearing a square also removes the exit or diamond on it
+			if (x == pgm_read_byte(&level_data->exit_x) 
+					&& y == pgm_read_byte(&level_data->exit_y)) {
+				exit_present = 0;
+			}
+			uint8_t diamond = diamond_at(x, y);
+			if (diamond != MAX_DIAMONDS) {
+				diamonds_collected |= 1 << diamond;
+			}
+			break;
+		}
+		default:
+			// bombs are tracked by the bombs array, and nothing else can 
+			// be placed
+			return;
+	}
+	render_field(x, y, get_object_at(x, y));
+}
+
+uint8_t get_display_object(uint8_t x, uint8_t y) {
+	if (x == player_x && y == player_y) {
+		return PLAYER;
+	}
+	if (x == facing_x && y == facing_y && facing_visible) {
+		return FACING;
+	}
+	for (uint8_t i = 0; i < MAX_BOMBS; i++) {
+		if (bombs[i].state == BOMB_EXPLODED 
+				&& abs(bombs[i].x - x) + abs(bombs[i].y - y) <= 1) {
+			return EXPLOSION;
+		}
+	}
+	if (!in_bounds(x, y) || !is_visible(x, y)) {
+		return UNDISCOVERED;
+	}
+	uint8_t bomb = lit_bomb_at(x, y);
+	if (bomb != MAX_BOMBS && !bombs[bomb].visible) {
+		// the bomb is flashed off
+		return EMPTY_SQUARE;
+	}
+	return get_object_at(x, y);
+}
+
+// returns where the camera should be along one axis to keep 'position' 
+// at least 'margin' squares inside a view 'view' squares long, moving
+// it as little as possible from 'camera' and keeping it inside a world 
+// 'world' squares long
+static uint8_t camera_target(uint8_t position, uint8_t camera, uint8_t view,
+		uint8_t margin, uint8_t world) {
+	int16_t target = camera;
+	if (position < camera + margin) {
+		target = position - margin;
+	} else if (position + margin >= camera + view) {
+		target = position + margin + 1 - view;
+	}
+	if (target > world - view) {
+		target = world - view;
+	}
+	if (target < 0) {
+		target = 0;
+	}
+	return target;
+}
+
+// scrolls the display, a square at a time, until the player is far 
+// enough from its edges
+static void update_camera(void) {
+	uint8_t target_x = camera_target(player_x, camera_x, WIDTH, 
+			CAMERA_MARGIN_X, world_width);
+	uint8_t target_y = camera_target(player_y, camera_y, HEIGHT, 
+			CAMERA_MARGIN_Y, world_height);
+	while (camera_x != target_x || camera_y != target_y) {
+		int8_t dx = (camera_x < target_x) - (camera_x > target_x);
+		int8_t dy = (camera_y < target_y) - (camera_y > target_y);
+		camera_x += dx;
+		camera_y += dy;
+		render_scroll(dx, dy);
+	}
+}
+
+void flash_facing(void) {
+	// only flash the facing cursor if it is in bounds
+	if (in_bounds(facing_x, facing_y)) {
+		if (facing_visible) {
+			// we need to flash the facing cursor off, it should be replaced by
+			// the colour of the piece which is at that location
+			uint8_t piece_at_cursor = get_object_at(facing_x, facing_y);
+			render_square(facing_x, facing_y, piece_at_cursor);
+		
+		} else {
+			// we need to flash the facing cursor on
+			render_square(facing_x, facing_y, FACING);
+		}
+		facing_visible = 1 - facing_visible;
+	}
+}
+
+// removes the display of the player and the player direction indicator
+// and replaces them each with whatever else is at those locations
+static void erase_player(void) {
+    render_square(player_x, player_y, get_object_at(player_x, player_y));
+	render_square(facing_x, facing_y, get_object_at(facing_x, facing_y));
+}
+
+// displays the player and the player direction indicator where they now
+// are
+static void show_player(void) {
+	// keep the player on the display
+	update_camera();
+
+    // display the player at the new location
+    render_square(player_x, player_y, PLAYER);
+	render_player(player_x, player_y);
+	TRACE_EVENT(TRACE_MOVE, TRACE_XY(player_x, player_y));
+
+    // restart player direction indicator flashing cycle
+    facing_visible = 1;
+    flash_facing();
+}
+
+// moves the player one square, without displaying anything but the
+// score, returns 1 if the player moved or stepped out of the level
+static uint8_t step_player(int8_t dx, int8_t dy) {
+	if (level_state != LEVEL_PLAYING) {
+		return 0;
+	}
+	if (get_object_at(player_x, player_y) == EXIT && dx == 1 && dy == 0
+			&& score == diamonds_available) {
+		// the player steps out of the level, the next one is set up
+		// from the game loop (see update_level_change())
+		level_state = LEVEL_FINISHED;
+		return 1;
+	}
+
+	// if the player can move, update the position of the player
+	uint8_t valid = 0;
+    uint8_t dest_object = get_object_at(player_x + dx, player_y + dy);
+    if (object_flags(dest_object) & OBJECT_WALKABLE) {
+        player_x += dx;
+        player_y += dy;
+		valid = 1;
+    }
+
+    // update direction indicator
+    facing_x = player_x + dx;
+	facing_y = player_y + dy;
+
+	if (object_flags(get_object_at(player_x, player_y)) & OBJECT_COLLECTABLE) {
+		collect_diamond(player_x, player_y);
+	}
+	return valid;
+}
+
+uint8_t move_player(int8_t dx, int8_t dy) {
+	if (level_state != LEVEL_PLAYING) {
+		return 0;
+	}
+	PROFILE_ENTER(PROFILE_MOVE);
+	erase_player();
+	uint8_t valid = step_player(dx, dy);
+	if (level_state == LEVEL_PLAYING) {
+		show_player();
+	}
+	PROFILE_EXIT(PROFILE_MOVE);
+	return valid;
+}
+
+uint8_t move_player_path(int8_t dx, int8_t dy) {
+	if (dx == 0 || dy == 0) {
+		return move_player(dx, dy);
+	}
+	if (level_state != LEVEL_PLAYING) {
+		return 0;
+	}
+	PROFILE_ENTER(PROFILE_MOVE);
+	erase_player();
+	uint8_t start_score = score;
+	
+	// up or down first, then across, and if up or down was blocked it is
+	// tried again from across (so the player faces the way they went last)
+	uint8_t moved = step_player(0, dy);
+	uint8_t first_successful = moved;
+	// the square passed over on the way, if there is one
+	uint8_t via_x = player_x;
+	uint8_t via_y = player_y;
+	uint8_t via_score = score;
+	moved += step_player(dx, 0);
+	if (!first_successful) {
+		via_x = player_x;
+		via_y = player_y;
+		via_score = score;
+		moved += step_player(0, dy);
+	}
+	
+	if (level_state == LEVEL_PLAYING) {
+		if ((via_x != player_x || via_y != player_y) 
+				&& via_score != start_score) {
+			// the diamond collected on the way is still displayed
+			render_square(via_x, via_y, get_object_at(via_x, via_y));
+		}
+		show_player();
+	}
+	PROFILE_EXIT(PROFILE_MOVE);
+	return moved;
+}
+
+void inspect_facing(void) {
+	if (level_state != LEVEL_PLAYING) {
+		return;
+	}
+	uint8_t inspected = get_object_at(facing_x, facing_y);
+    if (cheating) {
+        if (object_flags(inspected) & OBJECT_BREAKABLE) {
+			set_object_at(facing_x, facing_y, EMPTY_SQUARE);
+			discoverable_dfs(facing_x, facing_y);
+        }
+	} else {
+		if (object_flags(inspected) & OBJECT_INSPECTABLE) {
+			set_object_at(facing_x, facing_y, INSPECTED);
+			set_visible(facing_x, facing_y);
+			render_square(facing_x, facing_y, INSPECTED);
+        }
+    }
+}
+
+void toggle_cheat(void) {
+    cheating = 1 - cheating;
+	render_cheat(cheating);
+}
+
+// checks if the player is on a diamond. If they are, remove the
+// diamond, increment their score and update terminal "scoreboard"
+void collect_diamond(uint8_t x, uint8_t y) {
+    set_object_at(x, y, EMPTY_SQUARE);
+    score++;
+	render_score(score, diamonds_available);
+}
+
+uint32_t detect_diamond() {
+    uint8_t diamond_x, diamond_y, x_diff, y_diff, distance, shortest;
+	shortest = 5;
+
+	for (uint8_t i = 0; i < diamonds_available; i++) {
+		if (diamonds_collected & (1 << i)) {
+			continue;
+		}
+		diamond_x = pgm_read_byte(&level_data->diamonds[i][0]);
+		diamond_y = pgm_read_byte(&level_data->diamonds[i][1]);
+		x_diff = abs(player_x - diamond_x);
+		y_diff = abs(player_y - diamond_y);
+		distance = x_diff + y_diff;
+		if (distance < shortest) {
+			shortest = distance;
+		}
+	}
+
+	if (shortest == 4) {
+        return 750;
+    } else if (shortest == 3) {
+        return 500;
+    } else if (shortest == 2) {
+        return 250;
+    } else if (shortest == 1) {
+        return 125;
+    }
+	
+	return 0;
+}
+
+// returns the time at which a bomb next needs to be updated
+static uint32_t bomb_next_event(Bomb* bomb) {
+	if (bomb->state == BOMB_EXPLODED) {
+		return bomb->clear_time;
+	}
+	if (bomb->flash_delay && bomb->next_flash < bomb->fuse_time) {
+		return bomb->next_flash;
+	}
+	return bomb->fuse_time;
+}
+
+// recalculates next_bomb_event from all bombs in play
+static void update_next_bomb_event(void) {
+	next_bomb_event = UINT32_MAX;
+	for (uint8_t i = 0; i < MAX_BOMBS; i++) {
+		if (bombs[i].state != BOMB_UNUSED) {
+			uint32_t event = bomb_next_event(&bombs[i]);
+			if (event < next_bomb_event) {
+				next_bomb_event = event;
+			}
+		}
+	}
+}
+
+// returns the index of the lit bomb at (x,y), or MAX_BOMBS if there isn't one
+static uint8_t lit_bomb_at(uint8_t x, uint8_t y) {
+	for (uint8_t i = 0; i < MAX_BOMBS; i++) {
+		if (bombs[i].state == BOMB_LIT && bombs[i].x == x && bombs[i].y == y) {
+			return i;
+		}
+	}
+	return MAX_BOMBS;
+}
+
+uint8_t plant_bomb(uint32_t current_time) {
+	if (level_state != LEVEL_PLAYING) {
+		return 0;
+	}
+	if (get_object_at(player_x, player_y) == BOMB) {
+		// there is already a bomb here
+		return 0;
+	}
+	for (uint8_t i = 0; i < MAX_BOMBS; i++) {
+		Bomb* bomb = &bombs[i];
+		if (bomb->state == BOMB_UNUSED) {
+			light_bomb(bomb, player_x, player_y);
+			TRACE_EVENT(TRACE_BOMB, TRACE_XY(player_x, player_y));
+			bomb->fuse_time = current_time + BOMB_FUSE_TIME;
+			// the first flash happens straight away
+			bomb->next_flash = current_time;
+			render_field(bomb->x, bomb->y, BOMB);
+			update_next_bomb_event();
+			return 1;
+		}
+	}
+	return 0;
+}
+
+// sets up an unused bomb as lit at (x,y), the caller sets its times
+static void light_bomb(Bomb* bomb, uint8_t x, uint8_t y) {
+	bomb->x = x;
+	bomb->y = y;
+	bomb->state = BOMB_LIT;
+	bomb->visible = 1;
+	bomb->flash_delay = BOMB_FLASH_DELAY;
+	bombs_lit++;
+}
+
+uint8_t bombs_in_play(void) {
+	return bombs_lit;
+}
+
+// toggles whether a bomb is shown without drawing it, the bomb flashes 
+// faster each time it is shown until it is left on
+static void next_bomb_flash(Bomb* bomb) {
+	bomb->visible = 1 - bomb->visible;
+	if (bomb->visible) {
+		if (bomb->flash_delay < BOMB_FLASH_SPEEDUP) {
+			// stop flashing, leaving the bomb displayed
+			bomb->flash_delay = 0;
+		} else {
+			bomb->flash_delay -= BOMB_FLASH_SPEEDUP;
+		}
+	}
+	bomb->next_flash += bomb->flash_delay;
+}
+
+static void flash_bomb(Bomb* bomb) {
+	if (bomb->visible) {
+		render_square(bomb->x, bomb->y, EMPTY_SQUARE);
+	} else {
+		render_square(bomb->x, bomb->y, BOMB);
+	}
+	next_bomb_flash(bomb);
+}
+
+// explodes all bombs whose fuse has run out, along with any bombs their
+// explosions reach, then draws all of the explosions at once
+static void detonate_bombs(uint32_t current_time) {
+	// bombs waiting to be detonated
+	uint8_t queue[MAX_BOMBS];
+	uint8_t queue_length = 0;
+	// squares the explosions reached - each bomb's own square and those
+	// next to it
+	uint8_t blast_x[MAX_BOMBS * (NUM_DIRECTIONS + 1)];
+	uint8_t blast_y[MAX_BOMBS * (NUM_DIRECTIONS + 1)];
+	uint8_t blast_length = 0;
+	uint8_t x_adj, y_adj, exploded;
+	
+	for (uint8_t i = 0; i < MAX_BOMBS; i++) {
+		if (bombs[i].state == BOMB_LIT && current_time >= bombs[i].fuse_time) {
+			bombs[i].state = BOMB_EXPLODED;
+			queue[queue_length++] = i;
+		}
+	}
+	
+	// a bomb's explosion may reach more bombs, which are added to the end 
+	// of the queue
+	for (uint8_t q = 0; q < queue_length; q++) {
+		Bomb* bomb = &bombs[queue[q]];
+		bomb->clear_time = current_time + EXPLOSION_DELAY;
+		TRACE_EVENT(TRACE_EXPLODE, TRACE_XY(bomb->x, bomb->y));
+		bombs_lit--;
+		if (in_danger_from(bomb)) {
+			if (!game_over) {
+				TRACE_EVENT(TRACE_GAME_OVER, total_score + score);
+			}
+			game_over = 1;
+			render_game_over();
+		}
+		set_object_at(bomb->x, bomb->y, EMPTY_SQUARE);
+		blast_x[blast_length] = bomb->x;
+		blast_y[blast_length++] = bomb->y;
+		for (int i = 0; i < NUM_DIRECTIONS; i++) {
+			x_adj = bomb->x + directions[i][0];
+			y_adj = bomb->y + directions[i][1];
+			// if this square is in bounds, it should be exploded
+			if (in_bounds(x_adj, y_adj)) {
+				exploded = get_object_at(x_adj, y_adj);
+				if (object_flags(exploded) & OBJECT_DESTRUCTIBLE) {
+					set_object_at(x_adj, y_adj, EMPTY_SQUARE);
+					discoverable_dfs(x_adj, y_adj);
+				}
+				uint8_t chained = lit_bomb_at(x_adj, y_adj);
+				if (chained != MAX_BOMBS) {
+					bombs[chained].state = BOMB_EXPLODED;
+					queue[queue_length++] = chained;
+				}
+				blast_x[blast_length] = x_adj;
+				blast_y[blast_length++] = y_adj;
+			}
+		}
+	}
+	
+	for (uint8_t i = 0; i < blast_length; i++) {
+		// skip squares an earlier explosion has already drawn
+		uint8_t drawn = 0;
+		for (uint8_t j = 0; j < i && !drawn; j++) {
+			drawn = blast_x[j] == blast_x[i] && blast_y[j] == blast_y[i];
+		}
+		if (!drawn) {
+			render_square(blast_x[i], blast_y[i], EXPLOSION);
+		}
+	}
+}
+
+// redraws the squares an explosion covered and frees up its bomb
+static void clear_explosion(Bomb* bomb) {
+	uint8_t x_adj, y_adj;
+	// squares still covered by another explosion, and the player if they
+	// walked into the blast, are left showing
+	bomb->state = BOMB_UNUSED;
+	render_square(bomb->x, bomb->y, get_display_object(bomb->x, bomb->y));
+	for (int i = 0; i < NUM_DIRECTIONS; i++) {
+		x_adj = bomb->x + directions[i][0];
+		y_adj = bomb->y + directions[i][1];
+		if (in_bounds(x_adj, y_adj)) {
+			render_square(x_adj, y_adj, get_display_object(x_adj, y_adj));
+		}
+	}
+}
+
+void update_bombs(uint32_t current_time) {
+	if (current_time < next_bomb_event) {
+		// nothing is due yet
+		return;
+	}
+	uint8_t detonating = 0;
+	for (uint8_t i = 0; i < MAX_BOMBS; i++) {
+		Bomb* bomb = &bombs[i];
+		if (bomb->state == BOMB_EXPLODED && current_time >= bomb->clear_time) {
+			clear_explosion(bomb);
+		} else if (bomb->state == BOMB_LIT) {
+			if (current_time >= bomb->fuse_time) {
+				detonating = 1;
+			} else if (bomb->flash_delay && current_time >= bomb->next_flash) {
+				flash_bomb(bomb);
+			}
+		}
+	}
+	if (detonating) {
+		detonate_bombs(current_time);
+	}
+	update_next_bomb_event();
+}
+
+// returns 1 if the player is standing on or next to the given bomb
+static uint8_t in_danger_from(Bomb* bomb) {
+	uint8_t x_adj, y_adj;
+	if (bomb->x == player_x && bomb->y == player_y) {
+		return 1;
+	}
+	for (int i = 0; i < NUM_DIRECTIONS; i++) {
+		x_adj = bomb->x + directions[i][0];
+		y_adj = bomb->y + directions[i][1];
+		// if the player is next to the bomb, they are in danger
+		if (x_adj == player_x && y_adj == player_y) {
+			return 1;
+		}
+	}
+	return 0;
+}
+
+uint8_t in_danger(void) {
+	for (uint8_t i = 0; i < MAX_BOMBS; i++) {
+		if (bombs[i].state == BOMB_LIT && in_danger_from(&bombs[i])) {
+			return 1;
+		}
+	}
+	return 0;
+}
+
+uint8_t changing_level(void) {
+	return level_state != LEVEL_PLAYING;
+}
+
+// moves on to the next level by one step, each step returns to the game
+// loop so that the stack never holds more than one of them
+static void update_level_change(uint32_t current_time) {
+	char message[MARQUEE_MAX_LENGTH + 1];
+	switch (level_state) {
+		case LEVEL_FINISHED:
+			// bombs left behind are thrown away with the level
+			for (uint8_t i = 0; i < MAX_BOMBS; i++) {
+				bombs[i].state = BOMB_UNUSED;
+			}
+			bombs_lit = 0;
+			next_bomb_event = UINT32_MAX;
+			// the banner scrolls over the display as it is now
+			render_flush();
+			snprintf_P(message, sizeof(message), PSTR("LEVEL %u " 
+					SPRITE_DIAMOND " %u"), level, score);
+			marquee_start(message, COLOUR_GREEN);
+			last_level_step_time = current_time;
+			level_state = LEVEL_TALLY;
+			break;
+		case LEVEL_TALLY:
+			if (TIME_SINCE(current_time, last_level_step_time) 
+					>= MARQUEE_STEP_DELAY) {
+				last_level_step_time = current_time;
+				if (marquee_step()) {
+					level_state = LEVEL_LOAD;
+				}
+			}
+			break;
+		case LEVEL_LOAD:
+			// this adds the level's score to the total
+			initialise_game_state(level, score);
+			initialise_terminal_display();
+			level_state = LEVEL_REVEAL;
+			break;
+		case LEVEL_REVEAL:
+			initialise_game_display();
+			render_resync();
+			level_state = LEVEL_PLAYING;
+			break;
+	}
+}
+
+void update_game(uint32_t current_time) {
+	if (level_state != LEVEL_PLAYING) {
+		PROFILE_ENTER(PROFILE_LEVEL);
+		update_level_change(current_time);
+		PROFILE_EXIT(PROFILE_LEVEL);
+		return;
+	}
+	if (TIME_SINCE(current_time, last_facing_flash_time) 
+			>= FACING_FLASH_DELAY) {
+		// 500ms (0.5 second) has passed since the last time we
+		// flashed the cursor, so flash the cursor
+		flash_facing();
+		
+		// Update the most recent time the cursor was flashed
+		last_facing_flash_time = current_time;
+	}
+	update_bombs(current_time);
+}
+
+void pause_game(void) {
+	move_terminal_cursor(PAUSED_X, PAUSED_Y);
+	PROFILE_CALL(PROFILE_PRINTF, printf_P(PSTR("Game paused")));
+	move_terminal_cursor(0, 0);
+	game_clock_pause();
+}
+
+void unpause_game(void) {
+	move_terminal_cursor(PAUSED_X, PAUSED_Y);
+	clear_to_end_of_line();
+	move_terminal_cursor(0, 0);
+	game_clock_resume();
+}
+
+void change_game_speed(int8_t faster) {
+	uint8_t scale = game_clock_get_scale();
+	if (faster) {
+		game_clock_set_scale(scale * 2);
+	} else {
+		game_clock_set_scale(scale / 2);
+	}
+	update_speed(game_clock_get_scale());
+}
+
+uint8_t is_game_over(void) {
+	// initially the game never ends
+	return game_over;
+}
+
+uint8_t get_total_score(void) {
+	return total_score + score;
+}
+
+uint8_t get_level(void) {
+	return level;
+}
+
+uint8_t get_score(void) {
+	return score;
+}
+
+uint8_t get_diamonds_available(void) {
+	return diamonds_available;
+}
+
+uint8_t get_world_width(void) {
+	return world_width;
+}
+
+uint8_t get_world_height(void) {
+	return world_height;
+}
+
+uint8_t get_player_x(void) {
+	return player_x;
+}
+
+uint8_t get_player_y(void) {
+	return player_y;
+}
+
+uint8_t get_diamond(uint8_t i, uint8_t* x, uint8_t* y) {
+	*x = pgm_read_byte(&level_data->diamonds[i][0]);
+	*y = pgm_read_byte(&level_data->diamonds[i][1]);
+	return !(diamonds_collected & (1 << i));
+}
+
+uint8_t get_exit(uint8_t* x, uint8_t* y) {
+	*x = pgm_read_byte(&level_data->exit_x);
+	*y = pgm_read_byte(&level_data->exit_y);
+	return exit_present;
+}
+
+uint8_t* get_terrain_data(void) {
+	return terrain;
+}
+
+uint8_t* get_visible_data(void) {
+	return visible;
+}
+
+void get_saved_game(SavedGame* saved) {
+	uint32_t current_time = get_game_time();
+	saved->level = level;
+	saved->total_score = total_score;
+	saved->score = score;
+	saved->cheating = cheating;
+	saved->player_x = player_x;
+	saved->player_y = player_y;
+	saved->facing_x = facing_x;
+	saved->facing_y = facing_y;
+	saved->diamonds_collected = diamonds_collected;
+	saved->exit_present = exit_present;
+	for (uint8_t i = 0; i < MAX_BOMBS; i++) {
+		Bomb* bomb = &bombs[i];
+		saved->bomb_x[i] = bomb->x;
+		saved->bomb_y[i] = bomb->y;
+		if (bomb->state != BOMB_LIT) {
+			// explosions have already changed the playing field, so
+			// only lit bombs are kept
+			saved->bomb_age[i] = NO_BOMB;
+		} else if (current_time >= bomb->fuse_time) {
+			saved->bomb_age[i] = BOMB_FUSE_TIME;
+		} else {
+			saved->bomb_age[i] = BOMB_FUSE_TIME 
+					- (uint16_t)(bomb->fuse_time - current_time);
+		}
+	}
+}
+
+void restore_saved_game(const SavedGame* saved) {
+	uint32_t current_time = get_game_time();
+	level = saved->level;
+	total_score = saved->total_score;
+	score = saved->score;
+	cheating = saved->cheating;
+	player_x = saved->player_x;
+	player_y = saved->player_y;
+	facing_x = saved->facing_x;
+	facing_y = saved->facing_y;
+	facing_visible = 1;
+	last_facing_flash_time = current_time;
+	diamonds_collected = saved->diamonds_collected;
+	exit_present = saved->exit_present;
+	game_over = 0;
+	level_state = LEVEL_PLAYING;
+	load_level();
+	
+	bombs_lit = 0;
+	for (uint8_t i = 0; i < MAX_BOMBS; i++) {
+		Bomb* bomb = &bombs[i];
+		uint16_t age = saved->bomb_age[i];
+		bomb->state = BOMB_UNUSED;
+		if (age == NO_BOMB) {
+			continue;
+		}
+		if (age > BOMB_FUSE_TIME) {
+			age = BOMB_FUSE_TIME;
+		}
+		light_bomb(bomb, saved->bomb_x[i], saved->bomb_y[i]);
+		// run through the flashes since the bomb was planted, timed from
+		// when it was planted, then move them to the game clock
+		bomb->next_flash = 0;
+		while (bomb->flash_delay && bomb->next_flash <= age) {
+			next_bomb_flash(bomb);
+		}
+		bomb->next_flash = current_time + (bomb->next_flash - age);
+		bomb->fuse_time = current_time + (BOMB_FUSE_TIME - age);
+	}
+	update_next_bomb_event();
+}
+
+void resume_game_display(void) {
+	camera_x = camera_target(player_x, 0, WIDTH, CAMERA_MARGIN_X, world_width);
+	camera_y = camera_target(player_y, 0, HEIGHT, CAMERA_MARGIN_Y, world_height);
+	initialise_terminal_display();
+	render_redraw(camera_x, camera_y);
+	render_cheat(cheating);
+	render_resync();
+}
+
+// makes square (x,y) visible and updates the display
+// returns non-zero if visibility spreads through this square
+static uint8_t reveal_square(uint8_t x, uint8_t y) {
+	set_visible(x, y);
+	uint8_t object_here = get_object_at(x, y);
+	render_square(x, y, object_here);
+	return object_flags(object_here) & OBJECT_OPEN;
+}
+
+/*
+ * given an (x,y) coordinate, perform a depth first search to make any
+ * squares reachable from here visible. If a wall is broken at a position
+ * (x,y), this function should be called with coordinates (x,y)
+ * Squares waiting to be explored are kept on a small stack rather than 
+ * recursing, as a large open world would otherwise overflow the real
+ * stack. If that fills up, the world is swept for visible open squares 
+ * which have not been explored and the search carries on from them.
+ */
+void discoverable_dfs(uint8_t x, uint8_t y) {
+	PROFILE_ENTER(PROFILE_DFS);
+	TRACE_EVENT(TRACE_REVEAL, TRACE_XY(x, y));
+	uint8_t stack_x[DFS_STACK_SIZE], stack_y[DFS_STACK_SIZE];
+	uint8_t depth = 0;
+	uint8_t overflowed = 0;
+	uint8_t x_adj, y_adj;
+	
+	if (reveal_square(x, y)) {
+		stack_x[depth] = x;
+		stack_y[depth++] = y;
+	}
+	while (depth) {
+		x = stack_x[--depth];
+		y = stack_y[depth];
+		// consider all 4 adjacent squares
+		for (int i = 0; i < NUM_DIRECTIONS; i++) {
+			x_adj = x + directions[i][0];
+			y_adj = y + directions[i][1];
+			// if this square is not visible yet, it should be explored
+			// the visible array ensures termination
+			if (in_bounds(x_adj, y_adj) && !is_visible(x_adj, y_adj) 
+					&& reveal_square(x_adj, y_adj)) {
+				if (depth < DFS_STACK_SIZE) {
+					stack_x[depth] = x_adj;
+					stack_y[depth++] = y_adj;
+				} else {
+					overflowed = 1;
+				}
+			}
+		}
+		if (!depth && overflowed) {
+			// some open squares were revealed without being explored
+			overflowed = 0;
+			for (y = 0; y < world_height; y++) {
+				for (x = 0; x < world_width; x++) {
+					if (!is_visible(x, y) 
+							|| !(object_flags(get_object_at(x, y)) & OBJECT_OPEN)) {
+						continue;
+					}
+					uint8_t unexplored = 0;
+					for (int i = 0; i < NUM_DIRECTIONS; i++) {
+						x_adj = x + directions[i][0];
+						y_adj = y + directions[i][1];
+						if (in_bounds(x_adj, y_adj) && !is_visible(x_adj, y_adj)) {
+							unexplored = 1;
+						}
+					}
+					if (!unexplored) {
+						continue;
+					}
+					if (depth < DFS_STACK_SIZE) {
+						stack_x[depth] = x;
+						stack_y[depth++] = y;
+					} else {
+						overflowed = 1;
+					}
+				}
+			}
+		}
+	}
+	PROFILE_EXIT(PROFILE_DFS);
+}
@@ -1,106 +1,212 @@
-/*
-** game.h
-**
-** Written by Luke Kamols, Daniel Cumming
-**
-** Function prototypes for those functions available externally
-*/
-
-#ifndef GAME_H_
-#define GAME_H_
-
-#include <inttypes.h>
-
-#define BOMB_FUSE_TIME	2000
-#define EXPLOSION_DELAY	500
-#define GAME_OVER_DELAY	1000
-
-/*
- * Initialise the game, creates the internal game state and updates
- * the display of this game
- */
-void initialise_game(uint8_t level, uint8_t score);
-
-/* returns which object is located at position (x,y)
- * the value returned will be EMPTY_SQUARE, BREAKABLE, UNBREAKABLE
- * or DIAMOND
- * if the given coordinates are out of bounds UNBREAKABLE will be returned
- */
-uint8_t get_object_at(uint8_t x, uint8_t y);
-
-/*
- * returns 1 if a given (x,y) coordinate is inside the bounds of 
- * the playing field, 0 if it is out of bounds
- */
-uint8_t in_bounds(uint8_t x, uint8_t y);
-
-/* update the player direction indicator display, by changing whether
- * it is visible or not, call this function at regular intervals to
- * have the indicator flash
- */
-void flash_facing(void);
-
-/*
- * move the position of the player by (dx, dy) if they can be moved
- * the player direction indicator should also be updated by this.
- * the player should move to square (x+dx, y+dy) if there is an
- * EMPTY_SQUARE or DIAMOND at that location.
- * get_object_at(x+dx, y+dy) can be used to check what is at that position
- * returns exit code 1 if move is valid
- * returns exit code 0 otherwise
- */
-uint8_t move_player(int8_t dx, int8_t dy);
-
-// returns 1 if the game is over, 0 otherwise
-uint8_t is_game_over(void);
-
-// updates colour of square containing direction indicator if there is a
-// BREAKABLE at that location, does nothing otherwise
-void inspect_facing(void);
-
-void toggle_cheat(void);
-
-// finds the nearest diamond to the player
-// evaluates its Manhattan distance
-// if distance is less than 4, flashes an LED
-uint32_t detect_diamond();
-
-// attempts to plant bomb at player's current location
-// can plant bomb iff no other bomb is currently in play
-// returns exit code 1 if planted new bomb
-// returns exit code 0 otherwise
-uint8_t plant_bomb(void);
-
-// returns 1 if bomb is now displayed
-// returns 0 otherwise
-uint8_t flash_bomb(void);
-
-void detonate_bomb(void);
-
-void clear_explosion(void);
-
-// returns 1 if the player is standing on or next to a bomb
-// returns 0 otherwise
-uint8_t in_danger(void);
-
-// pauses the game, returns the current time
-uint32_t pause_game(void);
-
-// unpauses the game, sets current time to previous pause time
-void unpause_game(uint32_t pause_time);
-
-#endif
-
-/*
- * How long? That is the question Robert Cancross posits as his focus returns, 
- * breaking the reverie he had been so graciously lost in. The dappled light 
- * filters through the leaves, falling softly upon his face. The shimmering 
- * warmth reminds him of Tuscany. Tuscany. How long had it been since he was 
- * home? He knew he could not provide an honest answer. And how long till he 
- * would return? ... Would he return? The weight of these questions was heavy 
- * upon him now, and this burden was more than he should like to carry. He 
- * busies himself by picking up equipment - with each item he lifts, the burden 
- * reduces a little more. There's no point waiting any longer, he has come this
- * far and waited this long. One last look towards the hills, before he turns 
- * towards the shaft of the mine, and begins his descent...
+/*
+** game.h
+**
+** Written by Luke Kamols, Daniel Cumming
+**
+** Function prototypes for those functions available externally
+*/
+
+#ifndef GAME_H_
+#define GAME_H_
+
+#include <inttypes.h>
+
+#define BOMB_FUSE_TIME	2000
+#define EXPLOSION_DELAY	500
+#define GAME_OVER_DELAY	1000
+
+/*
+ * Initialise the game, creates the internal game state and updates
+ * the display of this game
+ */
+void initialise_game(uint8_t level, uint8_t score);
+
+/* returns which object is located at position (x,y)
+ * the value returned will be EMPTY_SQUARE, BREAKABLE, UNBREAKABLE,
+ * INSPECTED, DIAMOND, BOMB or EXIT
+ * if the given coordinates are out of bounds UNBREAKABLE will be returned
+ */
+uint8_t get_object_at(uint8_t x, uint8_t y);
+
+/* places 'object' at position (x,y), this is the only way the playing
+ * field is changed
+ * placing an EMPTY_SQUARE also removes any diamond or exit there, and 
+ * placing a BOMB does nothing as bombs are planted with plant_bomb
+ */
+void set_object_at(uint8_t x, uint8_t y, uint8_t object);
+
+// returns 1 if position (x,y) has been discovered, 0 otherwise
+uint8_t is_visible(uint8_t x, uint8_t y);
+
+/* returns the object which should be displayed at position (x,y), this
+ * takes the player, the direction indicator, explosions and undiscovered
+ * squares into account
+ */
+uint8_t get_display_object(uint8_t x, uint8_t y);
+
+/*
+ * returns 1 if a given (x,y) coordinate is inside the bounds of 
+ * the playing field, 0 if it is out of bounds
+ */
+uint8_t in_bounds(uint8_t x, uint8_t y);
+
+/* update the player direction indicator display, by changing whether
+ * it is visible or not, call this function at regular intervals to
+ * have the indicator flash
+ */
+void flash_facing(void);
+
+/*
+ * move the position of the player by (dx, dy) if they can be moved
+ * the player direction indicator should also be updated by this.
+ * the player should move to square (x+dx, y+dy) if there is an
+ * EMPTY_SQUARE or DIAMOND at that location.
+ * get_object_at(x+dx, y+dy) can be used to check what is at that position
+ * moving right from the exit once every diamond is collected finishes
+ * the level (see update_game())
+ * returns exit code 1 if move is valid
+ * returns exit code 0 otherwise
+ */
+uint8_t move_player(int8_t dx, int8_t dy);
+
+/*
+ * move the player diagonally by (dx, dy), each -1 or 1, as move_player()
+ * up or down then across would, trying up or down again from across if
+ * it was blocked the first time. The display is only updated once, for
+ * where the player ends up, rather than for every step.
+ * if dx or dy is 0 this is the same as move_player(dx, dy)
+ * returns the number of squares the player moved (0 to 2)
+ */
+uint8_t move_player_path(int8_t dx, int8_t dy);
+
+// returns 1 if the game is over, 0 otherwise
+uint8_t is_game_over(void);
+
+// returns the number of diamonds collected over all levels of this game
+uint8_t get_total_score(void);
+
+// return the current level (from 1), the diamonds collected and available
+// on it and its size
+uint8_t get_level(void);
+uint8_t get_score(void);
+uint8_t get_diamonds_available(void);
+uint8_t get_world_width(void);
+uint8_t get_world_height(void);
+
+// return the player's position
+uint8_t get_player_x(void);
+uint8_t get_player_y(void);
+
+// give the position of diamond 'i' of the level (from 0 to
+// get_diamonds_available() - 1), and return 1 if it hasn't been collected
+uint8_t get_diamond(uint8_t i, uint8_t* x, uint8_t* y);
+
+// give the position of the exit, and return 1 if it is still there
+uint8_t get_exit(uint8_t* x, uint8_t* y);
+
+// updates colour of square containing direction indicator if there is a
+// BREAKABLE at that location, does nothing otherwise
+void inspect_facing(void);
+
+void toggle_cheat(void);
+
+// finds the nearest diamond to the player
+// evaluates its Manhattan distance
+// if distance is less than 4, flashes an LED
+uint32_t detect_diamond();
+
+// the most bombs that can be in play at once
+#define MAX_BOMBS		4
+
+// attempts to plant a bomb at player's current location
+// can plant a bomb iff there isn't one there already and fewer than 
+// MAX_BOMBS are in play
+// returns exit code 1 if planted new bomb
+// returns exit code 0 otherwise
+uint8_t plant_bomb(uint32_t current_time);
+
+// returns the number of bombs waiting to explode
+uint8_t bombs_in_play(void);
+
+// flashes, explodes and clears the explosions of bombs as their times
+// come up. A bomb whose explosion reaches another bomb sets it off too.
+// This returns straight away if no bomb needs attention, so can be 
+// called every time around the game loop.
+void update_bombs(uint32_t current_time);
+
+// returns 1 if the player is standing on or next to a bomb
+// returns 0 otherwise
+uint8_t in_danger(void);
+
+// flashes the player direction indicator and updates the bombs as
+// their times come up, 'current_time' is the game time (see gameclock.h)
+// Once the player has left a level by the exit, this instead moves on
+// to the next level a step at a time: the level's score is scrolled
+// across the display, then the next level is set up and shown.
+void update_game(uint32_t current_time);
+
+// returns 1 while the game is moving on to the next level, during which
+// moves, inspections and bombs are ignored
+uint8_t changing_level(void);
+
+// pauses the game, stopping the game clock
+void pause_game(void);
+
+// unpauses the game, restarting the game clock where it stopped
+void unpause_game(void);
+
+// doubles (if 'faster' is non-zero) or halves how fast the game runs,
+// within the limits of the game clock
+void change_game_speed(int8_t faster);
+
+// bomb_age of a bomb which isn't lit
+#define NO_BOMB			0xFFFF
+
+// the game state kept by a saved game (see save.h), other than the 
+// playing field
+typedef struct {
+	uint8_t level;
+	uint8_t total_score; // from the levels before this one
+	uint8_t score;
+	uint8_t cheating;
+	uint8_t player_x, player_y;
+	uint8_t facing_x, facing_y;
+	uint16_t diamonds_collected;
+	uint8_t exit_present;
+	// lit bombs, with how long ago they were planted in game time
+	uint8_t bomb_x[MAX_BOMBS], bomb_y[MAX_BOMBS];
+	uint16_t bomb_age[MAX_BOMBS];
+} SavedGame;
+
+// the packed terrain and visibility of the playing field (see levels.h),
+// as a saved game keeps them
+uint8_t* get_terrain_data(void);
+uint8_t* get_visible_data(void);
+
+// fills in 'saved' from the current game
+void get_saved_game(SavedGame* saved);
+
+// restores the game from 'saved', apart from the playing field which
+// should be copied into get_terrain_data() and get_visible_data()
+// afterwards. Bombs carry on from where they were in game time.
+void restore_saved_game(const SavedGame* saved);
+
+// shows a restored game on the display and the terminal, the display
+// is redrawn in one go
+void resume_game_display(void);
+
+#endif
+
+/*
+ * How long? That is the question Robert Cancross posits as his focus returns, 
+ * breaking the reverie he had been so graciously lost in. The dappled light 
+ * filters through the leaves, falling softly upon his face. The shimmering 
+ * warmth reminds him of Tuscany. Tuscany. How long had it been since he was 
+ * home? He knew he could not provide an honest answer. And how long till he 
+ * would return? ... Would he return? The weight of these questions was heavy 
+ * upon him now, and this burden was more than he should like to carry. He 
+ * busies himself by picking up equipment - with each item he lifts, the burden 
+ * reduces a little more. There's no point waiting any longer, he has come this
+ * far and waited this long. One last look towards the hills, before he turns 
+ * towards the shaft of the mine, and begins his descent...
  */
\ No newline at end of file
@@ -0,0 +1,86 @@
+/*
+ * gameclock.c
+ *
+ * Author: William Sawyer
+ */
+
+#include <stdint.h>
+
+#include "gameclock.h"
+#if !GAME_CLOCK_MANUAL
+#include "timer0.h"
+#endif
+
+static uint32_t game_time;
+static uint8_t game_clock_fraction; // sixteenths of a millisecond
+static uint8_t game_clock_scale = GAME_CLOCK_SCALE_ONE;
+static uint8_t game_clock_stopped;
+#if !GAME_CLOCK_MANUAL
+static uint32_t last_tick; // system tick game time was last brought up to
+#endif
+
+// brings game time up to date with the system tick
+static void game_clock_update(void) {
+#if !GAME_CLOCK_MANUAL
+	uint32_t tick = get_current_time();
+	uint32_t elapsed = tick - last_tick;
+	last_tick = tick;
+	if (!game_clock_stopped) {
+		uint32_t scaled = elapsed * game_clock_scale + game_clock_fraction;
+		game_time += scaled >> 4;
+		game_clock_fraction = scaled & 0x0F;
+	}
+#endif
+}
+
+void game_clock_start(void) {
+#if !GAME_CLOCK_MANUAL
+	last_tick = get_current_time();
+#endif
+	game_time = 0;
+	game_clock_fraction = 0;
+	game_clock_scale = GAME_CLOCK_SCALE_ONE;
+	game_clock_stopped = 0;
+}
+
+uint32_t get_game_time(void) {
+	game_clock_update();
+	return game_time;
+}
+
+void game_clock_pause(void) {
+	game_clock_update();
+	game_clock_stopped = 1;
+}
+
+void game_clock_resume(void) {
+	// the time spent paused is skipped over by this update
+	game_clock_update();
+	game_clock_stopped = 0;
+}
+
+uint8_t game_clock_paused(void) {
+	return game_clock_stopped;
+}
+
+void game_clock_set_scale(uint8_t scale) {
+	if (scale < GAME_CLOCK_SCALE_MIN) {
+		scale = GAME_CLOCK_SCALE_MIN;
+	} else if (scale > GAME_CLOCK_SCALE_MAX) {
+		scale = GAME_CLOCK_SCALE_MAX;
+	}
+	// time up to now runs at the old scale
+	game_clock_update();
+	game_clock_scale = scale;
+}
+
+uint8_t game_clock_get_scale(void) {
+	return game_clock_scale;
+}
+
+void game_clock_advance(uint32_t ms) {
+	game_clock_update();
+	if (!game_clock_stopped) {
+		game_time += ms;
+	}
+}
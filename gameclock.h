@@ -0,0 +1,63 @@
+/*
+ * gameclock.h
+ *
+ * Author: William Sawyer
+ *
+ * The game clock measures game time in milliseconds, separately from
+ * the timer0 system tick. Everything timed within a game (cursor and 
+ * bomb flashes, fuses, explosions) should use get_game_time() so that
+ * the game can be paused, slowed down or sped up without disturbing
+ * anything else which uses the system tick.
+ *
+ * Game time normally follows the system tick, multiplied by the clock 
+ * scale. When GAME_CLOCK_MANUAL is defined to 1 (as in host builds) the
+ * system tick is never read and game time only moves forward when 
+ * game_clock_advance() is called, so a game can be simulated as fast as
+ * the host can go and gives the same result every time. Firmware built
+ * this way moves game time on 1 ms for each . received on the serial
+ * port instead, so it can be run in step with the host build (see
+ * host/lockstep.c).
+ */
+
+#ifndef GAMECLOCK_H_
+#define GAMECLOCK_H_
+
+#include <stdint.h>
+
+#ifndef GAME_CLOCK_MANUAL
+#define GAME_CLOCK_MANUAL 0
+#endif
+
+// The clock scale is in sixteenths, so GAME_CLOCK_SCALE_ONE runs game
+// time at the same rate as the system tick.
+#define GAME_CLOCK_SCALE_ONE	16
+#define GAME_CLOCK_SCALE_MIN	4	// quarter speed
+#define GAME_CLOCK_SCALE_MAX	64	// four times speed
+
+/* Restart game time from 0, running at normal speed.
+ */
+void game_clock_start(void);
+
+/* Return the game time in milliseconds.
+ */
+uint32_t get_game_time(void);
+
+/* Stop and restart game time. Pausing a paused clock (or resuming a
+ * running one) does nothing.
+ */
+void game_clock_pause(void);
+void game_clock_resume(void);
+uint8_t game_clock_paused(void);
+
+/* Set how fast game time runs, in sixteenths of the system tick rate.
+ * The scale is limited to GAME_CLOCK_SCALE_MIN to GAME_CLOCK_SCALE_MAX.
+ */
+void game_clock_set_scale(uint8_t scale);
+uint8_t game_clock_get_scale(void);
+
+/* Move game time forward by 'ms' milliseconds straight away, unless the
+ * clock is paused.
+ */
+void game_clock_advance(uint32_t ms);
+
+#endif /* GAMECLOCK_H_ */
@@ -0,0 +1,132 @@
+/*
+ * highscore.c
+ *
+ * Author: William Sawyer
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#include <avr/pgmspace.h>
+
+#include "highscore.h"
+#include "storage.h"
+#include "terminalio.h"
+
+// each copy takes a fixed size slot
+#define SLOT_SIZE	24
+#define NUM_SLOTS	(HIGHSCORE_EEPROM_SIZE / SLOT_SIZE)
+
+// added into the checksum so that erased (all 0xFF) or cleared slots
+// are never valid
+#define CHECKSUM_SEED	0xA5
+
+// the table as it is now
+static HighScores table;
+// the copy being written to the EEPROM
+static HighScores saved;
+static uint8_t slot;	// the slot the latest copy is in
+static uint8_t changed;
+
+static uint8_t checksum(const HighScores* scores) {
+	const uint8_t* bytes = (const uint8_t*)scores;
+	uint8_t sum = CHECKSUM_SEED;
+	for (uint8_t i = 0; i < offsetof(HighScores, checksum); i++) {
+		sum += bytes[i];
+	}
+	return sum;
+}
+
+void init_highscores(void) {
+	uint8_t found = 0;
+	for (uint8_t i = 0; i < NUM_SLOTS; i++) {
+		storage_read(HIGHSCORE_EEPROM_START + i * SLOT_SIZE, &saved, 
+				sizeof(saved));
+		if (saved.checksum != checksum(&saved)) {
+			continue;
+		}
+		// sequence numbers wrap around, so compare the difference
+		if (!found || (int16_t)(saved.sequence - table.sequence) > 0) {
+			table = saved;
+			slot = i;
+			found = 1;
+		}
+	}
+	if (!found) {
+		memset(&table, 0, sizeof(table));
+		for (uint8_t i = 0; i < NUM_LEVELS; i++) {
+			table.best_steps[i] = NO_BEST_STEPS;
+		}
+		// the first copy goes in slot 0
+		slot = NUM_SLOTS - 1;
+	}
+	changed = 0;
+}
+
+void highscore_level_finished(uint8_t level, uint16_t steps) {
+	uint16_t* best = &table.best_steps[(level - 1) % NUM_LEVELS];
+	if (steps < *best) {
+		*best = steps;
+		changed = 1;
+	}
+}
+
+uint8_t highscore_game_over(uint8_t total_score) {
+	uint8_t place = 0;
+	table.games_played++;
+	table.diamonds_collected += total_score;
+	for (uint8_t i = 0; i < NUM_HIGH_SCORES; i++) {
+		if (total_score > table.scores[i]) {
+			// move the lower scores down to make room
+			memmove(&table.scores[i + 1], &table.scores[i], 
+					NUM_HIGH_SCORES - 1 - i);
+			table.scores[i] = total_score;
+			place = i + 1;
+			break;
+		}
+	}
+	changed = 1;
+	return place;
+}
+
+void highscore_update(void) {
+	if (!changed || storage_busy()) {
+		return;
+	}
+	table.sequence++;
+	table.checksum = checksum(&table);
+	saved = table;
+	slot = (slot + 1) % NUM_SLOTS;
+	if (storage_write(HIGHSCORE_EEPROM_START + slot * SLOT_SIZE, &saved, 
+			sizeof(saved))) {
+		changed = 0;
+	}
+}
+
+void highscore_show(uint8_t place) {
+	move_terminal_cursor(HIGHSCORE_X, HIGHSCORE_Y);
+	printf_P(PSTR("High scores"));
+	for (uint8_t i = 0; i < NUM_HIGH_SCORES; i++) {
+		move_terminal_cursor(HIGHSCORE_X, HIGHSCORE_Y + 1 + i);
+		if (i + 1 == place) {
+			reverse_video();
+		}
+		printf_P(PSTR("%u. %3u"), i + 1, table.scores[i]);
+		normal_display_mode();
+	}
+	move_terminal_cursor(HIGHSCORE_X, HIGHSCORE_Y + 1 + NUM_HIGH_SCORES);
+	printf_P(PSTR("Games: %u  Diamonds: %u"), table.games_played, 
+			table.diamonds_collected);
+	for (uint8_t i = 0; i < NUM_LEVELS; i++) {
+		move_terminal_cursor(HIGHSCORE_X, HIGHSCORE_Y + 2 + NUM_HIGH_SCORES + i);
+		if (table.best_steps[i] == NO_BEST_STEPS) {
+			printf_P(PSTR("Level %u best: -"), i + 1);
+		} else {
+			printf_P(PSTR("Level %u best: %u steps"), i + 1, 
+					table.best_steps[i]);
+		}
+	}
+	move_terminal_cursor(0, 0);
+}
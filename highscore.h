@@ -0,0 +1,62 @@
+/*
+ * highscore.h
+ *
+ * Author: William Sawyer
+ *
+ * High scores and statistics kept in the EEPROM: the best total scores,
+ * the number of games played and diamonds collected, and the fewest 
+ * steps taken to finish each level.
+ *
+ * Each time the table changes a whole new copy is written to the next
+ * of 8 slots in a ring in the EEPROM, with a sequence number and a checksum.
+ * This spreads wear over all of the slots, and if power is lost part
+ * way through a write the previous copy is still there. At start up 
+ * the valid copy with the latest sequence number is used.
+ */
+
+#ifndef HIGHSCORE_H_
+#define HIGHSCORE_H_
+
+#include <stdint.h>
+
+#include "levels.h"
+
+#define NUM_HIGH_SCORES		5
+
+// best_steps value for a level which has never been finished
+#define NO_BEST_STEPS		0xFFFF
+
+typedef struct {
+	uint16_t sequence;
+	uint8_t scores[NUM_HIGH_SCORES];	// highest first
+	uint16_t games_played;
+	uint16_t diamonds_collected;
+	uint16_t best_steps[NUM_LEVELS];
+	uint8_t checksum;
+} HighScores;
+
+/* Load the table from the EEPROM, or start an empty one if there is no
+ * valid copy.
+ */
+void init_highscores(void);
+
+/* Record that a level (from 1) was finished in 'steps' steps.
+ */
+void highscore_level_finished(uint8_t level, uint16_t steps);
+
+/* Record a finished game. Returns the score's place in the table (from
+ * 1), or 0 if it didn't make it.
+ */
+uint8_t highscore_game_over(uint8_t total_score);
+
+/* Queue the table to be written to the EEPROM if it has changed and the
+ * last copy has been written. Call this regularly.
+ */
+void highscore_update(void);
+
+/* Print the table to the terminal, highlighting place 'place' (from 1,
+ * 0 for none).
+ */
+void highscore_show(uint8_t place);
+
+#endif /* HIGHSCORE_H_ */
@@ -0,0 +1,16 @@
+/*
+ * interrupt.h
+ *
+ * Author: William Sawyer
+ *
+ * Host stand-in for <avr/interrupt.h>. The host has no interrupts, so
+ * enabling and disabling them does nothing.
+ */
+
+#ifndef HOST_INTERRUPT_H_
+#define HOST_INTERRUPT_H_
+
+#define sei()	((void)0)
+#define cli()	((void)0)
+
+#endif /* HOST_INTERRUPT_H_ */
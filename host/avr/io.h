@@ -0,0 +1,15 @@
+/*
+ * io.h
+ *
+ * Author: William Sawyer
+ *
+ * Host stand-in for <avr/io.h>. Files built for the host don't touch
+ * any registers, so there is nothing here.
+ */
+
+#ifndef HOST_IO_H_
+#define HOST_IO_H_
+
+#include <stdint.h>
+
+#endif /* HOST_IO_H_ */
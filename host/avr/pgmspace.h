@@ -0,0 +1,31 @@
+/*
+ * pgmspace.h
+ *
+ * Author: William Sawyer
+ *
+ * Host stand-in for <avr/pgmspace.h>. There is only one address space
+ * on the host, so program memory is ordinary memory.
+ */
+
+#ifndef HOST_PGMSPACE_H_
+#define HOST_PGMSPACE_H_
+
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+
+#define PROGMEM
+#define PSTR(s) (s)
+#define PGM_P const char*
+
+#define pgm_read_byte(p)	(*(const uint8_t*)(p))
+#define pgm_read_word(p)	(*(const uint16_t*)(p))
+#define pgm_read_ptr(p)		(*(void* const*)(p))
+
+#define memcpy_P	memcpy
+#define strlen_P	strlen
+#define printf_P	printf
+#define sprintf_P	sprintf
+#define snprintf_P	snprintf
+
+#endif /* HOST_PGMSPACE_H_ */
@@ -0,0 +1,788 @@
+/*
+ * batch.c
+ *
+ * Author: William Sawyer
+ *
+ * The rules here follow game.c line for line where they can, and where
+ * they work on whole bitboards instead the reason they give the same
+ * result is noted.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+#include "batch.h"
+#include "game.h"
+#include "display.h"
+#include "levels.h"
+
+// as in game.c
+#define PLAYER_START_X	0
+#define PLAYER_START_Y	0
+#define FACING_START_X	1
+#define FACING_START_Y	0
+
+#define BOMB_UNUSED		0
+#define BOMB_LIT		1
+#define BOMB_EXPLODED	2
+
+#define NUM_DIRECTIONS 4
+static const int8_t directions[NUM_DIRECTIONS][2] =
+		{{0,1}, {0,-1}, {1,0}, {-1,0}};
+
+static const uint8_t terrain_objects[4] =
+		{EMPTY_SQUARE, BREAKABLE, UNBREAKABLE, INSPECTED};
+
+#define MAX_WORDS	(WORLD_MAX_WIDTH * WORLD_MAX_HEIGHT / 32)
+
+// object properties, as in object_properties in display.c
+static uint8_t walkable(uint8_t object) {
+	return object == EMPTY_SQUARE || object == DIAMOND || object == BOMB
+			|| object == EXIT;
+}
+
+static uint8_t is_open(uint8_t object) {
+	return object == EMPTY_SQUARE || object == DIAMOND || object == EXIT;
+}
+
+static uint8_t destructible(uint8_t object) {
+	return object == BREAKABLE || object == INSPECTED || object == EXIT;
+}
+
+static uint8_t breakable(uint8_t object) {
+	return object == BREAKABLE || object == INSPECTED;
+}
+
+static inline uint32_t* plane_word(const BatchGames* games, uint8_t plane,
+		uint32_t game, uint16_t i) {
+	return &games->planes[plane][(uint32_t)(i >> 5) * games->stride + game];
+}
+
+static inline uint8_t get_bit(const BatchGames* games, uint8_t plane,
+		uint32_t game, uint16_t i) {
+	return (*plane_word(games, plane, game, i) >> (i & 31)) & 1;
+}
+
+static inline void set_bit(BatchGames* games, uint8_t plane, uint32_t game,
+		uint16_t i, uint8_t value) {
+	uint32_t* word = plane_word(games, plane, game, i);
+	if (value) {
+		*word |= 1u << (i & 31);
+	} else {
+		*word &= ~(1u << (i & 31));
+	}
+}
+
+static inline uint16_t square_index(const BatchGames* games, uint8_t x,
+		uint8_t y) {
+	return (uint16_t)y * games->width + x;
+}
+
+static uint8_t on_field(const BatchGames* games, uint8_t x, uint8_t y) {
+	return x < games->width && y < games->height;
+}
+
+// as get_object_at() does in game.c
+uint8_t batch_object_at(const BatchGames* games, uint32_t game, uint8_t x,
+		uint8_t y) {
+	if (!on_field(games, x, y)) {
+		return UNBREAKABLE;
+	}
+	uint16_t i = square_index(games, x, y);
+	uint8_t object = terrain_objects[get_bit(games, BATCH_TERRAIN_LO, game, i)
+			| get_bit(games, BATCH_TERRAIN_HI, game, i) << 1];
+	if (object != EMPTY_SQUARE) {
+		return object;
+	}
+	if (get_bit(games, BATCH_LIT_BOMBS, game, i)) {
+		return BOMB;
+	}
+	if (games->exit_present[game] && x == games->exit_x
+			&& y == games->exit_y) {
+		return EXIT;
+	}
+	if (get_bit(games, BATCH_DIAMONDS, game, i)) {
+		return DIAMOND;
+	}
+	return EMPTY_SQUARE;
+}
+
+uint8_t batch_is_visible(const BatchGames* games, uint32_t game, uint8_t x,
+		uint8_t y) {
+	return get_bit(games, BATCH_VISIBLE, game, square_index(games, x, y));
+}
+
+static void set_terrain(BatchGames* games, uint32_t game, uint16_t i,
+		uint8_t value) {
+	set_bit(games, BATCH_TERRAIN_LO, game, i, value & 1);
+	set_bit(games, BATCH_TERRAIN_HI, game, i, value >> 1);
+}
+
+// as set_object_at(x, y, EMPTY_SQUARE) does in game.c
+static void set_empty(BatchGames* games, uint32_t game, uint8_t x,
+		uint8_t y) {
+	if (!on_field(games, x, y)) {
+		return;
+	}
+	uint16_t i = square_index(games, x, y);
+	set_terrain(games, game, i, TERRAIN_EMPTY);
+	if (x == games->exit_x && y == games->exit_y) {
+		games->exit_present[game] = 0;
+	}
+	set_bit(games, BATCH_DIAMONDS, game, i, 0);
+}
+
+// word w of bitboard 'src' moved 'k' squares towards higher indices
+static inline uint32_t shifted_up(const uint32_t* src, int w, uint8_t k) {
+	int s = w - (k >> 5);
+	uint8_t bits = k & 31;
+	if (s < 0) {
+		return 0;
+	}
+	uint32_t value = src[s] << bits;
+	if (bits && s > 0) {
+		value |= src[s - 1] >> (32 - bits);
+	}
+	return value;
+}
+
+// word w of bitboard 'src' moved 'k' squares towards lower indices
+static inline uint32_t shifted_down(const uint32_t* src, int words, int w,
+		uint8_t k) {
+	int s = w + (k >> 5);
+	uint8_t bits = k & 31;
+	if (s >= words) {
+		return 0;
+	}
+	uint32_t value = src[s] >> bits;
+	if (bits && s + 1 < words) {
+		value |= src[s + 1] << (32 - bits);
+	}
+	return value;
+}
+
+// word w of the squares next to those in bitboard 'src'
+static inline uint32_t neighbours(const BatchGames* games,
+		const uint32_t* src, int w) {
+	// squares moved off one end of a row mustn't reappear at the other
+	// end of the next
+	return ((shifted_up(src, w, 1) & games->not_left[w])
+			| (shifted_down(src, games->words, w, 1) & games->not_right[w])
+			| shifted_up(src, w, games->width)
+			| shifted_down(src, games->words, w, games->width))
+			& games->board[w];
+}
+
+/*
+ * discoverable_dfs(x, y), a breadth first search a row of words at a
+ * time. Each pass reveals the squares next to the frontier which aren't
+ * visible yet, and the open ones (empty terrain without a lit bomb)
+ * become the next frontier. Only the words the frontier can reach are
+ * looked at.
+ */
+static void reveal(BatchGames* games, uint32_t game, uint8_t x, uint8_t y) {
+	uint32_t frontier[MAX_WORDS], grown[MAX_WORDS];
+	uint32_t* visible = games->planes[BATCH_VISIBLE];
+	uint16_t i = square_index(games, x, y);
+	int words = games->words;
+	// words a square's neighbours can be from its own
+	int margin = (games->width >> 5) + 1;
+
+	set_bit(games, BATCH_VISIBLE, game, i, 1);
+	if (!is_open(batch_object_at(games, game, x, y))) {
+		return;
+	}
+	memset(frontier, 0, words * sizeof(frontier[0]));
+	int first = i >> 5, last = i >> 5;
+	frontier[first] = 1u << (i & 31);
+	while (first <= last) {
+		int low = first - margin < 0 ? 0 : first - margin;
+		int high = last + margin >= words ? words - 1 : last + margin;
+		for (int w = low; w <= high; w++) {
+			grown[w] = neighbours(games, frontier, w);
+		}
+		first = words;
+		last = -1;
+		for (int w = low; w <= high; w++) {
+			uint32_t index = w * games->stride + game;
+			uint32_t found = grown[w] & ~visible[index];
+			visible[index] |= found;
+			frontier[w] = found & ~(games->planes[BATCH_TERRAIN_LO][index]
+					| games->planes[BATCH_TERRAIN_HI][index]
+					| games->planes[BATCH_LIT_BOMBS][index]);
+			if (frontier[w]) {
+				if (w < first) {
+					first = w;
+				}
+				last = w;
+			}
+		}
+	}
+}
+
+// as move_player(dx, dy) does in game.c
+static void do_move(BatchGames* games, uint32_t game, int8_t dx,
+		int8_t dy) {
+	uint8_t x = games->player_x[game];
+	uint8_t y = games->player_y[game];
+	if (batch_object_at(games, game, x, y) == EXIT && dx == 1 && dy == 0
+			&& games->score[game] == games->diamonds_available) {
+		games->status[game] = BATCH_FINISHED;
+		return;
+	}
+	if (walkable(batch_object_at(games, game, x + dx, y + dy))) {
+		x += dx;
+		y += dy;
+	}
+	games->player_x[game] = x;
+	games->player_y[game] = y;
+	games->facing_x[game] = (uint8_t)(x + dx);
+	games->facing_y[game] = (uint8_t)(y + dy);
+	if (batch_object_at(games, game, x, y) == DIAMOND) {
+		set_empty(games, game, x, y);
+		games->score[game]++;
+	}
+}
+
+// as inspect_facing() does in game.c
+static void do_inspect(BatchGames* games, uint32_t game) {
+	uint8_t x = games->facing_x[game];
+	uint8_t y = games->facing_y[game];
+	uint8_t inspected = batch_object_at(games, game, x, y);
+	if (games->cheating[game]) {
+		if (breakable(inspected)) {
+			set_empty(games, game, x, y);
+			reveal(games, game, x, y);
+		}
+	} else if (inspected == BREAKABLE) {
+		uint16_t i = square_index(games, x, y);
+		set_terrain(games, game, i, TERRAIN_INSPECTED);
+		set_bit(games, BATCH_VISIBLE, game, i, 1);
+	}
+}
+
+// the earliest time a bomb of 'game' needs attention. Unlike game.c
+// this leaves out flashes, which don't change the game and are always
+// before the bomb's fuse runs out
+static void update_next_bomb_event(BatchGames* games, uint32_t game) {
+	int32_t next = INT32_MAX;
+	for (uint8_t b = 0; b < MAX_BOMBS; b++) {
+		uint32_t k = b * games->stride + game;
+		int32_t event = next;
+		if (games->bomb_state[k] == BOMB_EXPLODED) {
+			event = games->clear_time[k];
+		} else if (games->bomb_state[k] == BOMB_LIT) {
+			event = games->fuse_time[k];
+		}
+		if (event < next) {
+			next = event;
+		}
+	}
+	games->next_bomb_event[game] = next;
+}
+
+// as plant_bomb() does in game.c
+static void do_plant_bomb(BatchGames* games, uint32_t game) {
+	uint8_t x = games->player_x[game];
+	uint8_t y = games->player_y[game];
+	if (batch_object_at(games, game, x, y) == BOMB) {
+		return;
+	}
+	for (uint8_t b = 0; b < MAX_BOMBS; b++) {
+		uint32_t k = b * games->stride + game;
+		if (games->bomb_state[k] == BOMB_UNUSED) {
+			games->bomb_x[k] = x;
+			games->bomb_y[k] = y;
+			games->bomb_state[k] = BOMB_LIT;
+			games->fuse_time[k] = games->time[game] + BOMB_FUSE_TIME;
+			set_bit(games, BATCH_LIT_BOMBS, game, square_index(games, x, y),
+					1);
+			update_next_bomb_event(games, game);
+			return;
+		}
+	}
+}
+
+// as in_danger_from() does in game.c
+static uint8_t in_danger_from(const BatchGames* games, uint32_t game,
+		uint32_t k) {
+	uint8_t x = games->bomb_x[k];
+	uint8_t y = games->bomb_y[k];
+	if (x == games->player_x[game] && y == games->player_y[game]) {
+		return 1;
+	}
+	for (uint8_t d = 0; d < NUM_DIRECTIONS; d++) {
+		if ((uint8_t)(x + directions[d][0]) == games->player_x[game]
+				&& (uint8_t)(y + directions[d][1]) == games->player_y[game]) {
+			return 1;
+		}
+	}
+	return 0;
+}
+
+// marks bomb 'b' exploded, returns 'b'
+static uint8_t explode(BatchGames* games, uint32_t game, uint8_t b) {
+	uint32_t k = b * games->stride + game;
+	games->bomb_state[k] = BOMB_EXPLODED;
+	set_bit(games, BATCH_LIT_BOMBS, game,
+			square_index(games, games->bomb_x[k], games->bomb_y[k]), 0);
+	return b;
+}
+
+// as detonate_bombs() does in game.c
+static void detonate_bombs(BatchGames* games, uint32_t game, int32_t time) {
+	uint8_t queue[MAX_BOMBS];
+	uint8_t queue_length = 0;
+	for (uint8_t b = 0; b < MAX_BOMBS; b++) {
+		uint32_t k = b * games->stride + game;
+		if (games->bomb_state[k] == BOMB_LIT && time >= games->fuse_time[k]) {
+			queue[queue_length++] = explode(games, game, b);
+		}
+	}
+	for (uint8_t q = 0; q < queue_length; q++) {
+		uint32_t k = queue[q] * games->stride + game;
+		uint8_t x = games->bomb_x[k];
+		uint8_t y = games->bomb_y[k];
+		games->clear_time[k] = time + EXPLOSION_DELAY;
+		if (in_danger_from(games, game, k)) {
+			games->status[game] = BATCH_GAME_OVER;
+		}
+		set_empty(games, game, x, y);
+		for (uint8_t d = 0; d < NUM_DIRECTIONS; d++) {
+			uint8_t x_adj = x + directions[d][0];
+			uint8_t y_adj = y + directions[d][1];
+			if (!on_field(games, x_adj, y_adj)) {
+				continue;
+			}
+			if (destructible(batch_object_at(games, game, x_adj, y_adj))) {
+				set_empty(games, game, x_adj, y_adj);
+				reveal(games, game, x_adj, y_adj);
+			}
+			for (uint8_t b = 0; b < MAX_BOMBS; b++) {
+				uint32_t chained = b * games->stride + game;
+				if (games->bomb_state[chained] == BOMB_LIT
+						&& games->bomb_x[chained] == x_adj
+						&& games->bomb_y[chained] == y_adj) {
+					queue[queue_length++] = explode(games, game, b);
+					break;
+				}
+			}
+		}
+	}
+}
+
+// as update_bombs() does in game.c
+static void do_update_bombs(BatchGames* games, uint32_t game) {
+	int32_t time = games->time[game];
+	if (time < games->next_bomb_event[game]) {
+		return;
+	}
+	uint8_t detonating = 0;
+	for (uint8_t b = 0; b < MAX_BOMBS; b++) {
+		uint32_t k = b * games->stride + game;
+		if (games->bomb_state[k] == BOMB_EXPLODED
+				&& time >= games->clear_time[k]) {
+			games->bomb_state[k] = BOMB_UNUSED;
+		} else if (games->bomb_state[k] == BOMB_LIT
+				&& time >= games->fuse_time[k]) {
+			detonating = 1;
+		}
+	}
+	if (detonating) {
+		detonate_bombs(games, game, time);
+	}
+	update_next_bomb_event(games, game);
+}
+
+// the bomb update and clock at the end of each step
+static void finish_step(BatchGames* games, uint32_t game) {
+	if (games->status[game] != BATCH_PLAYING) {
+		// a finished level is left straight away, bombs and all
+		return;
+	}
+	do_update_bombs(games, game);
+	if (games->status[game] == BATCH_PLAYING) {
+		games->time[game] += games->step_time;
+	}
+}
+
+static void step_game(BatchGames* games, uint32_t game, uint8_t action) {
+	if (games->status[game] != BATCH_PLAYING) {
+		return;
+	}
+	switch (action) {
+		case BATCH_UP:
+			do_move(games, game, 0, 1);
+			break;
+		case BATCH_DOWN:
+			do_move(games, game, 0, -1);
+			break;
+		case BATCH_LEFT:
+			do_move(games, game, -1, 0);
+			break;
+		case BATCH_RIGHT:
+			do_move(games, game, 1, 0);
+			break;
+		case BATCH_INSPECT:
+			do_inspect(games, game);
+			break;
+		case BATCH_BOMB:
+			do_plant_bomb(games, game);
+			break;
+		case BATCH_CHEAT:
+			games->cheating[game] ^= 1;
+			break;
+	}
+	finish_step(games, game);
+}
+
+#ifdef __AVX2__
+
+#define LOAD(array)	_mm256_load_si256((const __m256i*)(array))
+#define STORE(array, value)	_mm256_store_si256((__m256i*)(array), value)
+
+// bit i of 'plane' for each of the games in 'lanes', as 0 or -1
+static inline __m256i gather_bits(const BatchGames* games, uint8_t plane,
+		__m256i lanes, __m256i i) {
+	__m256i index = _mm256_add_epi32(_mm256_mullo_epi32(
+			_mm256_srli_epi32(i, 5), _mm256_set1_epi32(games->stride)), lanes);
+	__m256i words = _mm256_i32gather_epi32((const int*)games->planes[plane],
+			index, 4);
+	__m256i bits = _mm256_srlv_epi32(words,
+			_mm256_and_si256(i, _mm256_set1_epi32(31)));
+	return _mm256_cmpeq_epi32(_mm256_and_si256(bits, _mm256_set1_epi32(1)),
+			_mm256_set1_epi32(1));
+}
+
+static inline int lane_mask(__m256i mask) {
+	return _mm256_movemask_ps(_mm256_castsi256_ps(mask));
+}
+
+/*
+ * Steps the 8 games from 'game'. Moves and cheat mode are worked out for
+ * all of them at once, the same as move_player() for each: a player
+ * can only move onto empty terrain (which is all a bomb, the exit or a
+ * diamond can sit on), and picks up a diamond there unless a lit bomb
+ * or the exit is on top of it.
+ */
+static void step_block(BatchGames* games, const uint8_t* actions,
+		uint32_t game) {
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i one = _mm256_set1_epi32(1);
+	const __m256i none = _mm256_set1_epi32(-1);
+	const __m256i dx_table = _mm256_setr_epi32(0, 0, 0, -1, 1, 0, 0, 0);
+	const __m256i dy_table = _mm256_setr_epi32(0, 1, -1, 0, 0, 0, 0, 0);
+	const __m256i width = _mm256_set1_epi32(games->width);
+	const __m256i height = _mm256_set1_epi32(games->height);
+	const __m256i exit_x = _mm256_set1_epi32(games->exit_x);
+	const __m256i exit_y = _mm256_set1_epi32(games->exit_y);
+	__m256i lanes = _mm256_add_epi32(_mm256_set1_epi32(game),
+			_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+
+	__m256i action = _mm256_cvtepu8_epi32(
+			_mm_loadl_epi64((const __m128i*)(actions + game)));
+	// unknown actions do nothing
+	action = _mm256_and_si256(action,
+			_mm256_cmpgt_epi32(_mm256_set1_epi32(BATCH_NUM_ACTIONS), action));
+	__m256i status = LOAD(games->status + game);
+	__m256i playing = _mm256_cmpeq_epi32(status, zero);
+	__m256i dx = _mm256_permutevar8x32_epi32(dx_table, action);
+	__m256i dy = _mm256_permutevar8x32_epi32(dy_table, action);
+	__m256i moving = _mm256_and_si256(playing, _mm256_and_si256(
+			_mm256_cmpgt_epi32(action, zero),
+			_mm256_cmpgt_epi32(_mm256_set1_epi32(BATCH_INSPECT), action)));
+
+	__m256i x = LOAD(games->player_x + game);
+	__m256i y = LOAD(games->player_y + game);
+	__m256i score = LOAD(games->score + game);
+	__m256i exit_present = _mm256_xor_si256(
+			_mm256_cmpeq_epi32(LOAD(games->exit_present + game), zero), none);
+
+	// leaving by the exit
+	__m256i i = _mm256_add_epi32(_mm256_mullo_epi32(y, width), x);
+	__m256i covered = _mm256_or_si256(
+			_mm256_or_si256(gather_bits(games, BATCH_TERRAIN_LO, lanes, i),
+			gather_bits(games, BATCH_TERRAIN_HI, lanes, i)),
+			gather_bits(games, BATCH_LIT_BOMBS, lanes, i));
+	__m256i on_exit = _mm256_andnot_si256(covered, _mm256_and_si256(
+			exit_present, _mm256_and_si256(_mm256_cmpeq_epi32(x, exit_x),
+			_mm256_cmpeq_epi32(y, exit_y))));
+	__m256i finish = _mm256_and_si256(_mm256_and_si256(moving, on_exit),
+			_mm256_and_si256(_mm256_cmpeq_epi32(dx, one), _mm256_cmpeq_epi32(
+			score, _mm256_set1_epi32(games->diamonds_available))));
+	moving = _mm256_andnot_si256(finish, moving);
+
+	// moving onto empty terrain
+	__m256i new_x = _mm256_add_epi32(x, dx);
+	__m256i new_y = _mm256_add_epi32(y, dy);
+	__m256i inside = _mm256_and_si256(
+			_mm256_and_si256(_mm256_cmpgt_epi32(new_x, none),
+			_mm256_cmpgt_epi32(width, new_x)),
+			_mm256_and_si256(_mm256_cmpgt_epi32(new_y, none),
+			_mm256_cmpgt_epi32(height, new_y)));
+	i = _mm256_and_si256(inside,
+			_mm256_add_epi32(_mm256_mullo_epi32(new_y, width), new_x));
+	__m256i wall = _mm256_or_si256(
+			gather_bits(games, BATCH_TERRAIN_LO, lanes, i),
+			gather_bits(games, BATCH_TERRAIN_HI, lanes, i));
+	__m256i moved = _mm256_andnot_si256(wall, _mm256_and_si256(moving, inside));
+	x = _mm256_blendv_epi8(x, new_x, moved);
+	y = _mm256_blendv_epi8(y, new_y, moved);
+	__m256i byte = _mm256_set1_epi32(0xFF);
+	STORE(games->facing_x + game, _mm256_blendv_epi8(
+			LOAD(games->facing_x + game),
+			_mm256_and_si256(_mm256_add_epi32(x, dx), byte), moving));
+	STORE(games->facing_y + game, _mm256_blendv_epi8(
+			LOAD(games->facing_y + game),
+			_mm256_and_si256(_mm256_add_epi32(y, dy), byte), moving));
+	STORE(games->player_x + game, x);
+	STORE(games->player_y + game, y);
+
+	// picking up a diamond
+	__m256i exit_here = _mm256_and_si256(exit_present, _mm256_and_si256(
+			_mm256_cmpeq_epi32(new_x, exit_x), _mm256_cmpeq_epi32(new_y, exit_y)));
+	__m256i pickup = _mm256_andnot_si256(_mm256_or_si256(exit_here,
+			gather_bits(games, BATCH_LIT_BOMBS, lanes, i)), _mm256_and_si256(
+			moved, gather_bits(games, BATCH_DIAMONDS, lanes, i)));
+	STORE(games->score + game, _mm256_sub_epi32(score, pickup));
+	STORE(games->status + game, _mm256_blendv_epi8(status,
+			_mm256_set1_epi32(BATCH_FINISHED), finish));
+	__m256i cheat = _mm256_and_si256(playing,
+			_mm256_cmpeq_epi32(action, _mm256_set1_epi32(BATCH_CHEAT)));
+	STORE(games->cheating + game, _mm256_xor_si256(
+			LOAD(games->cheating + game), _mm256_and_si256(cheat, one)));
+
+	for (int mask = lane_mask(pickup); mask; mask &= mask - 1) {
+		uint32_t g = game + __builtin_ctz(mask);
+		set_bit(games, BATCH_DIAMONDS, g,
+				square_index(games, games->player_x[g], games->player_y[g]), 0);
+	}
+
+	// the rest are rare enough to do one game at a time
+	__m256i other = _mm256_and_si256(playing, _mm256_or_si256(
+			_mm256_cmpeq_epi32(action, _mm256_set1_epi32(BATCH_INSPECT)),
+			_mm256_cmpeq_epi32(action, _mm256_set1_epi32(BATCH_BOMB))));
+	for (int mask = lane_mask(other); mask; mask &= mask - 1) {
+		uint32_t g = game + __builtin_ctz(mask);
+		if (actions[g] == BATCH_INSPECT) {
+			do_inspect(games, g);
+		} else {
+			do_plant_bomb(games, g);
+		}
+	}
+
+	// bombs only need looking at once one is due
+	__m256i time = LOAD(games->time + game);
+	playing = _mm256_cmpeq_epi32(LOAD(games->status + game), zero);
+	__m256i due = _mm256_andnot_si256(_mm256_cmpgt_epi32(
+			LOAD(games->next_bomb_event + game), time), playing);
+	for (int mask = lane_mask(due); mask; mask &= mask - 1) {
+		do_update_bombs(games, game + __builtin_ctz(mask));
+	}
+	playing = _mm256_cmpeq_epi32(LOAD(games->status + game), zero);
+	STORE(games->time + game, _mm256_add_epi32(time, _mm256_and_si256(playing,
+			_mm256_set1_epi32(games->step_time))));
+}
+
+#else
+
+static void step_block(BatchGames* games, const uint8_t* actions,
+		uint32_t game) {
+	for (uint32_t g = game; g < game + BATCH_BLOCK; g++) {
+		step_game(games, g, actions[g]);
+	}
+}
+
+#endif /* __AVX2__ */
+
+void batch_step(BatchGames* games, const uint8_t* actions) {
+	int64_t blocks = games->n / BATCH_BLOCK;
+#ifdef _OPENMP
+	#pragma omp parallel for schedule(static)
+#endif
+	for (int64_t block = 0; block < blocks; block++) {
+		step_block(games, actions, block * BATCH_BLOCK);
+	}
+	for (uint32_t game = blocks * BATCH_BLOCK; game < games->n; game++) {
+		step_game(games, game, actions[game]);
+	}
+}
+
+void batch_in_danger(const BatchGames* games, uint8_t* danger) {
+	uint32_t game = 0;
+#ifdef __AVX2__
+	for (; game + BATCH_BLOCK <= games->n; game += BATCH_BLOCK) {
+		__m256i x = LOAD(games->player_x + game);
+		__m256i y = LOAD(games->player_y + game);
+		__m256i near = _mm256_setzero_si256();
+		for (uint8_t b = 0; b < MAX_BOMBS; b++) {
+			uint32_t k = b * games->stride + game;
+			// on the bomb or next to it (the wrap around of game.c's
+			// uint8_t coordinates never reaches the player)
+			__m256i distance = _mm256_add_epi32(
+					_mm256_abs_epi32(_mm256_sub_epi32(LOAD(games->bomb_x + k), x)),
+					_mm256_abs_epi32(_mm256_sub_epi32(LOAD(games->bomb_y + k), y)));
+			near = _mm256_or_si256(near, _mm256_and_si256(
+					_mm256_cmpeq_epi32(LOAD(games->bomb_state + k),
+					_mm256_set1_epi32(BOMB_LIT)),
+					_mm256_cmpgt_epi32(_mm256_set1_epi32(2), distance)));
+		}
+		int mask = lane_mask(near);
+		for (uint8_t lane = 0; lane < BATCH_BLOCK; lane++) {
+			danger[game + lane] = (mask >> lane) & 1;
+		}
+	}
+#endif
+	for (; game < games->n; game++) {
+		danger[game] = 0;
+		for (uint8_t b = 0; b < MAX_BOMBS; b++) {
+			uint32_t k = b * games->stride + game;
+			if (games->bomb_state[k] == BOMB_LIT
+					&& in_danger_from(games, game, k)) {
+				danger[game] = 1;
+			}
+		}
+	}
+}
+
+void batch_reset(BatchGames* games, uint32_t game) {
+	for (uint8_t p = 0; p < BATCH_NUM_PLANES; p++) {
+		for (uint8_t w = 0; w < games->words; w++) {
+			games->planes[p][w * games->stride + game] =
+					games->start[p * games->words + w];
+		}
+	}
+	games->status[game] = BATCH_PLAYING;
+	games->time[game] = 0;
+	games->player_x[game] = PLAYER_START_X;
+	games->player_y[game] = PLAYER_START_Y;
+	games->facing_x[game] = FACING_START_X;
+	games->facing_y[game] = FACING_START_Y;
+	games->score[game] = 0;
+	games->cheating[game] = 0;
+	games->exit_present[game] = 1;
+	games->next_bomb_event[game] = INT32_MAX;
+	for (uint8_t b = 0; b < MAX_BOMBS; b++) {
+		uint32_t k = b * games->stride + game;
+		games->bomb_x[k] = 0;
+		games->bomb_y[k] = 0;
+		games->bomb_state[k] = BOMB_UNUSED;
+	}
+}
+
+// allocates 'count' zeroed 32 bit values aligned for AVX2 loads
+static void* allocate(uint32_t count) {
+	size_t size = ((size_t)count * 4 + 31) & ~(size_t)31;
+	void* memory = aligned_alloc(32, size);
+	if (memory) {
+		memset(memory, 0, size);
+	}
+	return memory;
+}
+
+int batch_init(BatchGames* games, uint32_t n, uint8_t level,
+		int32_t step_time) {
+	const Level* layout = &levels[(level - 1) % NUM_LEVELS];
+	memset(games, 0, sizeof(*games));
+	games->n = n;
+	games->stride = (n + BATCH_BLOCK - 1) / BATCH_BLOCK * BATCH_BLOCK;
+	if (games->stride == 0) {
+		games->stride = BATCH_BLOCK;
+	}
+	games->level = level;
+	games->width = pgm_read_byte(&layout->width);
+	games->height = pgm_read_byte(&layout->height);
+	games->exit_x = pgm_read_byte(&layout->exit_x);
+	games->exit_y = pgm_read_byte(&layout->exit_y);
+	games->diamonds_available = pgm_read_byte(&layout->num_diamonds);
+	games->step_time = step_time;
+	uint16_t squares = (uint16_t)games->width * games->height;
+	games->words = (squares + 31) / 32;
+
+	uint32_t stride = games->stride;
+	uint8_t failed = 0;
+	for (uint8_t p = 0; p < BATCH_NUM_PLANES; p++) {
+		failed |= !(games->planes[p] = allocate(games->words * stride));
+	}
+	int32_t** per_game[] = {&games->status, &games->time, &games->player_x,
+			&games->player_y, &games->facing_x, &games->facing_y,
+			&games->score, &games->cheating, &games->exit_present,
+			&games->next_bomb_event};
+	for (uint8_t a = 0; a < sizeof(per_game) / sizeof(per_game[0]); a++) {
+		failed |= !(*per_game[a] = allocate(stride));
+	}
+	int32_t** per_bomb[] = {&games->bomb_x, &games->bomb_y,
+			&games->bomb_state, &games->fuse_time, &games->clear_time};
+	for (uint8_t a = 0; a < sizeof(per_bomb) / sizeof(per_bomb[0]); a++) {
+		failed |= !(*per_bomb[a] = allocate(MAX_BOMBS * stride));
+	}
+	failed |= !(games->board = allocate(games->words));
+	failed |= !(games->not_left = allocate(games->words));
+	failed |= !(games->not_right = allocate(games->words));
+	failed |= !(games->start = allocate(BATCH_NUM_PLANES * games->words));
+	if (failed) {
+		batch_free(games);
+		return -1;
+	}
+
+	// set up game 0 from the level, then keep it to start every game from
+	const uint8_t* terrain = pgm_read_ptr(&layout->terrain);
+	const uint8_t* visible = pgm_read_ptr(&layout->visible);
+	for (uint16_t i = 0; i < squares; i++) {
+		uint8_t x = i % games->width;
+		games->board[i >> 5] |= 1u << (i & 31);
+		if (x != 0) {
+			games->not_left[i >> 5] |= 1u << (i & 31);
+		}
+		if (x != games->width - 1) {
+			games->not_right[i >> 5] |= 1u << (i & 31);
+		}
+		set_terrain(games, 0, i,
+				(pgm_read_byte(&terrain[i >> 2]) >> ((i & 3) << 1)) & 3);
+		set_bit(games, BATCH_VISIBLE, 0, i,
+				(pgm_read_byte(&visible[i >> 3]) >> (i & 7)) & 1);
+	}
+	for (uint8_t d = 0; d < games->diamonds_available; d++) {
+		set_bit(games, BATCH_DIAMONDS, 0, square_index(games,
+				pgm_read_byte(&layout->diamonds[d][0]),
+				pgm_read_byte(&layout->diamonds[d][1])), 1);
+	}
+	games->exit_present[0] = 1;
+	for (uint8_t p = 0; p < BATCH_NUM_PLANES; p++) {
+		for (uint8_t w = 0; w < games->words; w++) {
+			games->start[p * games->words + w] = games->planes[p][w * stride];
+		}
+	}
+
+	for (uint32_t game = 0; game < stride; game++) {
+		batch_reset(games, game);
+		if (game >= n) {
+			// padding, never stepped
+			games->status[game] = BATCH_GAME_OVER;
+		}
+	}
+	return 0;
+}
+
+void batch_free(BatchGames* games) {
+	for (uint8_t p = 0; p < BATCH_NUM_PLANES; p++) {
+		free(games->planes[p]);
+	}
+	int32_t* arrays[] = {games->status, games->time, games->player_x,
+			games->player_y, games->facing_x, games->facing_y, games->score,
+			games->cheating, games->exit_present, games->next_bomb_event,
+			games->bomb_x, games->bomb_y, games->bomb_state, games->fuse_time,
+			games->clear_time};
+	for (uint8_t a = 0; a < sizeof(arrays) / sizeof(arrays[0]); a++) {
+		free(arrays[a]);
+	}
+	free(games->board);
+	free(games->not_left);
+	free(games->not_right);
+	free(games->start);
+	memset(games, 0, sizeof(*games));
+}
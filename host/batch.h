@@ -0,0 +1,127 @@
+/*
+ * batch.h
+ *
+ * Author: William Sawyer
+ *
+ * Host engine which steps many independent games of one level at once,
+ * for training bots and balancing levels. The rules are those of game.c
+ * (moving, collecting diamonds, leaving by the exit, inspecting, cheat
+ * mode, bombs and their chain reactions, and visibility), with nothing
+ * drawn.
+ *
+ * Games are stored structure-of-arrays: each per-game value is an array
+ * over the games, and the playing field is held as bitboard planes in
+ * which word w of every game is stored together. When built with AVX2
+ * (-mavx2), moves, diamond pickups and the danger check are worked out
+ * for 8 games at a time with gathers from the planes. Inspections,
+ * planting bombs and explosions are rare, and are done a game at a
+ * time, as is everything without AVX2. With -fopenmp, blocks of games
+ * are stepped in parallel.
+ *
+ * Each step applies one action to every game, then updates its bombs
+ * (as update_game() does after an input), then moves its clock on by
+ * step_time. A game which finishes the level or ends stops there until
+ * it is reset.
+ */
+
+#ifndef BATCH_H_
+#define BATCH_H_
+
+#include <stdint.h>
+
+// actions
+#define BATCH_NONE		0
+#define BATCH_UP		1
+#define BATCH_DOWN		2
+#define BATCH_LEFT		3
+#define BATCH_RIGHT		4
+#define BATCH_INSPECT	5
+#define BATCH_BOMB		6
+#define BATCH_CHEAT		7	// toggle cheat mode
+#define BATCH_NUM_ACTIONS	8
+
+// status of a game
+#define BATCH_PLAYING	0
+#define BATCH_FINISHED	1	// left the level by the exit
+#define BATCH_GAME_OVER	2
+
+// bitboard planes, bit i of a plane is square i = y * width + x
+#define BATCH_TERRAIN_LO	0	// the terrain value (see levels.h) is
+#define BATCH_TERRAIN_HI	1	// TERRAIN_HI * 2 + TERRAIN_LO
+#define BATCH_VISIBLE		2
+#define BATCH_DIAMONDS		3	// diamonds not yet collected
+#define BATCH_LIT_BOMBS		4
+#define BATCH_NUM_PLANES	5
+
+// games are stepped in blocks of this many
+#define BATCH_BLOCK			8
+
+typedef struct {
+	uint32_t n;			// number of games
+	uint32_t stride;	// n rounded up to a whole number of blocks
+	uint8_t level;		// from 1
+	uint8_t width, height;
+	uint8_t words;		// 32 bit words in a bitboard
+	uint8_t exit_x, exit_y;
+	uint8_t diamonds_available;
+	int32_t step_time;	// game time per step, in ms
+	// word w of plane p for game g is planes[p][w * stride + g]
+	uint32_t* planes[BATCH_NUM_PLANES];
+	// bitboards shared by all games: every square, and the squares not
+	// in the leftmost or rightmost column
+	uint32_t* board;
+	uint32_t* not_left;
+	uint32_t* not_right;
+	// every plane of one game at the start of the level, word w of plane
+	// p is start[p * words + w]
+	uint32_t* start;
+	// per game, indexed by game
+	int32_t* status;
+	int32_t* time;
+	int32_t* player_x;
+	int32_t* player_y;
+	int32_t* facing_x;	// 0 to 255, as the uint8_t in game.c wraps
+	int32_t* facing_y;
+	int32_t* score;
+	int32_t* cheating;
+	int32_t* exit_present;
+	int32_t* next_bomb_event;
+	// per bomb, bomb b of game g is at [b * stride + g]
+	int32_t* bomb_x;
+	int32_t* bomb_y;
+	int32_t* bomb_state;
+	int32_t* fuse_time;
+	int32_t* clear_time;
+} BatchGames;
+
+/* Allocate 'n' games of level 'level' (from 1, levels repeat as in
+ * game.c), each stepped 'step_time' ms at a time, and start them all.
+ * Returns 0, or -1 if the memory couldn't be allocated.
+ */
+int batch_init(BatchGames* games, uint32_t n, uint8_t level,
+		int32_t step_time);
+
+void batch_free(BatchGames* games);
+
+/* Start game 'game' again from the beginning of the level.
+ */
+void batch_reset(BatchGames* games, uint32_t game);
+
+/* Apply actions[g] to game g, for every game.
+ */
+void batch_step(BatchGames* games, const uint8_t* actions);
+
+/* Set danger[g] to 1 if the player of game g is on or next to a lit
+ * bomb, as in_danger() does.
+ */
+void batch_in_danger(const BatchGames* games, uint8_t* danger);
+
+/* Return what is at square (x,y) of game 'game', as get_object_at()
+ * does, and whether it has been discovered.
+ */
+uint8_t batch_object_at(const BatchGames* games, uint32_t game,
+		uint8_t x, uint8_t y);
+uint8_t batch_is_visible(const BatchGames* games, uint32_t game,
+		uint8_t x, uint8_t y);
+
+#endif /* BATCH_H_ */
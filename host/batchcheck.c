@@ -0,0 +1,229 @@
+/*
+ * batchcheck.c
+ *
+ * Author: William Sawyer
+ *
+ * Host program which checks that the batch engine (see batch.h) plays
+ * by the same rules as game.c. A batch of games of one level is stepped
+ * with random actions, then each game is replayed on its own through
+ * game.c with the same actions and times, and the two are compared:
+ * whether the game was still going, finished the level or was over,
+ * the player and facing squares, the score, cheat mode, whether the
+ * player is in danger, and every square of the playing field and
+ * whether it is visible.
+ *
+ * Build and run with:
+ *     gcc -O2 -DGAME_CLOCK_MANUAL=1 -Ihost -I. -o batchcheck \
+ *         host/batchcheck.c host/batch.c host/spi.c host/storage.c \
+ *         host/emulator.c game.c display.c levels.c gameclock.c \
+ *         ledmatrix.c image.c images.c terminalio.c save.c marquee.c \
+ *         render.c
+ *     ./batchcheck [games] [steps] [level] [step time] [seed]
+ *
+ * -mavx2 can be added to check the AVX2 paths of batch.c. Bombs and
+ * cheat mode are more common than in batchrun, so that chain reactions
+ * and walking through walls are well covered. Fewer steps leave more
+ * games still going to compare. Prints the first few games which
+ * differ, and exits with 1 if any do.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "game.h"
+#include "gameclock.h"
+#include "render.h"
+#include "batch.h"
+
+// games which differ are listed up to this many
+#define MAX_REPORTED	5
+
+// what differed, bits of the mismatch mask printed
+#define DIFF_STATUS		0x01
+#define DIFF_PLAYER		0x02
+#define DIFF_FACING		0x04
+#define DIFF_SCORE		0x08
+#define DIFF_CHEATING	0x10
+#define DIFF_DANGER		0x20
+#define DIFF_OBJECTS	0x40
+#define DIFF_VISIBLE	0x80
+
+// actions are drawn from this table, with more bombs, inspections and
+// cheat mode toggles than a player would make
+static const uint8_t action_table[32] = {
+	BATCH_UP, BATCH_DOWN, BATCH_LEFT, BATCH_RIGHT,
+	BATCH_UP, BATCH_DOWN, BATCH_LEFT, BATCH_RIGHT,
+	BATCH_UP, BATCH_DOWN, BATCH_LEFT, BATCH_RIGHT,
+	BATCH_UP, BATCH_DOWN, BATCH_LEFT, BATCH_RIGHT,
+	BATCH_UP, BATCH_DOWN, BATCH_LEFT, BATCH_RIGHT,
+	BATCH_UP, BATCH_DOWN, BATCH_LEFT, BATCH_RIGHT,
+	BATCH_INSPECT, BATCH_INSPECT, BATCH_INSPECT, BATCH_INSPECT,
+	BATCH_BOMB, BATCH_CHEAT, BATCH_NONE, BATCH_NONE
+};
+
+// xorshift, so runs can be repeated
+static uint32_t random_state = 1;
+
+static uint32_t next_random(void) {
+	random_state ^= random_state << 13;
+	random_state ^= random_state >> 17;
+	random_state ^= random_state << 5;
+	return random_state;
+}
+
+// game.c reads the clock through get_current_time() for saving, the
+// game clock is the only clock here
+uint32_t get_current_time(void) {
+	return get_game_time();
+}
+
+// replays one game through game.c, returns its status as in batch.h
+static int32_t replay(const uint8_t* actions, uint32_t steps, uint8_t level,
+		int32_t step_time) {
+	game_clock_start();
+	initialise_game(level - 1, 0);
+	for (uint32_t step = 0; step < steps; step++) {
+		switch (actions[step]) {
+			case BATCH_UP:
+				move_player(0, 1);
+				break;
+			case BATCH_DOWN:
+				move_player(0, -1);
+				break;
+			case BATCH_LEFT:
+				move_player(-1, 0);
+				break;
+			case BATCH_RIGHT:
+				move_player(1, 0);
+				break;
+			case BATCH_INSPECT:
+				inspect_facing();
+				break;
+			case BATCH_BOMB:
+				plant_bomb(get_game_time());
+				break;
+			case BATCH_CHEAT:
+				toggle_cheat();
+				break;
+		}
+		if (changing_level()) {
+			return BATCH_FINISHED;
+		}
+		update_game(get_game_time());
+		if (is_game_over()) {
+			return BATCH_GAME_OVER;
+		}
+		game_clock_advance(step_time);
+	}
+	return BATCH_PLAYING;
+}
+
+// compares the game just replayed with game 'g' of the batch, returns a
+// mask of DIFF_ bits
+static uint8_t compare(const BatchGames* games, uint32_t g, int32_t status,
+		uint8_t danger) {
+	SavedGame saved;
+	uint8_t diff = 0;
+
+	get_saved_game(&saved);
+	if (status != games->status[g]) {
+		diff |= DIFF_STATUS;
+	}
+	if (saved.player_x != games->player_x[g]
+			|| saved.player_y != games->player_y[g]) {
+		diff |= DIFF_PLAYER;
+	}
+	if (saved.facing_x != games->facing_x[g]
+			|| saved.facing_y != games->facing_y[g]) {
+		diff |= DIFF_FACING;
+	}
+	if (saved.score != games->score[g]) {
+		diff |= DIFF_SCORE;
+	}
+	if (saved.cheating != games->cheating[g]) {
+		diff |= DIFF_CHEATING;
+	}
+	if (status == BATCH_PLAYING && in_danger() != danger) {
+		diff |= DIFF_DANGER;
+	}
+	for (uint8_t y = 0; y < get_world_height(); y++) {
+		for (uint8_t x = 0; x < get_world_width(); x++) {
+			// game.c has already loaded the next level once this one is
+			// finished
+			if (status != BATCH_FINISHED && get_object_at(x, y)
+					!= batch_object_at(games, g, x, y)) {
+				diff |= DIFF_OBJECTS;
+			}
+			if (status != BATCH_FINISHED && is_visible(x, y)
+					!= batch_is_visible(games, g, x, y)) {
+				diff |= DIFF_VISIBLE;
+			}
+		}
+	}
+	return diff;
+}
+
+int main(int argc, char** argv) {
+	uint32_t n = argc > 1 ? atoi(argv[1]) : 1000;
+	uint32_t steps = argc > 2 ? atoi(argv[2]) : 200;
+	uint8_t level = argc > 3 ? atoi(argv[3]) : 1;
+	int32_t step_time = argc > 4 ? atoi(argv[4]) : 100;
+	random_state = argc > 5 ? atoi(argv[5]) : 1;
+	BatchGames games;
+
+	if (n == 0 || level == 0 || random_state == 0
+			|| batch_init(&games, n, level, step_time)) {
+		fprintf(stderr, "can't start %lu games of level %u\n",
+				(unsigned long)n, level);
+		return 1;
+	}
+	// actions[step * n + g] is game g's action at each step
+	uint8_t* actions = malloc((size_t)steps * n);
+	uint8_t* game_actions = malloc(steps);
+	uint8_t* danger = malloc(n);
+	if (!actions || !game_actions || !danger) {
+		return 1;
+	}
+	for (size_t i = 0; i < (size_t)steps * n; i++) {
+		actions[i] = action_table[next_random() & 31];
+	}
+	for (uint32_t step = 0; step < steps; step++) {
+		batch_step(&games, actions + (size_t)step * n);
+	}
+	batch_in_danger(&games, danger);
+
+	// what game.c prints for the terminal is thrown away
+	FILE* output = stdout;
+	stdout = fopen("/dev/null", "w");
+	if (!stdout) {
+		return 1;
+	}
+	render_set_headless(1);
+	uint32_t finished = 0, game_overs = 0, mismatches = 0;
+	for (uint32_t g = 0; g < n; g++) {
+		for (uint32_t step = 0; step < steps; step++) {
+			game_actions[step] = actions[(size_t)step * n + g];
+		}
+		int32_t status = replay(game_actions, steps, level, step_time);
+		finished += status == BATCH_FINISHED;
+		game_overs += status == BATCH_GAME_OVER;
+		uint8_t diff = compare(&games, g, status, danger[g]);
+		if (diff && mismatches++ < MAX_REPORTED) {
+			fprintf(output, "game %lu differs (0x%02X), status %ld in "
+					"game.c and %ld in the batch\n", (unsigned long)g, diff,
+					(long)status, (long)games.status[g]);
+		}
+	}
+
+	fprintf(output, "level %u, %lu games, %lu steps of %ld ms\n", level,
+			(unsigned long)n, (unsigned long)steps, (long)step_time);
+	fprintf(output, "%lu levels finished, %lu games over, %lu games "
+			"differ\n", (unsigned long)finished, (unsigned long)game_overs,
+			(unsigned long)mismatches);
+	batch_free(&games);
+	free(actions);
+	free(game_actions);
+	free(danger);
+	return mismatches != 0;
+}
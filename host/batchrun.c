@@ -0,0 +1,114 @@
+/*
+ * batchrun.c
+ *
+ * Author: William Sawyer
+ *
+ * Host program which plays many games of one level at once with random
+ * actions (see batch.h) and reports how fast they were stepped.
+ *
+ * Build and run with:
+ *     gcc -O2 -mavx2 -fopenmp -Ihost -I. -o batchrun host/batchrun.c \
+ *         host/batch.c levels.c
+ *     ./batchrun [games] [steps] [level] [step time]
+ *
+ * -mavx2 and -fopenmp can each be left out. Most actions are moves,
+ * with a few inspections and the odd bomb, as a player would make.
+ * A game which finishes the level or ends is started again.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "batch.h"
+
+// actions are drawn from this table, so moves are the most common
+static const uint8_t action_table[64] = {
+	BATCH_UP, BATCH_DOWN, BATCH_LEFT, BATCH_RIGHT,
+	BATCH_UP, BATCH_DOWN, BATCH_LEFT, BATCH_RIGHT,
+	BATCH_UP, BATCH_DOWN, BATCH_LEFT, BATCH_RIGHT,
+	BATCH_UP, BATCH_DOWN, BATCH_LEFT, BATCH_RIGHT,
+	BATCH_UP, BATCH_DOWN, BATCH_LEFT, BATCH_RIGHT,
+	BATCH_UP, BATCH_DOWN, BATCH_LEFT, BATCH_RIGHT,
+	BATCH_UP, BATCH_DOWN, BATCH_LEFT, BATCH_RIGHT,
+	BATCH_UP, BATCH_DOWN, BATCH_LEFT, BATCH_RIGHT,
+	BATCH_UP, BATCH_DOWN, BATCH_LEFT, BATCH_RIGHT,
+	BATCH_UP, BATCH_DOWN, BATCH_LEFT, BATCH_RIGHT,
+	BATCH_UP, BATCH_DOWN, BATCH_LEFT, BATCH_RIGHT,
+	BATCH_UP, BATCH_DOWN, BATCH_LEFT, BATCH_RIGHT,
+	BATCH_NONE, BATCH_NONE, BATCH_NONE, BATCH_NONE,
+	BATCH_NONE, BATCH_NONE, BATCH_NONE, BATCH_NONE,
+	BATCH_INSPECT, BATCH_INSPECT, BATCH_INSPECT, BATCH_INSPECT,
+	BATCH_INSPECT, BATCH_INSPECT, BATCH_BOMB, BATCH_CHEAT
+};
+
+// xorshift, so runs can be repeated
+static uint32_t random_state = 1;
+
+static uint32_t next_random(void) {
+	random_state ^= random_state << 13;
+	random_state ^= random_state >> 17;
+	random_state ^= random_state << 5;
+	return random_state;
+}
+
+static double seconds(void) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+int main(int argc, char** argv) {
+	uint32_t n = argc > 1 ? atoi(argv[1]) : 4096;
+	uint32_t steps = argc > 2 ? atoi(argv[2]) : 10000;
+	uint8_t level = argc > 3 ? atoi(argv[3]) : 1;
+	int32_t step_time = argc > 4 ? atoi(argv[4]) : 100;
+	BatchGames games;
+
+	if (n == 0 || level == 0 || batch_init(&games, n, level, step_time)) {
+		fprintf(stderr, "can't start %lu games of level %u\n",
+				(unsigned long)n, level);
+		return 1;
+	}
+	// a few pages of actions are drawn up front and reused, so the time
+	// measured is the stepping alone
+	uint32_t pages = 64;
+	uint8_t* actions = malloc((size_t)pages * n);
+	if (!actions) {
+		return 1;
+	}
+	for (size_t i = 0; i < (size_t)pages * n; i++) {
+		actions[i] = action_table[next_random() & 63];
+	}
+
+	uint64_t finished = 0, game_overs = 0;
+	double stepping = 0;
+	double start = seconds();
+	for (uint32_t step = 0; step < steps; step++) {
+		double before = seconds();
+		batch_step(&games, actions + (size_t)(step % pages) * n);
+		stepping += seconds() - before;
+		for (uint32_t g = 0; g < n; g++) {
+			if (games.status[g] != BATCH_PLAYING) {
+				finished += games.status[g] == BATCH_FINISHED;
+				game_overs += games.status[g] == BATCH_GAME_OVER;
+				batch_reset(&games, g);
+			}
+		}
+	}
+	double total = seconds() - start;
+
+	double game_steps = (double)n * steps;
+	printf("level %u, %lu games, %lu steps of %ld ms\n", level,
+			(unsigned long)n, (unsigned long)steps, (long)step_time);
+	printf("%llu levels finished, %llu games over\n",
+			(unsigned long long)finished, (unsigned long long)game_overs);
+	printf("stepping: %.3f s, %.1f million game steps/s\n", stepping,
+			game_steps / stepping / 1e6);
+	printf("with resets: %.3f s, %.1f million game steps/s\n", total,
+			game_steps / total / 1e6);
+	batch_free(&games);
+	free(actions);
+	return 0;
+}
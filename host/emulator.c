@@ -0,0 +1,494 @@
+/*
+ * emulator.c
+ *
+ * Author: William Sawyer
+ *
+ * See emulator.h. The command codes and formats are those sent by
+ * ledmatrix.c.
+ */
+
+#include <string.h>
+
+#include "emulator.h"
+
+#define CMD_UPDATE_ALL 0x00
+#define CMD_UPDATE_PIXEL 0x01
+#define CMD_UPDATE_ROW 0x02
+#define CMD_UPDATE_COL 0x03
+#define CMD_SHIFT_DISPLAY 0x04
+#define CMD_CLEAR_SCREEN 0x0F
+
+// CMD_SHIFT_DISPLAY directions, more than one may be given at once
+#define SHIFT_RIGHT	0x01
+#define SHIFT_LEFT	0x02
+#define SHIFT_DOWN	0x04
+#define SHIFT_UP	0x08
+
+#define ESCAPE	0x1B
+
+// terminal emulator states
+#define TERMINAL_TEXT		0
+#define TERMINAL_ESCAPE		1	// after ESC
+#define TERMINAL_SEQUENCE	2	// after ESC [
+
+static void count_command(StreamCounters* counters) {
+	counters->commands++;
+	counters->total_commands++;
+}
+
+static void end_frame(StreamCounters* counters) {
+	counters->frames++;
+	if (counters->bytes > counters->max_bytes) {
+		counters->max_bytes = counters->bytes;
+	}
+	if (counters->commands > counters->max_commands) {
+		counters->max_commands = counters->commands;
+	}
+	counters->bytes = 0;
+	counters->commands = 0;
+}
+
+/* Matrix emulator */
+
+void matrix_emulator_init(MatrixEmulator* matrix) {
+	memset(matrix, 0, sizeof(*matrix));
+	matrix->command = MATRIX_EMULATOR_IDLE;
+}
+
+// returns how many bytes follow the code of 'command', or -1 if it isn't
+// a command
+static int16_t command_length(uint8_t command) {
+	switch (command) {
+		case CMD_UPDATE_ALL:
+			return MATRIX_NUM_ROWS * MATRIX_NUM_COLUMNS;
+		case CMD_UPDATE_PIXEL:
+			return 2;
+		case CMD_UPDATE_ROW:
+			return 1 + MATRIX_NUM_COLUMNS;
+		case CMD_UPDATE_COL:
+			return 1 + MATRIX_NUM_ROWS;
+		case CMD_SHIFT_DISPLAY:
+			return 1;
+		case CMD_CLEAR_SCREEN:
+			return 0;
+		default:
+			return -1;
+	}
+}
+
+// moves everything shown one square in the given directions, the
+// squares left behind are cleared
+static void shift_display(MatrixEmulator* matrix, uint8_t directions) {
+	if (directions & SHIFT_RIGHT) {
+		for (uint8_t y = 0; y < MATRIX_NUM_ROWS; y++) {
+			memmove(&matrix->pixels[y][1], &matrix->pixels[y][0],
+					MATRIX_NUM_COLUMNS - 1);
+			matrix->pixels[y][0] = COLOUR_BLACK;
+		}
+	}
+	if (directions & SHIFT_LEFT) {
+		for (uint8_t y = 0; y < MATRIX_NUM_ROWS; y++) {
+			memmove(&matrix->pixels[y][0], &matrix->pixels[y][1],
+					MATRIX_NUM_COLUMNS - 1);
+			matrix->pixels[y][MATRIX_NUM_COLUMNS - 1] = COLOUR_BLACK;
+		}
+	}
+	if (directions & SHIFT_DOWN) {
+		memmove(&matrix->pixels[0], &matrix->pixels[1],
+				sizeof(MatrixRow) * (MATRIX_NUM_ROWS - 1));
+		memset(&matrix->pixels[MATRIX_NUM_ROWS - 1], COLOUR_BLACK,
+				sizeof(MatrixRow));
+	}
+	if (directions & SHIFT_UP) {
+		memmove(&matrix->pixels[1], &matrix->pixels[0],
+				sizeof(MatrixRow) * (MATRIX_NUM_ROWS - 1));
+		memset(&matrix->pixels[0], COLOUR_BLACK, sizeof(MatrixRow));
+	}
+}
+
+void matrix_emulator_feed(MatrixEmulator* matrix, const uint8_t* bytes,
+		size_t length) {
+	const uint8_t* end = bytes + length;
+	matrix->counters.bytes += length;
+	matrix->counters.total_bytes += length;
+
+	while (bytes < end) {
+		if (matrix->command == MATRIX_EMULATOR_IDLE) {
+			uint8_t command = *bytes++;
+			count_command(&matrix->counters);
+			if (command_length(command) < 0) {
+				matrix->errors++;
+				continue;
+			}
+			matrix->command_counts[command]++;
+			if (command == CMD_CLEAR_SCREEN) {
+				memset(matrix->pixels, COLOUR_BLACK, sizeof(MatrixData));
+			} else {
+				matrix->command = command;
+				matrix->received = 0;
+			}
+			continue;
+		}
+
+		switch (matrix->command) {
+			case CMD_UPDATE_ALL: {
+				// copy as much of the frame as has arrived in one go
+				size_t count = MATRIX_NUM_ROWS * MATRIX_NUM_COLUMNS
+						- matrix->received;
+				if (count > (size_t)(end - bytes)) {
+					count = end - bytes;
+				}
+				memcpy((uint8_t*)matrix->pixels + matrix->received, bytes,
+						count);
+				bytes += count;
+				matrix->received += count;
+				break;
+			}
+			case CMD_UPDATE_PIXEL:
+				if (matrix->received++ == 0) {
+					matrix->argument = *bytes++;
+				} else {
+					matrix->pixels[(matrix->argument >> 4) & 0x07]
+							[matrix->argument & 0x0F] = *bytes++;
+				}
+				break;
+			case CMD_UPDATE_ROW:
+				if (matrix->received++ == 0) {
+					matrix->argument = *bytes++ & 0x07;
+				} else {
+					matrix->pixels[matrix->argument][matrix->received - 2] =
+							*bytes++;
+				}
+				break;
+			case CMD_UPDATE_COL:
+				if (matrix->received++ == 0) {
+					matrix->argument = *bytes++ & 0x0F;
+				} else {
+					matrix->pixels[matrix->received - 2][matrix->argument] =
+							*bytes++;
+				}
+				break;
+			case CMD_SHIFT_DISPLAY:
+				shift_display(matrix, *bytes++);
+				matrix->received++;
+				break;
+		}
+		if (matrix->received == command_length(matrix->command)) {
+			matrix->command = MATRIX_EMULATOR_IDLE;
+		}
+	}
+}
+
+void matrix_emulator_end_frame(MatrixEmulator* matrix) {
+	end_frame(&matrix->counters);
+}
+
+char matrix_emulator_symbol(PixelColour colour) {
+	switch (colour) {
+		case COLOUR_BLACK:
+			return '.';
+		case COLOUR_RED:
+			return 'R';
+		case COLOUR_GREEN:
+			return 'G';
+		case COLOUR_YELLOW:
+			return 'Y';
+		case COLOUR_ORANGE:
+			return 'O';
+		case COLOUR_LIGHT_ORANGE:
+			return 'o';
+		case COLOUR_LIGHT_YELLOW:
+			return 'y';
+		case COLOUR_LIGHT_GREEN:
+			return 'g';
+		case COLOUR_LIGHT_RED:
+			return 'r';
+		default:
+			return '?';
+	}
+}
+
+/* Terminal emulator */
+
+// clears 'count' characters of row y from column x
+static void clear_characters(TerminalEmulator* terminal, uint8_t x,
+		uint8_t y, uint8_t count) {
+	memset(&terminal->screen[y][x], ' ', count);
+	memset(&terminal->attributes[y][x], 0, count);
+}
+
+static void clear_rows(TerminalEmulator* terminal, uint8_t from,
+		uint8_t to) {
+	for (uint8_t y = from; y <= to && y < TERMINAL_ROWS; y++) {
+		clear_characters(terminal, 0, y, TERMINAL_COLUMNS);
+	}
+}
+
+void terminal_emulator_init(TerminalEmulator* terminal) {
+	memset(terminal, 0, sizeof(*terminal));
+	for (uint8_t y = 0; y < TERMINAL_ROWS; y++) {
+		terminal->screen[y][TERMINAL_COLUMNS] = '\0';
+	}
+	clear_rows(terminal, 0, TERMINAL_ROWS - 1);
+	terminal->cursor_visible = 1;
+	terminal->scroll_bottom = TERMINAL_ROWS - 1;
+}
+
+// moves the rows from 'from' to 'to' up (if 'up' is non-zero) or down
+// by one, clearing the row left empty
+static void scroll_rows(TerminalEmulator* terminal, uint8_t from, uint8_t to,
+		uint8_t up) {
+	if (from >= to) {
+		clear_rows(terminal, from, from);
+		return;
+	}
+	for (uint8_t i = 0; i < to - from; i++) {
+		uint8_t y = up ? from + i : to - i;
+		uint8_t source = up ? y + 1 : y - 1;
+		memcpy(terminal->screen[y], terminal->screen[source], TERMINAL_COLUMNS);
+		memcpy(terminal->attributes[y], terminal->attributes[source],
+				TERMINAL_COLUMNS);
+	}
+	clear_rows(terminal, up ? to : from, up ? to : from);
+}
+
+// moves the cursor down a row, scrolling at the bottom of the scroll region
+static void line_feed(TerminalEmulator* terminal) {
+	if (terminal->cursor_y == terminal->scroll_bottom) {
+		scroll_rows(terminal, terminal->scroll_top, terminal->scroll_bottom, 1);
+	} else if (terminal->cursor_y < TERMINAL_ROWS - 1) {
+		terminal->cursor_y++;
+	}
+}
+
+// moves the cursor up a row, scrolling at the top of the scroll region
+static void reverse_line_feed(TerminalEmulator* terminal) {
+	if (terminal->cursor_y == terminal->scroll_top) {
+		scroll_rows(terminal, terminal->scroll_top, terminal->scroll_bottom, 0);
+	} else if (terminal->cursor_y > 0) {
+		terminal->cursor_y--;
+	}
+}
+
+// returns parameter i, or 'missing' if it wasn't given (or was 0 and
+// 'missing' is used in its place, as for cursor movements)
+static uint16_t parameter(TerminalEmulator* terminal, uint8_t i,
+		uint16_t missing) {
+	if (i >= terminal->num_parameters || terminal->parameters[i] == 0) {
+		return missing;
+	}
+	return terminal->parameters[i];
+}
+
+static uint8_t clamp(int16_t value, uint8_t limit) {
+	if (value < 0) {
+		return 0;
+	} else if (value >= limit) {
+		return limit - 1;
+	}
+	return value;
+}
+
+static void set_attributes(TerminalEmulator* terminal) {
+	if (terminal->num_parameters == 0) {
+		terminal->attribute = 0;
+	}
+	for (uint8_t i = 0; i < terminal->num_parameters; i++) {
+		uint16_t p = terminal->parameters[i];
+		if (p == 0) {
+			terminal->attribute = 0;
+		} else if (p == 1) {
+			terminal->attribute |= TERMINAL_BRIGHT;
+		} else if (p == 7) {
+			terminal->attribute |= TERMINAL_REVERSE;
+		} else if (p >= 30 && p <= 37) {
+			terminal->attribute = (terminal->attribute & 0x0F)
+					| ((p - 29) << 4);
+		}
+	}
+}
+
+// carries out the escape sequence ESC [ parameters 'final'
+static void run_sequence(TerminalEmulator* terminal, uint8_t final) {
+	uint8_t x = terminal->cursor_x;
+	uint8_t y = terminal->cursor_y;
+
+	if (terminal->private_mode) {
+		if (parameter(terminal, 0, 0) == 25 && (final == 'h' || final == 'l')) {
+			terminal->cursor_visible = final == 'h';
+		} else {
+			terminal->errors++;
+		}
+		return;
+	}
+	switch (final) {
+		case 'H':
+		case 'f':
+			terminal->cursor_y = clamp(parameter(terminal, 0, 1) - 1,
+					TERMINAL_ROWS);
+			terminal->cursor_x = clamp(parameter(terminal, 1, 1) - 1,
+					TERMINAL_COLUMNS);
+			break;
+		case 'A':
+			terminal->cursor_y = clamp(y - parameter(terminal, 0, 1),
+					TERMINAL_ROWS);
+			break;
+		case 'B':
+			terminal->cursor_y = clamp(y + parameter(terminal, 0, 1),
+					TERMINAL_ROWS);
+			break;
+		case 'C':
+			terminal->cursor_x = clamp(x + parameter(terminal, 0, 1),
+					TERMINAL_COLUMNS);
+			break;
+		case 'D':
+			terminal->cursor_x = clamp(x - parameter(terminal, 0, 1),
+					TERMINAL_COLUMNS);
+			break;
+		case 'J':
+			switch (parameter(terminal, 0, 0)) {
+				case 0:
+					clear_characters(terminal, x, y, TERMINAL_COLUMNS - x);
+					clear_rows(terminal, y + 1, TERMINAL_ROWS - 1);
+					break;
+				case 1:
+					if (y > 0) {
+						clear_rows(terminal, 0, y - 1);
+					}
+					clear_characters(terminal, 0, y, x + 1);
+					break;
+				default:
+					clear_rows(terminal, 0, TERMINAL_ROWS - 1);
+					break;
+			}
+			break;
+		case 'K':
+			switch (parameter(terminal, 0, 0)) {
+				case 0:
+					clear_characters(terminal, x, y, TERMINAL_COLUMNS - x);
+					break;
+				case 1:
+					clear_characters(terminal, 0, y, x + 1);
+					break;
+				default:
+					clear_characters(terminal, 0, y, TERMINAL_COLUMNS);
+					break;
+			}
+			break;
+		case 'm':
+			set_attributes(terminal);
+			break;
+		case 'r':
+			terminal->scroll_top = clamp(parameter(terminal, 0, 1) - 1,
+					TERMINAL_ROWS);
+			terminal->scroll_bottom = clamp(parameter(terminal, 1,
+					TERMINAL_ROWS) - 1, TERMINAL_ROWS);
+			terminal->cursor_x = 0;
+			terminal->cursor_y = 0;
+			break;
+		default:
+			terminal->errors++;
+			break;
+	}
+}
+
+void terminal_emulator_feed(TerminalEmulator* terminal, const uint8_t* bytes,
+		size_t length) {
+	const uint8_t* end = bytes + length;
+	terminal->counters.bytes += length;
+	terminal->counters.total_bytes += length;
+
+	while (bytes < end) {
+		uint8_t c = *bytes++;
+		switch (terminal->state) {
+			case TERMINAL_TEXT:
+				if (c >= ' ' && c < 0x7F) {
+					if (terminal->cursor_x == TERMINAL_COLUMNS) {
+						// wrap onto the next line
+						terminal->cursor_x = 0;
+						line_feed(terminal);
+					}
+					terminal->screen[terminal->cursor_y][terminal->cursor_x] = c;
+					terminal->attributes[terminal->cursor_y][terminal->cursor_x++]
+							= terminal->attribute;
+					break;
+				}
+				count_command(&terminal->counters);
+				if (c == ESCAPE) {
+					terminal->state = TERMINAL_ESCAPE;
+				} else if (c == '\r') {
+					terminal->cursor_x = 0;
+				} else if (c == '\n') {
+					line_feed(terminal);
+				} else if (c == '\b' && terminal->cursor_x > 0) {
+					terminal->cursor_x--;
+				}
+				break;
+			case TERMINAL_ESCAPE:
+				terminal->state = TERMINAL_TEXT;
+				if (c == '[') {
+					terminal->state = TERMINAL_SEQUENCE;
+					terminal->private_mode = 0;
+					terminal->num_parameters = 0;
+					memset(terminal->parameters, 0, sizeof(terminal->parameters));
+				} else if (c == 'D') {
+					line_feed(terminal);
+				} else if (c == 'M') {
+					reverse_line_feed(terminal);
+				} else {
+					terminal->errors++;
+				}
+				break;
+			case TERMINAL_SEQUENCE:
+				if (c == '?') {
+					terminal->private_mode = 1;
+				} else if (c >= '0' && c <= '9') {
+					if (terminal->num_parameters == 0) {
+						terminal->num_parameters = 1;
+					}
+					if (terminal->num_parameters <= TERMINAL_MAX_PARAMETERS) {
+						uint16_t* p =
+								&terminal->parameters[terminal->num_parameters - 1];
+						*p = *p * 10 + c - '0';
+					}
+				} else if (c == ';') {
+					if (terminal->num_parameters == 0) {
+						terminal->num_parameters = 1;
+					}
+					terminal->num_parameters++;
+				} else {
+					if (terminal->num_parameters > TERMINAL_MAX_PARAMETERS) {
+						terminal->num_parameters = TERMINAL_MAX_PARAMETERS;
+					}
+					run_sequence(terminal, c);
+					terminal->state = TERMINAL_TEXT;
+				}
+				break;
+		}
+	}
+}
+
+void terminal_emulator_end_frame(TerminalEmulator* terminal) {
+	end_frame(&terminal->counters);
+}
+
+const char* terminal_emulator_row(TerminalEmulator* terminal, uint8_t y) {
+	return terminal->screen[clamp(y - 1, TERMINAL_ROWS)];
+}
+
+uint8_t terminal_emulator_find(TerminalEmulator* terminal, const char* text,
+		uint8_t* x, uint8_t* y) {
+	for (uint8_t row = 0; row < TERMINAL_ROWS; row++) {
+		const char* found = strstr(terminal->screen[row], text);
+		if (found) {
+			if (x) {
+				*x = found - terminal->screen[row] + 1;
+			}
+			if (y) {
+				*y = row + 1;
+			}
+			return 1;
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,126 @@
+/*
+ * emulator.h
+ *
+ * Author: William Sawyer
+ *
+ * Host models of what the player sees. The matrix emulator takes the
+ * SPI byte stream sent by ledmatrix.c and keeps the colours the LED
+ * matrix would be showing. The terminal emulator takes the byte stream
+ * sent to the serial terminal (the escape sequences from terminalio.c
+ * and everything printed with printf_P) and keeps the characters a
+ * VT100 terminal would be showing.
+ *
+ * Both count the bytes and commands they are given. The caller decides
+ * what a frame is (usually one pass of the game loop) and calls the
+ * end_frame function after each one, which keeps the largest and total
+ * counts over all frames.
+ */
+
+#ifndef EMULATOR_H_
+#define EMULATOR_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "ledmatrix.h"
+
+typedef struct {
+	uint32_t frames;
+	uint32_t bytes;			// in the current frame
+	uint32_t commands;		// in the current frame
+	uint32_t max_bytes;		// most in any one frame
+	uint32_t max_commands;	// most in any one frame
+	uint64_t total_bytes;
+	uint64_t total_commands;
+} StreamCounters;
+
+typedef struct {
+	MatrixData pixels;		// pixels[y][x], y = 0 is the bottom row
+	uint8_t command;		// command being received, or MATRIX_EMULATOR_IDLE
+	uint8_t received;		// bytes of the command received after its code
+	uint8_t argument;		// the row or column being updated
+	uint32_t command_counts[16];	// how many of each command were received
+	uint32_t errors;		// unknown commands received
+	StreamCounters counters;
+} MatrixEmulator;
+
+#define MATRIX_EMULATOR_IDLE	0xFF
+
+// The terminal is larger than the usual 80x24 so diagnostic reports
+// printed below the game don't scroll it.
+#define TERMINAL_COLUMNS	80
+#define TERMINAL_ROWS		40
+
+// Terminal cell attributes
+#define TERMINAL_REVERSE	0x01
+#define TERMINAL_BRIGHT		0x02
+// the foreground colour (30 to 37) less 29 is kept in the top nibble,
+// 0 is the default colour
+#define TERMINAL_FOREGROUND(attribute)	((attribute) >> 4)
+
+#define TERMINAL_MAX_PARAMETERS	4
+
+typedef struct {
+	// each row is kept as a string
+	char screen[TERMINAL_ROWS][TERMINAL_COLUMNS + 1];
+	uint8_t attributes[TERMINAL_ROWS][TERMINAL_COLUMNS];
+	uint8_t cursor_x, cursor_y;	// from 0, top left
+	uint8_t cursor_visible;
+	uint8_t attribute;			// given to characters as they are printed
+	uint8_t scroll_top, scroll_bottom;	// inclusive, from 0
+	uint8_t state;
+	uint8_t private_mode;		// the sequence started with ESC [ ?
+	uint8_t num_parameters;
+	uint16_t parameters[TERMINAL_MAX_PARAMETERS];
+	uint32_t errors;			// unknown escape sequences received
+	StreamCounters counters;
+} TerminalEmulator;
+
+/*
+ * Set the matrix to black and the emulator ready for a command.
+ */
+void matrix_emulator_init(MatrixEmulator* matrix);
+
+/*
+ * Process 'length' bytes of the SPI stream.
+ */
+void matrix_emulator_feed(MatrixEmulator* matrix, const uint8_t* bytes,
+		size_t length);
+
+void matrix_emulator_end_frame(MatrixEmulator* matrix);
+
+/*
+ * Return a character standing for a colour, for printing the matrix -
+ * '.' for black, the first letter of the colour's name (lower case for
+ * the light colours) or '?' if it isn't one of pixel_colour.h's colours.
+ */
+char matrix_emulator_symbol(PixelColour colour);
+
+/*
+ * Clear the terminal, with the cursor at the top left.
+ */
+void terminal_emulator_init(TerminalEmulator* terminal);
+
+/*
+ * Process 'length' bytes of the terminal stream.
+ */
+void terminal_emulator_feed(TerminalEmulator* terminal, const uint8_t* bytes,
+		size_t length);
+
+void terminal_emulator_end_frame(TerminalEmulator* terminal);
+
+/*
+ * Return the text of row 'y' (from 1, as for move_terminal_cursor),
+ * with trailing spaces.
+ */
+const char* terminal_emulator_row(TerminalEmulator* terminal, uint8_t y);
+
+/*
+ * Look for 'text' on the screen. Returns 1 and sets *x and *y (from 1)
+ * to where it starts if it is found, returns 0 otherwise. x and y may
+ * be NULL.
+ */
+uint8_t terminal_emulator_find(TerminalEmulator* terminal, const char* text,
+		uint8_t* x, uint8_t* y);
+
+#endif /* EMULATOR_H_ */
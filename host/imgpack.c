@@ -0,0 +1,170 @@
+/*
+ * imgpack.c
+ *
+ * Author: William Sawyer
+ *
+ * Host tool which converts a text drawing of a 16x8 LED matrix screen
+ * into the compressed image format read by image.c, printed as a C
+ * array to be pasted into images.c.
+ *
+ * Build and run with:
+ *     gcc -o imgpack host/imgpack.c
+ *     ./imgpack name < images/name.txt
+ *
+ * The input is a "palette" line listing a character and a hexadecimal
+ * PixelColour for each colour used (at most 4), followed by 8 lines of
+ * 16 characters, top row first. Lines starting with # are ignored.
+ *     palette . 00 G F0 R 0F
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#define COLUMNS		16
+#define ROWS		8
+#define MAX_COLOURS	4
+#define PLANE_BYTES	(COLUMNS * ROWS / 8)
+#define MAX_RUN		128
+
+static char palette_keys[MAX_COLOURS];
+static unsigned palette_colours[MAX_COLOURS];
+static int num_colours;
+
+static void fail(const char* message, int line) {
+	fprintf(stderr, "imgpack: line %d: %s\n", line, message);
+	exit(1);
+}
+
+// returns the palette index of character c, or -1 if it is not in the palette
+static int palette_index(char c) {
+	for (int i = 0; i < num_colours; i++) {
+		if (palette_keys[i] == c) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+// run length encodes a bitplane into out, returning the encoded length.
+// A control byte with the top bit set repeats the following byte 
+// (control & 0x7F) + 1 times, otherwise (control + 1) literal bytes follow.
+static int encode_plane(const uint8_t* plane, uint8_t* out) {
+	int length = 0;
+	int i = 0;
+	while (i < PLANE_BYTES) {
+		int run = 1;
+		while (i + run < PLANE_BYTES && run < MAX_RUN 
+				&& plane[i + run] == plane[i]) {
+			run++;
+		}
+		if (run >= 2) {
+			out[length++] = 0x80 | (run - 1);
+			out[length++] = plane[i];
+			i += run;
+		} else {
+			// gather literals until the next run of 3 or more (a run of
+			// 2 costs as much as two literals)
+			int start = i;
+			while (i < PLANE_BYTES && i - start < MAX_RUN) {
+				if (i + 2 < PLANE_BYTES && plane[i] == plane[i + 1] 
+						&& plane[i] == plane[i + 2]) {
+					break;
+				}
+				i++;
+			}
+			out[length++] = i - start - 1;
+			memcpy(&out[length], &plane[start], i - start);
+			length += i - start;
+		}
+	}
+	return length;
+}
+
+int main(int argc, char** argv) {
+	char line[256];
+	char rows[ROWS][COLUMNS];
+	int num_rows = 0;
+	int line_number = 0;
+	
+	if (argc != 2) {
+		fprintf(stderr, "usage: imgpack name < image.txt\n");
+		return 1;
+	}
+	
+	while (fgets(line, sizeof(line), stdin)) {
+		line_number++;
+		line[strcspn(line, "\r\n")] = '\0';
+		if (line[0] == '#' || line[0] == '\0') {
+			continue;
+		}
+		if (strncmp(line, "palette", 7) == 0) {
+			char* token = strtok(line + 7, " \t");
+			while (token) {
+				char* colour = strtok(NULL, " \t");
+				if (strlen(token) != 1 || !colour) {
+					fail("palette entries must be a character and a colour", 
+							line_number);
+				}
+				if (num_colours == MAX_COLOURS) {
+					fail("too many colours", line_number);
+				}
+				palette_keys[num_colours] = token[0];
+				palette_colours[num_colours++] = strtoul(colour, NULL, 16);
+				token = strtok(NULL, " \t");
+			}
+			continue;
+		}
+		if (num_rows == ROWS) {
+			fail("too many rows", line_number);
+		}
+		if (strlen(line) != COLUMNS) {
+			fail("rows must be 16 characters", line_number);
+		}
+		memcpy(rows[num_rows++], line, COLUMNS);
+	}
+	if (num_rows != ROWS || num_colours == 0) {
+		fail("expected a palette and 8 rows", line_number);
+	}
+	
+	int planes = num_colours > 2 ? 2 : 1;
+	uint8_t plane_data[2][PLANE_BYTES] = {{0}};
+	
+	// pixels are stored in the order the matrix expects them, which is
+	// the bottom row first
+	int pixel = 0;
+	for (int y = 0; y < ROWS; y++) {
+		for (int x = 0; x < COLUMNS; x++) {
+			int index = palette_index(rows[ROWS - 1 - y][x]);
+			if (index < 0) {
+				fail("character not in palette", 0);
+			}
+			for (int p = 0; p < planes; p++) {
+				if (index & (1 << p)) {
+					plane_data[p][pixel / 8] |= 0x80 >> (pixel % 8);
+				}
+			}
+			pixel++;
+		}
+	}
+	
+	printf("const uint8_t %s[] PROGMEM = \n\t\t{\n", argv[1]);
+	printf("\t\t\t%d,\t// bitplanes\n\t\t\t", planes);
+	for (int i = 0; i < (1 << planes); i++) {
+		printf("0x%02X,%s", i < num_colours ? palette_colours[i] : 0,
+				i == (1 << planes) - 1 ? "\t// palette\n" : " ");
+	}
+	for (int p = 0; p < planes; p++) {
+		uint8_t encoded[PLANE_BYTES * 2];
+		int length = encode_plane(plane_data[p], encoded);
+		printf("\t\t\t%d,\t// plane %d length\n\t\t\t", length, p);
+		for (int i = 0; i < length; i++) {
+			int last = p == planes - 1 && i == length - 1;
+			printf("0x%02X%s", encoded[i], last ? "\n" 
+					: i == length - 1 ? ",\n" : ", ");
+		}
+	}
+	printf("\t\t};\n");
+	return 0;
+}
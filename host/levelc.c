@@ -0,0 +1,291 @@
+/*
+ * levelc.c
+ *
+ * Author: William Sawyer
+ *
+ * Host tool which compiles the text maps in levels/ into levels.c, the
+ * packed layouts described in levels.h.
+ *
+ * Build and run with:
+ *     gcc -Ihost -I. -o levelc host/levelc.c
+ *     ./levelc levels/level1.txt levels/level2.txt levels/level3.txt \
+ *         > levels.c
+ *
+ * Each map is drawn top row first, one character per square:
+ *     .  empty     +  breakable wall     #  unbreakable wall
+ *     D  diamond   X  the exit
+ * Diamonds and the exit sit on empty terrain. Lines starting with ; are
+ * comments. The player starts at the bottom left square.
+ *
+ * The diamond list, the exit and the squares the player can see at the
+ * start (what discoverable_dfs() reveals from the start square) are
+ * worked out here, so loading a level is a straight copy. A map which
+ * can't be played is rejected and nothing is written: rows of different
+ * lengths, a world smaller than the display or larger than
+ * WORLD_MAX_WIDTH x WORLD_MAX_HEIGHT, a number of squares which isn't a
+ * multiple of 8, unknown characters, anything but one exit, more than
+ * MAX_DIAMONDS diamonds, a start square which isn't empty, or a
+ * diamond or exit which can't be reached from the start without going
+ * through unbreakable walls.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "levels.h"
+#include "display.h"
+
+// the most levels compiled at once
+#define MAX_LEVELS	16
+
+typedef struct {
+	const char* path;
+	uint8_t width, height;
+	uint8_t exit_x, exit_y;
+	uint8_t num_diamonds;
+	uint8_t diamonds[MAX_DIAMONDS][2];
+	uint8_t terrain[WORLD_MAX_WIDTH * WORLD_MAX_HEIGHT];
+	uint8_t visible[WORLD_MAX_WIDTH * WORLD_MAX_HEIGHT];
+} LevelMap;
+
+static LevelMap maps[MAX_LEVELS];
+
+static void fail(const char* path, int line, const char* message) {
+	if (line) {
+		fprintf(stderr, "levelc: %s:%d: %s\n", path, line, message);
+	} else {
+		fprintf(stderr, "levelc: %s: %s\n", path, message);
+	}
+	exit(1);
+}
+
+// reads a map, the rows are kept top row first until all have been read
+static void read_map(LevelMap* map, const char* path) {
+	char rows[WORLD_MAX_HEIGHT][WORLD_MAX_WIDTH + 1];
+	int row_lines[WORLD_MAX_HEIGHT];
+	char line[256];
+	int line_number = 0;
+	int height = 0;
+	int width = -1;
+	FILE* file = fopen(path, "r");
+	if (!file) {
+		fail(path, 0, "can't be opened");
+	}
+	map->path = path;
+	while (fgets(line, sizeof(line), file)) {
+		line_number++;
+		size_t length = strcspn(line, "\r\n");
+		line[length] = '\0';
+		if (length == 0 || line[0] == ';') {
+			continue;
+		}
+		if (length > WORLD_MAX_WIDTH) {
+			fail(path, line_number, "row is wider than WORLD_MAX_WIDTH");
+		}
+		if (width >= 0 && (int)length != width) {
+			fail(path, line_number, "row is a different length to the first");
+		}
+		if (height == WORLD_MAX_HEIGHT) {
+			fail(path, line_number, "more rows than WORLD_MAX_HEIGHT");
+		}
+		width = length;
+		row_lines[height] = line_number;
+		strcpy(rows[height++], line);
+	}
+	fclose(file);
+	if (height == 0) {
+		fail(path, 0, "no rows");
+	}
+	if (width < WIDTH || height < HEIGHT) {
+		fail(path, 0, "world is smaller than the display");
+	}
+	if ((width * height) % 8) {
+		fail(path, 0, "number of squares isn't a multiple of 8");
+	}
+	map->width = width;
+	map->height = height;
+	if (rows[height - 1][0] != '.') {
+		fail(path, row_lines[height - 1],
+				"the start square (bottom left) must be empty");
+	}
+
+	uint8_t exits = 0;
+	for (int y = 0; y < height; y++) {
+		// the file is top row first, y = 0 is the bottom row
+		const char* row = rows[height - 1 - y];
+		int line_number = row_lines[height - 1 - y];
+		for (int x = 0; x < width; x++) {
+			uint8_t* terrain = &map->terrain[y * width + x];
+			switch (row[x]) {
+				case '.':
+					*terrain = TERRAIN_EMPTY;
+					break;
+				case '+':
+					*terrain = TERRAIN_BREAKABLE;
+					break;
+				case '#':
+					*terrain = TERRAIN_UNBREAKABLE;
+					break;
+				case 'D':
+					*terrain = TERRAIN_EMPTY;
+					if (map->num_diamonds == MAX_DIAMONDS) {
+						fail(path, line_number, "more than MAX_DIAMONDS diamonds");
+					}
+					map->diamonds[map->num_diamonds][0] = x;
+					map->diamonds[map->num_diamonds++][1] = y;
+					break;
+				case 'X':
+					*terrain = TERRAIN_EMPTY;
+					exits++;
+					map->exit_x = x;
+					map->exit_y = y;
+					break;
+				default:
+					fail(path, line_number, "unknown square");
+			}
+		}
+	}
+	if (exits != 1) {
+		fail(path, 0, "there must be exactly one exit");
+	}
+}
+
+// marks what discoverable_dfs(0, 0) reveals at the start of the level:
+// every open square joined to the start and the squares next to them
+static void find_visible(LevelMap* map) {
+	static uint16_t stack[WORLD_MAX_WIDTH * WORLD_MAX_HEIGHT];
+	static const int8_t directions[4][2] = {{0,1}, {0,-1}, {1,0}, {-1,0}};
+	uint16_t depth = 0;
+	memset(map->visible, 0, sizeof(map->visible));
+	map->visible[0] = 1;
+	stack[depth++] = 0;
+	while (depth) {
+		uint16_t i = stack[--depth];
+		int x = i % map->width;
+		int y = i / map->width;
+		for (int d = 0; d < 4; d++) {
+			int x_adj = x + directions[d][0];
+			int y_adj = y + directions[d][1];
+			if (x_adj < 0 || x_adj >= map->width || y_adj < 0
+					|| y_adj >= map->height) {
+				continue;
+			}
+			uint16_t adj = y_adj * map->width + x_adj;
+			if (!map->visible[adj]) {
+				map->visible[adj] = 1;
+				// diamonds and the exit are open too
+				if (map->terrain[adj] == TERRAIN_EMPTY) {
+					stack[depth++] = adj;
+				}
+			}
+		}
+	}
+}
+
+// fails if a diamond or the exit can't be reached from the start square
+// through empty squares and breakable walls (which bombs clear)
+static void check_reachable(const LevelMap* map) {
+	static uint16_t stack[WORLD_MAX_WIDTH * WORLD_MAX_HEIGHT];
+	static uint8_t reached[WORLD_MAX_WIDTH * WORLD_MAX_HEIGHT];
+	static const int8_t directions[4][2] = {{0,1}, {0,-1}, {1,0}, {-1,0}};
+	uint16_t depth = 0;
+	memset(reached, 0, sizeof(reached));
+	reached[0] = 1;
+	stack[depth++] = 0;
+	while (depth) {
+		uint16_t i = stack[--depth];
+		int x = i % map->width;
+		int y = i / map->width;
+		for (int d = 0; d < 4; d++) {
+			int x_adj = x + directions[d][0];
+			int y_adj = y + directions[d][1];
+			if (x_adj < 0 || x_adj >= map->width || y_adj < 0
+					|| y_adj >= map->height) {
+				continue;
+			}
+			uint16_t adj = y_adj * map->width + x_adj;
+			if (!reached[adj]
+					&& map->terrain[adj] != TERRAIN_UNBREAKABLE) {
+				reached[adj] = 1;
+				stack[depth++] = adj;
+			}
+		}
+	}
+	for (int d = 0; d < map->num_diamonds; d++) {
+		if (!reached[map->diamonds[d][1] * map->width
+				+ map->diamonds[d][0]]) {
+			fail(map->path, 0, "a diamond can't be reached from the start");
+		}
+	}
+	if (!reached[map->exit_y * map->width + map->exit_x]) {
+		fail(map->path, 0, "the exit can't be reached from the start");
+	}
+}
+
+// prints 'count' bytes as the body of a C array, 12 to a line
+static void print_bytes(const uint8_t* bytes, int count) {
+	printf("\t\t{\n");
+	for (int i = 0; i < count; i++) {
+		printf("%s0x%02X%s", i % 12 ? " " : "\t\t\t", bytes[i],
+				i == count - 1 ? "\n" : i % 12 == 11 ? ",\n" : ",");
+	}
+	printf("\t\t};\n\n");
+}
+
+static void print_map(const LevelMap* map, int number) {
+	uint16_t squares = map->width * map->height;
+	uint8_t packed[WORLD_MAX_WIDTH * WORLD_MAX_HEIGHT / 4];
+	memset(packed, 0, sizeof(packed));
+	for (uint16_t i = 0; i < squares; i++) {
+		packed[i >> 2] |= map->terrain[i] << ((i & 3) << 1);
+	}
+	printf("static const uint8_t level_%d_terrain[] PROGMEM = \n", number);
+	print_bytes(packed, squares / 4);
+	memset(packed, 0, sizeof(packed));
+	for (uint16_t i = 0; i < squares; i++) {
+		packed[i >> 3] |= map->visible[i] << (i & 7);
+	}
+	printf("static const uint8_t level_%d_visible[] PROGMEM = \n", number);
+	print_bytes(packed, squares / 8);
+}
+
+int main(int argc, char** argv) {
+	int count = argc - 1;
+	if (count < 1 || count > MAX_LEVELS) {
+		fprintf(stderr, "usage: levelc level1.txt ... > levels.c\n");
+		return 1;
+	}
+	// everything is checked before anything is written
+	for (int i = 0; i < count; i++) {
+		read_map(&maps[i], argv[i + 1]);
+		check_reachable(&maps[i]);
+		find_visible(&maps[i]);
+	}
+
+	printf("/*\n * levels.c\n *\n * Author: William Sawyer\n *\n"
+			" * Level layouts, see levels.h for the format. Generated by\n"
+			" * host/levelc.c from the maps in levels/, edit those instead.\n"
+			" */\n\n");
+	printf("#include <avr/pgmspace.h>\n\n#include \"levels.h\"\n\n");
+	printf("#if NUM_LEVELS != %d\n#error \"NUM_LEVELS doesn't match the "
+			"number of maps\"\n#endif\n\n", count);
+	for (int i = 0; i < count; i++) {
+		print_map(&maps[i], i + 1);
+	}
+	printf("const Level levels[NUM_LEVELS] PROGMEM = \n\t\t{\n");
+	for (int i = 0; i < count; i++) {
+		const LevelMap* map = &maps[i];
+		printf("\t\t\t{%u, %u, %u, %u, %u, {", map->width, map->height,
+				map->exit_x, map->exit_y, map->num_diamonds);
+		for (int d = 0; d < map->num_diamonds; d++) {
+			printf("%s{%u, %u}", d ? ", " : "", map->diamonds[d][0],
+					map->diamonds[d][1]);
+		}
+		printf("}, level_%d_terrain, level_%d_visible}%s\n", i + 1, i + 1,
+				i == count - 1 ? "" : ",");
+	}
+	printf("\t\t};\n");
+	return 0;
+}
@@ -0,0 +1,668 @@
+/*
+ * lockstep.c
+ *
+ * Author: William Sawyer
+ *
+ * Host program which checks the firmware against the host build. Random
+ * input traces are played through the host build of the game and, side
+ * by side, through the firmware running on simavr. What each sends to
+ * the LED matrix (SPI) and the terminal (UART) is compared byte for byte
+ * as the firmware sends it, and every few events the whole game state
+ * is compared as well, with the snapshot frame (see snapshot.h) the q key
+ * asks for. The first difference stops the run, and is reported along
+ * with the trace which led to it, as a script for sim.c.
+ *
+ * The firmware must be built with GAME_CLOCK_MANUAL defined to 1, so
+ * that game time only moves on when the trace says so (see gameclock.h).
+ * Build and run with:
+ *     avr-gcc -mmcu=atmega324a -Os -DGAME_CLOCK_MANUAL=1 -o lockstep.elf \
+ *         *.c
+ *     gcc -O2 -DGAME_CLOCK_MANUAL=1 -Ihost -I. $(pkg-config --cflags \
+ *         simavr) -o lockstep host/lockstep.c host/spi.c host/storage.c \
+ *         host/emulator.c game.c display.c levels.c gameclock.c \
+ *         ledmatrix.c image.c images.c terminalio.c save.c marquee.c \
+ *         render.c snapshot.c $(pkg-config --libs simavr) -lelf
+ *     ./lockstep [-m mcu] lockstep.elf [traces] [events] [seed]
+ *
+ * A trace starts a new game with s, then plays random events: moves,
+ * inspections, bombs, cheat mode and waits, a wait being a run of .
+ * keys, each of which moves game time on 1 ms. Both builds are given the
+ * keys in the same order, the host build as one pass of the game loop
+ * in project.c for each key. The firmware is given them as fast as the
+ * serial port allows, except that it is left to finish what it is doing
+ * after every key other than . and while the level is changing, when
+ * how many passes of the game loop it makes could matter. The joystick
+ * is held in the middle and the buttons are never pushed.
+ *
+ * The host build's pass of the game loop, host_pass(), is a copy of the
+ * loop in play_game() rather than the loop itself, so it has to be kept
+ * in step with project.c by hand. It leaves out the diamond detector and
+ * danger lights, the seven segment display, high score tracking, batch
+ * input (the b key), the bot and the joystick. The lights and display
+ * aren't on the SPI or UART, so aren't compared, but the rest would
+ * show up as differences if a trace used them.
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+#include <simavr/sim_avr.h>
+#include <simavr/sim_elf.h>
+#include <simavr/sim_io.h>
+#include <simavr/avr_uart.h>
+#include <simavr/avr_spi.h>
+#include <simavr/avr_adc.h>
+
+#include "game.h"
+#include "gameclock.h"
+#include "terminalio.h"
+#include "serialio.h"
+#include "save.h"
+#include "render.h"
+#include "snapshot.h"
+
+#define BAUD_RATE		19200
+#define BYTE_US			(10 * 1000000L / BAUD_RATE)	// one byte on the wire
+
+// the firmware is taken to have finished what it is doing once it has
+// sent nothing for this long
+#define SETTLE_US		2000
+
+// the longest the firmware is given to send what the host build did, or
+// to take input again after an XOFF, before it is taken to have stopped
+#define CATCH_UP_US		2000000L
+
+// how long the firmware is left to boot up to the start screen
+#define BOOT_US			50000L
+
+// the most events in a trace
+#define MAX_EVENTS		1000
+
+// the game state is compared after this many events, and at the end
+#define SNAPSHOT_EVERY	8
+
+// keys are drawn from this table, with the odd bomb and change of cheat
+// mode, . standing for a wait
+static const char event_table[32] = "wwwwaaaassssddddwdeee........  c";
+
+// xorshift, so runs can be repeated
+static uint32_t random_state;
+
+static uint32_t next_random(void) {
+	random_state ^= random_state << 13;
+	random_state ^= random_state >> 17;
+	random_state ^= random_state << 5;
+	return random_state;
+}
+
+// an event is a key, or for . a wait of 'ms' milliseconds
+typedef struct {
+	char key;
+	uint16_t ms;
+} Event;
+
+static Event trace[MAX_EVENTS];
+static int16_t num_events;
+static int16_t event_number; // being played, -1 while the game starts
+
+// What the host build sent, in full, and how much of it the firmware has
+// matched so far. The UART stream leaves out XON and XOFF.
+typedef struct {
+	const char* name;
+	uint8_t* bytes;
+	size_t length, size;
+	size_t checked;
+	uint8_t* actual;		// what the firmware sent, up to 'checked' + 1
+	size_t* event_start;	// length before each event was played
+} Stream;
+
+static Stream spi = {"SPI"};
+static Stream uart = {"UART"};
+
+// where the snapshot frames the host build sent start in uart
+static size_t frame_start[MAX_EVENTS / SNAPSHOT_EVERY + 2];
+static uint16_t num_frames;
+
+// the first difference found
+typedef struct {
+	Stream* stream;		// NULL if there hasn't been one
+	size_t offset;
+	int actual;			// -1 if the firmware sent nothing
+} Divergence;
+
+static Divergence divergence;
+
+static uint8_t capturing;		// the firmware's output is being compared
+static uint8_t host_game_over;	// anything the firmware sends after the
+								// host build's output is the game over
+
+static avr_t* avr;
+static elf_firmware_t firmware;
+static avr_irq_t* uart_input;
+static avr_cycle_count_t last_output_cycle;
+static uint8_t input_stopped;	// the firmware has sent XOFF
+
+static uint64_t bytes_compared;
+
+extern void (*spi_byte_hook)(uint8_t byte);
+
+static void append(Stream* stream, uint8_t byte) {
+	if (stream->length == stream->size) {
+		stream->size = stream->size ? stream->size * 2 : 4096;
+		stream->bytes = realloc(stream->bytes, stream->size);
+		stream->actual = realloc(stream->actual, stream->size + 1);
+		if (!stream->bytes || !stream->actual) {
+			fprintf(stderr, "lockstep: out of memory\n");
+			exit(2);
+		}
+	}
+	stream->bytes[stream->length++] = byte;
+}
+
+static void reset_stream(Stream* stream) {
+	if (!stream->event_start) {
+		stream->event_start = calloc(MAX_EVENTS, sizeof(size_t));
+		append(stream, 0);
+	}
+	stream->length = 0;
+	stream->checked = 0;
+}
+
+/*
+ * The host build. What it prints is sent to the terminal with \n turned
+ * into \r\n as uart_put_char() does, the snapshot frame goes straight
+ * out as on the firmware.
+ */
+
+static uint8_t host_level;
+
+// the game clock is the only clock the host build has
+uint32_t get_current_time(void) {
+	return get_game_time();
+}
+
+int8_t serial_put_raw(uint8_t c) {
+	append(&uart, c);
+	return 0;
+}
+
+static ssize_t write_terminal(void* cookie, const char* buffer, size_t size) {
+	(void) cookie;
+	for (size_t i = 0; i < size; i++) {
+		if (buffer[i] == '\n') {
+			append(&uart, '\r');
+		}
+		append(&uart, buffer[i]);
+	}
+	return size;
+}
+
+static void spi_sent(uint8_t byte) {
+	append(&spi, byte);
+}
+
+// one pass of the game loop in play_game() with 'key' received, or with
+// nothing received if 'key' is 0
+static void host_pass(char key) {
+	switch (key) {
+		case 'w':
+			move_player(0, 1);
+			break;
+		case 'a':
+			move_player(-1, 0);
+			break;
+		case 's':
+			move_player(0, -1);
+			break;
+		case 'd':
+			move_player(1, 0);
+			break;
+		case 'e':
+			inspect_facing();
+			break;
+		case 'c':
+			toggle_cheat();
+			break;
+		case ' ':
+			plant_bomb(get_game_time());
+			break;
+		case 'q':
+			num_frames++;
+			snapshot_send();
+			break;
+		case '.':
+			game_clock_advance(1);
+			break;
+	}
+	if (get_level() != host_level) {
+		host_level = get_level();
+		update_input_status(0, 0, 0);
+	}
+	save_update();
+	update_game(get_game_time());
+	render_flush();
+	if (changing_level() && key) {
+		// the firmware is left to finish the level change, and the steps
+		// which don't wait for the game clock are made on passes of the
+		// game loop with nothing received
+		for (uint8_t i = 0; i < 3; i++) {
+			host_pass(0);
+		}
+	}
+}
+
+// new_game() and the start of play_game()
+static void host_start(void) {
+	clear_terminal();
+	game_clock_start();
+	initialise_game(0, 0);
+	save_start();
+	host_level = get_level();
+	update_input_status(0, 0, 0);
+	host_pass(0);
+}
+
+/*
+ * The firmware.
+ */
+
+static void diverge(Stream* stream, int actual) {
+	if (!divergence.stream) {
+		divergence.stream = stream;
+		divergence.offset = stream->checked;
+		divergence.actual = actual;
+	}
+}
+
+static void check_byte(Stream* stream, uint8_t byte) {
+	last_output_cycle = avr->cycle;
+	if (!capturing || divergence.stream) {
+		return;
+	}
+	if (stream->checked < stream->length) {
+		stream->actual[stream->checked] = byte;
+		if (stream->bytes[stream->checked] != byte) {
+			diverge(stream, byte);
+			return;
+		}
+		stream->checked++;
+		bytes_compared++;
+	} else if (!host_game_over) {
+		stream->actual[stream->checked] = byte;
+		diverge(stream, byte);
+	}
+}
+
+static void uart_output(struct avr_irq_t* irq, uint32_t value, void* param) {
+	if (value == XOFF) {
+		input_stopped = 1;
+	} else if (value == XON) {
+		input_stopped = 0;
+	} else {
+		check_byte(&uart, value);
+	}
+}
+
+static void spi_output(struct avr_irq_t* irq, uint32_t value, void* param) {
+	check_byte(&spi, value);
+}
+
+static avr_cycle_count_t us_to_cycles(uint32_t us) {
+	return (avr_cycle_count_t)us * avr->frequency / 1000000;
+}
+
+// runs the firmware for 'us' microseconds, or until there is a difference
+static void firmware_run(uint32_t us) {
+	avr_cycle_count_t end = avr->cycle + us_to_cycles(us);
+	while (avr->cycle < end && !divergence.stream) {
+		int state = avr_run(avr);
+		if (state == cpu_Done || state == cpu_Crashed) {
+			fprintf(stderr, "lockstep: the firmware stopped running\n");
+			exit(2);
+		}
+	}
+}
+
+// runs the firmware until it has sent nothing for SETTLE_US
+static void firmware_settle(void) {
+	last_output_cycle = avr->cycle;
+	while (!divergence.stream
+			&& avr->cycle < last_output_cycle + us_to_cycles(SETTLE_US)) {
+		firmware_run(SETTLE_US / 4);
+	}
+}
+
+// runs the firmware until it has sent everything the host build has,
+// a missing byte is a difference
+static void firmware_catch_up(void) {
+	avr_cycle_count_t end = avr->cycle + us_to_cycles(CATCH_UP_US);
+	while (!divergence.stream && avr->cycle < end
+			&& (spi.checked < spi.length || uart.checked < uart.length)) {
+		firmware_run(BYTE_US);
+	}
+	if (spi.checked < spi.length) {
+		diverge(&spi, -1);
+	} else if (uart.checked < uart.length) {
+		diverge(&uart, -1);
+	}
+}
+
+static void firmware_send(char key) {
+	avr_cycle_count_t end = avr->cycle + us_to_cycles(CATCH_UP_US);
+	while (input_stopped && !divergence.stream) {
+		if (avr->cycle >= end) {
+			fprintf(stderr, "lockstep: the firmware never sent XON\n");
+			exit(2);
+		}
+		firmware_run(BYTE_US);
+	}
+	avr_raise_irq(uart_input, (uint8_t)key);
+	firmware_run(BYTE_US);
+}
+
+static void firmware_reset(void) {
+	avr_reset(avr);
+	avr->frequency = firmware.frequency ? firmware.frequency : 8000000;
+	avr->avcc = avr->aref = avr->vcc = 5000;
+	// the joystick is in the middle
+	avr_raise_irq(avr_io_getirq(avr, AVR_IOCTL_ADC_GETIRQ, ADC_IRQ_ADC0),
+			2500);
+	avr_raise_irq(avr_io_getirq(avr, AVR_IOCTL_ADC_GETIRQ, ADC_IRQ_ADC1),
+			2500);
+	// what the firmware sends comes here rather than the host's stdout
+	uint32_t flags = 0;
+	avr_ioctl(avr, AVR_IOCTL_UART_GET_FLAGS('0'), &flags);
+	flags &= ~AVR_UART_FLAG_STDIO;
+	avr_ioctl(avr, AVR_IOCTL_UART_SET_FLAGS('0'), &flags);
+	input_stopped = 0;
+}
+
+static void firmware_init(const char* path, const char* mcu) {
+	if (elf_read_firmware(path, &firmware)) {
+		fprintf(stderr, "lockstep: can't read %s\n", path);
+		exit(2);
+	}
+	if (!mcu) {
+		mcu = firmware.mmcu[0] ? firmware.mmcu : "atmega324pa";
+	}
+	avr = avr_make_mcu_by_name(mcu);
+	if (!avr) {
+		fprintf(stderr, "lockstep: simavr doesn't know the %s\n", mcu);
+		exit(2);
+	}
+	avr_init(avr);
+	avr_load_firmware(avr, &firmware);
+	uart_input = avr_io_getirq(avr, AVR_IOCTL_UART_GETIRQ('0'),
+			UART_IRQ_INPUT);
+	avr_irq_register_notify(avr_io_getirq(avr, AVR_IOCTL_UART_GETIRQ('0'),
+			UART_IRQ_OUTPUT), uart_output, NULL);
+	avr_irq_register_notify(avr_io_getirq(avr, AVR_IOCTL_SPI_GETIRQ(0),
+			SPI_IRQ_OUTPUT), spi_output, NULL);
+}
+
+/*
+ * Traces.
+ */
+
+static void make_trace(int16_t events) {
+	num_events = events;
+	for (int16_t i = 0; i < events; i++) {
+		trace[i].key = event_table[next_random() % sizeof(event_table)];
+		if (trace[i].key == '.') {
+			// mostly short waits, with some long enough for a bomb to
+			// go off
+			if (next_random() % 4) {
+				trace[i].ms = 1 + next_random() % 64;
+			} else {
+				trace[i].ms = BOMB_FUSE_TIME + next_random()
+						% (2 * EXPLOSION_DELAY);
+			}
+		}
+	}
+}
+
+// gives both builds one key, returns 0 once the game is over
+static uint8_t play_key(char key) {
+	host_pass(key);
+	host_game_over = is_game_over();
+	uint8_t settle = key != '.' || changing_level();
+	firmware_send(key);
+	if (settle) {
+		firmware_catch_up();
+		firmware_settle();
+	}
+	return !host_game_over && !divergence.stream;
+}
+
+static void compare_state(void) {
+	frame_start[num_frames] = uart.length;
+	play_key('q');
+}
+
+// returns 1 if both builds played the trace the same way
+static uint8_t play_trace(void) {
+	capturing = 0;
+	host_game_over = 0;
+	num_frames = 0;
+	divergence.stream = NULL;
+	reset_stream(&spi);
+	reset_stream(&uart);
+
+	// after the start screen has been sent, and between steps of the
+	// marquee, start a new game
+	event_number = -1;
+	firmware_reset();
+	firmware_run(BOOT_US);
+	firmware_settle();
+	capturing = 1;
+	host_start();
+	firmware_send('s');
+	firmware_catch_up();
+	firmware_settle();
+	if (divergence.stream) {
+		return 0;
+	}
+
+	for (event_number = 0; event_number < num_events; event_number++) {
+		Event* event = &trace[event_number];
+		spi.event_start[event_number] = spi.length;
+		uart.event_start[event_number] = uart.length;
+		if (event->key == '.') {
+			for (uint16_t ms = 0; ms < event->ms; ms++) {
+				if (!play_key('.')) {
+					break;
+				}
+			}
+		} else {
+			play_key(event->key);
+		}
+		if (!host_game_over && !divergence.stream
+				&& ((event_number + 1) % SNAPSHOT_EVERY == 0
+				|| event_number == num_events - 1)) {
+			compare_state();
+		}
+		if (host_game_over || divergence.stream) {
+			break;
+		}
+	}
+	if (!divergence.stream) {
+		firmware_catch_up();
+		firmware_settle();
+	}
+	return !divergence.stream;
+}
+
+/*
+ * Reports.
+ */
+
+// the part of the snapshot frame byte 'index' is in
+static const char* frame_field(uint16_t index, uint8_t width,
+		uint8_t height) {
+	static const char* const header[] = {"version", "level", "width",
+			"height", "total score", "score", "diamonds", "flags",
+			"player x", "player y", "facing x", "facing y", "collected",
+			"collected", "game time", "game time", "game time", "game time",
+			"speed"};
+	uint16_t squares = (uint16_t)width * height;
+	if (index < sizeof(header) / sizeof(header[0])) {
+		return header[index];
+	}
+	index -= sizeof(header) / sizeof(header[0]);
+	if (index < MAX_BOMBS * 4) {
+		return "bombs";
+	}
+	index -= MAX_BOMBS * 4;
+	if (index < squares / 4) {
+		return "terrain";
+	}
+	index -= squares / 4;
+	if (index < squares / 8) {
+		return "visible";
+	}
+	return "crc";
+}
+
+// says which part of the game state differs, if 'offset' in uart is in
+// a snapshot frame
+static void report_frame(size_t offset) {
+	for (uint16_t f = 0; f < num_frames; f++) {
+		size_t start = frame_start[f];
+		if (offset <= start) {
+			continue;
+		}
+		uint8_t frame[4] = {0};
+		uint16_t index = 0;
+		size_t i = start + 1;
+		for (; i < uart.length && i < offset; i++) {
+			if (uart.bytes[i] == SNAPSHOT_FLAG) {
+				break;
+			}
+			uint8_t byte = uart.bytes[i];
+			if (byte == SNAPSHOT_ESCAPE) {
+				byte = uart.bytes[++i] ^ 0x20;
+			}
+			if (index < sizeof(frame)) {
+				frame[index] = byte;
+			}
+			index++;
+		}
+		if (i == offset) {
+			printf("  the game state differs, in the %s\n",
+					frame_field(index, frame[2], frame[3]));
+			return;
+		}
+	}
+}
+
+static void print_bytes(const char* label, const uint8_t* bytes,
+		size_t start, size_t end) {
+	printf("  %-10s", label);
+	for (size_t i = start; i < end; i++) {
+		printf(" %02X", bytes[i]);
+	}
+	printf("\n");
+}
+
+static void report(uint32_t trace_number, uint32_t seed) {
+	Stream* stream = divergence.stream;
+	size_t offset = divergence.offset;
+	// the event which should have sent the byte
+	int16_t event = event_number < num_events ? event_number : num_events - 1;
+	while (event >= 0 && offset < stream->event_start[event]) {
+		event--;
+	}
+	if (event < 0) {
+		printf("trace %lu (seed %lu) differs starting the game:\n",
+				(unsigned long)trace_number, (unsigned long)seed);
+	} else {
+		printf("trace %lu (seed %lu) differs at event %d:\n",
+				(unsigned long)trace_number, (unsigned long)seed, event + 1);
+	}
+	if (divergence.actual < 0) {
+		printf("  the firmware stopped sending %s after byte %zu\n",
+				stream->name, offset);
+	} else if (offset >= stream->length) {
+		printf("  %s byte %zu: the host build sent nothing, the firmware "
+				"0x%02X\n", stream->name, offset, divergence.actual);
+	} else {
+		printf("  %s byte %zu: the host build sent 0x%02X, the firmware "
+				"0x%02X\n", stream->name, offset, stream->bytes[offset],
+				divergence.actual);
+	}
+	size_t start = offset > 8 ? offset - 8 : 0;
+	size_t end = offset + 8 < stream->length ? offset + 8 : stream->length;
+	print_bytes("host", stream->bytes, start, end);
+	print_bytes("firmware", stream->actual, start,
+			offset + (divergence.actual >= 0));
+	if (stream == &uart) {
+		report_frame(offset);
+	}
+
+	// a bomb is b in sim.c scripts
+	printf("script for sim.c:\n  ");
+	for (int16_t i = 0; i <= event; i++) {
+		if (trace[i].key == '.') {
+			printf("%u ", trace[i].ms);
+		} else {
+			printf("%c ", trace[i].key == ' ' ? 'b' : trace[i].key);
+		}
+	}
+	printf("\n");
+}
+
+int main(int argc, char** argv) {
+	const char* mcu = NULL;
+	int arg = 1;
+	if (arg + 1 < argc && strcmp(argv[arg], "-m") == 0) {
+		mcu = argv[arg + 1];
+		arg += 2;
+	}
+	if (arg >= argc) {
+		fprintf(stderr, "usage: lockstep [-m mcu] firmware.elf [traces] "
+				"[events] [seed]\n");
+		return 2;
+	}
+	const char* path = argv[arg++];
+	uint32_t traces = arg < argc ? strtoul(argv[arg++], NULL, 0) : 1000;
+	uint32_t events = arg < argc ? strtoul(argv[arg++], NULL, 0) : 40;
+	uint32_t seed = arg < argc ? strtoul(argv[arg++], NULL, 0) : 1;
+	if (events < 1 || events > MAX_EVENTS) {
+		fprintf(stderr, "lockstep: a trace has 1 to %d events\n",
+				MAX_EVENTS);
+		return 2;
+	}
+
+	FILE* output = stdout;
+	cookie_io_functions_t terminal_functions = {NULL, write_terminal, NULL,
+			NULL};
+	stdout = fopencookie(NULL, "w", terminal_functions);
+	setvbuf(stdout, NULL, _IONBF, 0);
+	spi_byte_hook = spi_sent;
+	init_save();
+	firmware_init(path, mcu);
+
+	clock_t start = clock();
+	uint32_t t;
+	for (t = 0; t < traces; t++) {
+		// each trace can be played again on its own from its seed
+		random_state = seed + t ? seed + t : 1;
+		make_trace(events);
+		if (!play_trace()) {
+			stdout = output;
+			report(t + 1, seed + t);
+			return 1;
+		}
+	}
+	double seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+	fprintf(output, "%lu traces of %lu events the same, %llu bytes compared "
+			"in %.1f s (%.0f traces a minute)\n", (unsigned long)t,
+			(unsigned long)events, (unsigned long long)bytes_compared,
+			seconds, seconds > 0 ? t * 60 / seconds : 0);
+	return 0;
+}
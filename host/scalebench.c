@@ -0,0 +1,158 @@
+/*
+ * scalebench.c
+ *
+ * Author: William Sawyer
+ *
+ * Host program which measures how the playing field algorithms of game.c
+ * scale to bigger worlds, to see which data structures would hold up
+ * before larger worlds are tried on the hardware. Synthetic fields from
+ * 16x8 (one display) to 4096x4096 are generated (see scalemap.h), and
+ * for each size it times:
+ *
+ *  - reveal: discoverable_dfs() from a random open square of a field
+ *    nothing is visible on yet
+ *  - explode: a bomb going off at a random square, clearing the
+ *    breakable squares next to it and revealing from each
+ *  - detect: the nearest diamond within range of a random square, as
+ *    detect_diamond() finds it
+ *
+ * Reveals are done three ways: as game.c does it (a 32 square stack,
+ * sweeping the whole field when it overflows), with a stack which
+ * grows as needed, and with bitboards as host/batch.c does it. The
+ * nearest diamond is found by going through the list of diamonds, as
+ * game.c does, and with a grid of buckets. Each line gives the
+ * operations and squares (revealed, or diamonds found in range) per
+ * second, and the bytes the method needed for that size of field.
+ *
+ * Build and run with:
+ *     gcc -O2 -Ihost -I. -o scalebench host/scalebench.c
+ *     ./scalebench
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "levels.h"
+
+// the direction order of game.c
+#define NUM_DIRECTIONS 4
+static const int8_t directions[NUM_DIRECTIONS][2] =
+		{{0,1}, {0,-1}, {1,0}, {-1,0}};
+
+// as in game.c
+#define DFS_STACK_SIZE	32
+#define DETECT_RANGE	4
+
+// percentages of squares which are empty and breakable, the rest are
+// unbreakable. Over about 60% empty the open squares mostly join up
+#define OPEN_PERCENT		65
+#define BREAKABLE_PERCENT	27
+
+// diamonds are bucketed in cells this many squares across
+#define GRID_CELL	8
+
+// each test runs for at least this long, or this many trials, and a
+// single reveal is given up on after GIVE_UP_SECONDS
+#define MIN_SECONDS		0.2
+#define MAX_TRIALS		200
+#define GIVE_UP_SECONDS	10.0
+
+#define NUM_METHODS	3
+static const char* const method_names[NUM_METHODS] =
+		{"game.c", "stack", "bitboard"};
+
+#define SIZED(name)				SIZED_(name, SCALE_WIDTH, SCALE_HEIGHT)
+#define SIZED_(name, w, h)		SIZED__(name, w, h)
+#define SIZED__(name, w, h)		name##_##w##x##h
+
+// xorshift, so runs can be repeated
+static uint32_t random_state = 1;
+
+static uint32_t next_random(void) {
+	random_state ^= random_state << 13;
+	random_state ^= random_state >> 17;
+	random_state ^= random_state << 5;
+	return random_state;
+}
+
+static double seconds(void) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+// set when a reveal ran out of time, and how many times game.c's search
+// swept the field
+static uint8_t gave_up;
+static uint64_t sweeps;
+
+// the growing stack, and the most squares it has held
+static uint16_t (*stack)[2];
+static uint32_t stack_size;
+static uint32_t stack_high_water;
+
+static void stack_push(uint16_t x, uint16_t y, uint32_t depth) {
+	if (depth == stack_size) {
+		stack_size = stack_size ? stack_size * 2 : 1024;
+		stack = realloc(stack, stack_size * sizeof(stack[0]));
+		if (!stack) {
+			fprintf(stderr, "out of memory\n");
+			exit(1);
+		}
+	}
+	stack[depth][0] = x;
+	stack[depth][1] = y;
+	if (depth + 1 > stack_high_water) {
+		stack_high_water = depth + 1;
+	}
+}
+
+static void report(const char* size, const char* test, const char* method,
+		uint64_t trials, uint64_t squares, double spent, uint64_t bytes) {
+	if (spent <= 0) {
+		spent = 1e-9;
+	}
+	printf("%-10s %-8s %-9s %11.1f ops/s %12.0f squares/s %10llu bytes",
+			size, test, method, trials / spent, squares / spent,
+			(unsigned long long)bytes);
+	if (sweeps) {
+		printf("  %llu sweeps", (unsigned long long)sweeps);
+	}
+	if (gave_up) {
+		printf("  gave up after %.0f s", GIVE_UP_SECONDS);
+	}
+	printf("\n");
+}
+
+#define SCALE_WIDTH		16
+#define SCALE_HEIGHT	8
+#include "scalemap.h"
+
+#define SCALE_WIDTH		64
+#define SCALE_HEIGHT	32
+#include "scalemap.h"
+
+#define SCALE_WIDTH		256
+#define SCALE_HEIGHT	256
+#include "scalemap.h"
+
+#define SCALE_WIDTH		1024
+#define SCALE_HEIGHT	1024
+#include "scalemap.h"
+
+#define SCALE_WIDTH		4096
+#define SCALE_HEIGHT	4096
+#include "scalemap.h"
+
+int main(void) {
+	bench_16x8();
+	bench_64x32();
+	bench_256x256();
+	bench_1024x1024();
+	bench_4096x4096();
+	free(stack);
+	return 0;
+}
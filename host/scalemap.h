@@ -0,0 +1,482 @@
+/*
+ * scalemap.h
+ *
+ * Author: William Sawyer
+ *
+ * One size of playing field for scalebench.c. This is included once for
+ * each size, with SCALE_WIDTH and SCALE_HEIGHT defined (both multiples of
+ * 8), so the dimensions are constants the compiler can work with as they
+ * would be on the hardware. Everything here is static and has the size
+ * in its name (e.g. terrain_64x32), so there is deliberately no include
+ * guard.
+ *
+ * The field is kept the way game.c keeps it (terrain packed 2 bits per
+ * square, visibility 1 bit per square, diamonds in a list) with 16 bit
+ * coordinates, alongside the structures being weighed up against it:
+ * a bitboard of open squares as in host/batch.c, and a grid of buckets
+ * for finding diamonds.
+ */
+
+#define SCALE_SQUARES	((uint32_t)SCALE_WIDTH * SCALE_HEIGHT)
+#define SCALE_WORDS		((SCALE_SQUARES + 63) / 64)
+#define SCALE_DIAMONDS	(SCALE_SQUARES / 128 > 4 ? SCALE_SQUARES / 128 : 4)
+#define SCALE_CELLS		(SCALE_SQUARES / (GRID_CELL * GRID_CELL))
+
+static uint8_t SIZED(terrain)[SCALE_SQUARES / 4];
+static uint8_t SIZED(visible)[SCALE_SQUARES / 8];
+static uint16_t SIZED(diamonds)[SCALE_DIAMONDS][2];
+static uint8_t SIZED(collected)[(SCALE_DIAMONDS + 7) / 8];
+
+// bitboards: open squares, squares seen and the search frontier
+static uint64_t SIZED(open)[SCALE_WORDS];
+static uint64_t SIZED(seen)[SCALE_WORDS];
+static uint64_t SIZED(frontier)[SCALE_WORDS];
+static uint64_t SIZED(grown)[SCALE_WORDS];
+// squares not in the leftmost or rightmost column
+static uint64_t SIZED(not_left)[SCALE_WORDS];
+static uint64_t SIZED(not_right)[SCALE_WORDS];
+
+// the first diamond in each cell of the grid, and the next in its cell
+static int32_t SIZED(cell_first)[SCALE_CELLS];
+static int32_t SIZED(cell_next)[SCALE_DIAMONDS];
+
+static inline uint32_t SIZED(index)(uint16_t x, uint16_t y) {
+	return (uint32_t)y * SCALE_WIDTH + x;
+}
+
+static inline uint8_t SIZED(in_bounds)(uint16_t x, uint16_t y) {
+	return x < SCALE_WIDTH && y < SCALE_HEIGHT;
+}
+
+static inline uint8_t SIZED(get_terrain)(uint16_t x, uint16_t y) {
+	uint32_t i = SIZED(index)(x, y);
+	return (SIZED(terrain)[i >> 2] >> ((i & 3) << 1)) & 3;
+}
+
+static inline void SIZED(set_terrain)(uint16_t x, uint16_t y,
+		uint8_t value) {
+	uint32_t i = SIZED(index)(x, y);
+	uint8_t shift = (i & 3) << 1;
+	SIZED(terrain)[i >> 2] = (SIZED(terrain)[i >> 2] & ~(3 << shift))
+			| (value << shift);
+	if (value == TERRAIN_EMPTY) {
+		SIZED(open)[i >> 6] |= 1ULL << (i & 63);
+	} else {
+		SIZED(open)[i >> 6] &= ~(1ULL << (i & 63));
+	}
+}
+
+static inline uint8_t SIZED(is_visible)(uint16_t x, uint16_t y) {
+	uint32_t i = SIZED(index)(x, y);
+	return (SIZED(visible)[i >> 3] >> (i & 7)) & 1;
+}
+
+static inline void SIZED(set_visible)(uint16_t x, uint16_t y) {
+	uint32_t i = SIZED(index)(x, y);
+	SIZED(visible)[i >> 3] |= 1 << (i & 7);
+}
+
+// random terrain with a mostly connected open area, and diamonds on it
+static void SIZED(generate)(uint32_t seed) {
+	random_state = seed;
+	memset(SIZED(open), 0, sizeof(SIZED(open)));
+	for (uint16_t y = 0; y < SCALE_HEIGHT; y++) {
+		for (uint16_t x = 0; x < SCALE_WIDTH; x++) {
+			uint32_t r = next_random() % 100;
+			uint8_t value = TERRAIN_EMPTY;
+			if (r >= OPEN_PERCENT + BREAKABLE_PERCENT) {
+				value = TERRAIN_UNBREAKABLE;
+			} else if (r >= OPEN_PERCENT) {
+				value = TERRAIN_BREAKABLE;
+			}
+			if (x == 0 && y == 0) {
+				value = TERRAIN_EMPTY;
+			}
+			SIZED(set_terrain)(x, y, value);
+			uint32_t i = SIZED(index)(x, y);
+			if (x == 0) {
+				SIZED(not_left)[i >> 6] &= ~(1ULL << (i & 63));
+			} else {
+				SIZED(not_left)[i >> 6] |= 1ULL << (i & 63);
+			}
+			if (x == SCALE_WIDTH - 1) {
+				SIZED(not_right)[i >> 6] &= ~(1ULL << (i & 63));
+			} else {
+				SIZED(not_right)[i >> 6] |= 1ULL << (i & 63);
+			}
+		}
+	}
+	for (uint32_t c = 0; c < SCALE_CELLS; c++) {
+		SIZED(cell_first)[c] = -1;
+	}
+	for (uint32_t d = 0; d < SCALE_DIAMONDS; d++) {
+		uint16_t x, y;
+		do {
+			x = next_random() % SCALE_WIDTH;
+			y = next_random() % SCALE_HEIGHT;
+		} while (SIZED(get_terrain)(x, y) != TERRAIN_EMPTY);
+		SIZED(diamonds)[d][0] = x;
+		SIZED(diamonds)[d][1] = y;
+		uint32_t cell = (y / GRID_CELL) * (SCALE_WIDTH / GRID_CELL)
+				+ x / GRID_CELL;
+		SIZED(cell_next)[d] = SIZED(cell_first)[cell];
+		SIZED(cell_first)[cell] = d;
+	}
+	memset(SIZED(collected), 0, sizeof(SIZED(collected)));
+}
+
+static void SIZED(forget)(void) {
+	memset(SIZED(visible), 0, sizeof(SIZED(visible)));
+	memset(SIZED(seen), 0, sizeof(SIZED(seen)));
+}
+
+// returns 1 if the square has just been revealed and is open
+static inline uint8_t SIZED(reveal_square)(uint16_t x, uint16_t y,
+		uint32_t* revealed) {
+	*revealed += !SIZED(is_visible)(x, y);
+	SIZED(set_visible)(x, y);
+	return SIZED(get_terrain)(x, y) == TERRAIN_EMPTY;
+}
+
+/*
+ * discoverable_dfs() as game.c does it: a stack of DFS_STACK_SIZE
+ * squares, and a sweep of the whole field for open squares left
+ * unexplored when it overflows. Gives up after 'deadline'. Returns the
+ * number of squares revealed.
+ */
+static uint32_t SIZED(reveal_game)(uint16_t x, uint16_t y,
+		double deadline) {
+	uint16_t stack_x[DFS_STACK_SIZE], stack_y[DFS_STACK_SIZE];
+	uint8_t depth = 0;
+	uint8_t overflowed = 0;
+	uint32_t revealed = 0;
+
+	if (SIZED(reveal_square)(x, y, &revealed)) {
+		stack_x[depth] = x;
+		stack_y[depth++] = y;
+	}
+	while (depth) {
+		x = stack_x[--depth];
+		y = stack_y[depth];
+		for (uint8_t i = 0; i < NUM_DIRECTIONS; i++) {
+			uint16_t x_adj = x + directions[i][0];
+			uint16_t y_adj = y + directions[i][1];
+			if (SIZED(in_bounds)(x_adj, y_adj)
+					&& !SIZED(is_visible)(x_adj, y_adj)
+					&& SIZED(reveal_square)(x_adj, y_adj, &revealed)) {
+				if (depth < DFS_STACK_SIZE) {
+					stack_x[depth] = x_adj;
+					stack_y[depth++] = y_adj;
+				} else {
+					overflowed = 1;
+				}
+			}
+		}
+		if (!depth && overflowed) {
+			if (seconds() > deadline) {
+				gave_up = 1;
+				return revealed;
+			}
+			overflowed = 0;
+			sweeps++;
+			for (y = 0; y < SCALE_HEIGHT; y++) {
+				for (x = 0; x < SCALE_WIDTH; x++) {
+					if (!SIZED(is_visible)(x, y)
+							|| SIZED(get_terrain)(x, y) != TERRAIN_EMPTY) {
+						continue;
+					}
+					uint8_t unexplored = 0;
+					for (uint8_t i = 0; i < NUM_DIRECTIONS; i++) {
+						uint16_t x_adj = x + directions[i][0];
+						uint16_t y_adj = y + directions[i][1];
+						if (SIZED(in_bounds)(x_adj, y_adj)
+								&& !SIZED(is_visible)(x_adj, y_adj)) {
+							unexplored = 1;
+						}
+					}
+					if (!unexplored) {
+						continue;
+					}
+					if (depth < DFS_STACK_SIZE) {
+						stack_x[depth] = x;
+						stack_y[depth++] = y;
+					} else {
+						overflowed = 1;
+					}
+				}
+			}
+		}
+	}
+	return revealed;
+}
+
+// the same search with a stack which grows as needed, so it never sweeps
+static uint32_t SIZED(reveal_stack)(uint16_t x, uint16_t y,
+		double deadline) {
+	uint32_t depth = 0;
+	uint32_t revealed = 0;
+
+	(void)deadline;
+	if (SIZED(reveal_square)(x, y, &revealed)) {
+		stack_push(x, y, depth++);
+	}
+	while (depth) {
+		depth--;
+		x = stack[depth][0];
+		y = stack[depth][1];
+		for (uint8_t i = 0; i < NUM_DIRECTIONS; i++) {
+			uint16_t x_adj = x + directions[i][0];
+			uint16_t y_adj = y + directions[i][1];
+			if (SIZED(in_bounds)(x_adj, y_adj)
+					&& !SIZED(is_visible)(x_adj, y_adj)
+					&& SIZED(reveal_square)(x_adj, y_adj, &revealed)) {
+				stack_push(x_adj, y_adj, depth++);
+			}
+		}
+	}
+	return revealed;
+}
+
+// word w of bitboard 'src' moved 'k' squares towards higher indices
+static inline uint64_t SIZED(shifted_up)(const uint64_t* src, int64_t w,
+		uint32_t k) {
+	int64_t s = w - (k >> 6);
+	uint8_t bits = k & 63;
+	if (s < 0) {
+		return 0;
+	}
+	uint64_t value = src[s] << bits;
+	if (bits && s > 0) {
+		value |= src[s - 1] >> (64 - bits);
+	}
+	return value;
+}
+
+// word w of bitboard 'src' moved 'k' squares towards lower indices
+static inline uint64_t SIZED(shifted_down)(const uint64_t* src, int64_t w,
+		uint32_t k) {
+	int64_t s = w + (k >> 6);
+	uint8_t bits = k & 63;
+	if (s >= SCALE_WORDS) {
+		return 0;
+	}
+	uint64_t value = src[s] >> bits;
+	if (bits && s + 1 < SCALE_WORDS) {
+		value |= src[s + 1] << (64 - bits);
+	}
+	return value;
+}
+
+/*
+ * A breadth first search on the bitboards, as host/batch.c does it:
+ * each pass reveals the unseen squares next to the frontier, and the
+ * open ones become the next frontier. Only the words the frontier can
+ * reach are looked at.
+ */
+static uint32_t SIZED(reveal_bitboard)(uint16_t x, uint16_t y,
+		double deadline) {
+	uint64_t* seen = SIZED(seen);
+	uint64_t* frontier = SIZED(frontier);
+	uint64_t* grown = SIZED(grown);
+	uint32_t i = SIZED(index)(x, y);
+	// words a square's neighbours can be from its own
+	int64_t margin = (SCALE_WIDTH >> 6) + 1;
+	uint32_t revealed = !((seen[i >> 6] >> (i & 63)) & 1);
+
+	(void)deadline;
+	seen[i >> 6] |= 1ULL << (i & 63);
+	if (SIZED(get_terrain)(x, y) != TERRAIN_EMPTY) {
+		return revealed;
+	}
+	int64_t first = i >> 6, last = i >> 6;
+	frontier[first] = 1ULL << (i & 63);
+	while (first <= last) {
+		int64_t low = first - margin < 0 ? 0 : first - margin;
+		int64_t high = last + margin >= SCALE_WORDS ? SCALE_WORDS - 1
+				: last + margin;
+		for (int64_t w = low; w <= high; w++) {
+			grown[w] = (SIZED(shifted_up)(frontier, w, 1) & SIZED(not_left)[w])
+					| (SIZED(shifted_down)(frontier, w, 1) & SIZED(not_right)[w])
+					| SIZED(shifted_up)(frontier, w, SCALE_WIDTH)
+					| SIZED(shifted_down)(frontier, w, SCALE_WIDTH);
+		}
+		first = SCALE_WORDS;
+		last = -1;
+		for (int64_t w = low; w <= high; w++) {
+			uint64_t found = grown[w] & ~seen[w];
+			seen[w] |= found;
+			revealed += __builtin_popcountll(found);
+			frontier[w] = found & SIZED(open)[w];
+			if (frontier[w]) {
+				if (w < first) {
+					first = w;
+				}
+				last = w;
+			}
+		}
+	}
+	return revealed;
+}
+
+static uint32_t (* const SIZED(reveals)[NUM_METHODS])(uint16_t, uint16_t,
+		double) = {SIZED(reveal_game), SIZED(reveal_stack),
+		SIZED(reveal_bitboard)};
+
+// detonate_bombs() for one bomb at (x,y): breakable neighbours are
+// cleared and revealed from
+static uint32_t SIZED(explode)(uint16_t x, uint16_t y, uint8_t method,
+		double deadline) {
+	uint32_t revealed = 0;
+	SIZED(set_terrain)(x, y, TERRAIN_EMPTY);
+	for (uint8_t i = 0; i < NUM_DIRECTIONS; i++) {
+		uint16_t x_adj = x + directions[i][0];
+		uint16_t y_adj = y + directions[i][1];
+		if (SIZED(in_bounds)(x_adj, y_adj) && SIZED(get_terrain)(x_adj, y_adj)
+				!= TERRAIN_UNBREAKABLE && SIZED(get_terrain)(x_adj, y_adj)
+				!= TERRAIN_EMPTY) {
+			SIZED(set_terrain)(x_adj, y_adj, TERRAIN_EMPTY);
+			revealed += SIZED(reveals)[method](x_adj, y_adj, deadline);
+		}
+	}
+	return revealed;
+}
+
+static inline uint16_t SIZED(distance)(uint16_t x, uint16_t y, uint32_t d) {
+	return abs((int)x - SIZED(diamonds)[d][0])
+			+ abs((int)y - SIZED(diamonds)[d][1]);
+}
+
+// detect_diamond() as game.c does it, looking through every diamond
+static uint16_t SIZED(nearest_list)(uint16_t x, uint16_t y) {
+	uint16_t shortest = DETECT_RANGE + 1;
+	for (uint32_t d = 0; d < SCALE_DIAMONDS; d++) {
+		if ((SIZED(collected)[d >> 3] >> (d & 7)) & 1) {
+			continue;
+		}
+		uint16_t distance = SIZED(distance)(x, y, d);
+		if (distance < shortest) {
+			shortest = distance;
+		}
+	}
+	return shortest;
+}
+
+// the same, looking only in the grid cells within range of (x,y)
+static uint16_t SIZED(nearest_grid)(uint16_t x, uint16_t y) {
+	uint16_t shortest = DETECT_RANGE + 1;
+	int low_x = ((int)x - DETECT_RANGE) / GRID_CELL;
+	int high_x = ((int)x + DETECT_RANGE) / GRID_CELL;
+	int low_y = ((int)y - DETECT_RANGE) / GRID_CELL;
+	int high_y = ((int)y + DETECT_RANGE) / GRID_CELL;
+	for (int cy = low_y < 0 ? 0 : low_y; cy <= high_y
+			&& cy < SCALE_HEIGHT / GRID_CELL; cy++) {
+		for (int cx = low_x < 0 ? 0 : low_x; cx <= high_x
+				&& cx < SCALE_WIDTH / GRID_CELL; cx++) {
+			int32_t d = SIZED(cell_first)[cy * (SCALE_WIDTH / GRID_CELL) + cx];
+			for (; d >= 0; d = SIZED(cell_next)[d]) {
+				if ((SIZED(collected)[d >> 3] >> (d & 7)) & 1) {
+					continue;
+				}
+				uint16_t distance = SIZED(distance)(x, y, d);
+				if (distance < shortest) {
+					shortest = distance;
+				}
+			}
+		}
+	}
+	return shortest;
+}
+
+static void SIZED(bench)(void) {
+	char size[16];
+	snprintf(size, sizeof(size), "%ux%u", SCALE_WIDTH, SCALE_HEIGHT);
+	// bytes each method keeps for the whole field, beyond the terrain
+	uint64_t field_bytes[NUM_METHODS] = {sizeof(SIZED(visible)),
+			sizeof(SIZED(visible)),
+			sizeof(SIZED(open)) + sizeof(SIZED(seen))
+			+ sizeof(SIZED(frontier)) + sizeof(SIZED(grown))};
+
+	for (uint8_t method = 0; method < NUM_METHODS; method++) {
+		// reveals from random open squares of a fresh field
+		SIZED(generate)(1);
+		uint64_t revealed = 0;
+		uint32_t trials = 0;
+		double spent = 0;
+		gave_up = 0;
+		sweeps = 0;
+		stack_high_water = 0;
+		while (spent < MIN_SECONDS && trials < MAX_TRIALS && !gave_up) {
+			uint16_t x, y;
+			do {
+				x = next_random() % SCALE_WIDTH;
+				y = next_random() % SCALE_HEIGHT;
+			} while (SIZED(get_terrain)(x, y) != TERRAIN_EMPTY);
+			SIZED(forget)();
+			double start = seconds();
+			revealed += SIZED(reveals)[method](x, y, start + GIVE_UP_SECONDS);
+			spent += seconds() - start;
+			trials++;
+		}
+		report(size, "reveal", method_names[method], trials, revealed, spent,
+				sizeof(SIZED(terrain)) + field_bytes[method]
+				+ stack_high_water * sizeof(stack[0]));
+
+		// explosions at random squares of a fresh field, revealing as
+		// they go
+		SIZED(generate)(2);
+		SIZED(forget)();
+		revealed = 0;
+		trials = 0;
+		spent = 0;
+		gave_up = 0;
+		sweeps = 0;
+		stack_high_water = 0;
+		while (spent < MIN_SECONDS && trials < MAX_TRIALS * 16 && !gave_up) {
+			uint16_t x = next_random() % SCALE_WIDTH;
+			uint16_t y = next_random() % SCALE_HEIGHT;
+			double start = seconds();
+			revealed += SIZED(explode)(x, y, method, start + GIVE_UP_SECONDS);
+			spent += seconds() - start;
+			trials++;
+		}
+		report(size, "explode", method_names[method], trials, revealed,
+				spent, sizeof(SIZED(terrain)) + field_bytes[method]
+				+ stack_high_water * sizeof(stack[0]));
+	}
+
+	// nearest diamond from random squares, with a few collected
+	SIZED(generate)(3);
+	for (uint32_t d = 0; d < SCALE_DIAMONDS; d += 4) {
+		SIZED(collected)[d >> 3] |= 1 << (d & 7);
+	}
+	for (uint8_t method = 0; method < 2; method++) {
+		uint32_t trials = 0;
+		uint64_t found = 0;
+		gave_up = 0;
+		sweeps = 0;
+		double start = seconds();
+		double spent = 0;
+		while (spent < MIN_SECONDS) {
+			for (uint16_t n = 0; n < 1024; n++) {
+				uint16_t x = next_random() % SCALE_WIDTH;
+				uint16_t y = next_random() % SCALE_HEIGHT;
+				uint16_t shortest = method ? SIZED(nearest_grid)(x, y)
+						: SIZED(nearest_list)(x, y);
+				found += shortest <= DETECT_RANGE;
+			}
+			trials += 1024;
+			spent = seconds() - start;
+		}
+		report(size, "detect", method ? "grid" : "list", trials, found,
+				spent, sizeof(SIZED(diamonds)) + sizeof(SIZED(collected))
+				+ (method ? sizeof(SIZED(cell_first))
+				+ sizeof(SIZED(cell_next)) : 0));
+	}
+}
+
+#undef SCALE_SQUARES
+#undef SCALE_WORDS
+#undef SCALE_DIAMONDS
+#undef SCALE_CELLS
+#undef SCALE_WIDTH
+#undef SCALE_HEIGHT
@@ -0,0 +1,183 @@
+/*
+ * sim.c
+ *
+ * Author: William Sawyer
+ *
+ * Host program which plays a game of Diamond Miners from a script, as
+ * fast as the host can go. The game clock is only moved on by the 
+ * script, so the same script always plays out the same way.
+ *
+ * Build and run with:
+ *     gcc -DGAME_CLOCK_MANUAL=1 -Ihost -I. -o sim host/sim.c host/spi.c \
+ *         host/storage.c host/emulator.c game.c display.c levels.c \
+ *         gameclock.c ledmatrix.c image.c images.c terminalio.c save.c \
+ *         marquee.c render.c
+ *     ./sim [-h] [level] < script
+ *
+ * The script uses the same keys as the serial terminal (w, a, s, d to
+ * move, e to inspect, c to toggle cheat mode) except that a bomb is 
+ * planted with b, so that scripts can be spaced out. Numbers wait that
+ * many milliseconds of game time (e.g. "b a a 2500"). r cuts the power
+ * and resumes the game saved in the EEPROM (see save.h), as if r had 
+ * been pressed on the start screen. Anything else is ignored. 
+ *
+ * What the game sends to the LED matrix and the terminal is passed 
+ * through the emulators in emulator.c. At the end, what they show is
+ * printed along with a summary of the game and of the traffic sent to
+ * each. Every input and every millisecond waited is counted as a frame.
+ * With -h the game runs headless (see render.h), so nothing is drawn 
+ * except the banners between levels.
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <stdint.h>
+
+#include "game.h"
+#include "gameclock.h"
+#include "save.h"
+#include "render.h"
+#include "emulator.h"
+
+extern MatrixEmulator* spi_matrix_emulator;
+extern uint32_t storage_bytes_programmed;
+
+static MatrixEmulator matrix;
+static TerminalEmulator terminal;
+
+// stdout is replaced with a stream which writes to the terminal emulator
+static ssize_t write_terminal(void* cookie, const char* buffer, size_t size) {
+	(void) cookie;
+	terminal_emulator_feed(&terminal, (const uint8_t*)buffer, size);
+	return size;
+}
+
+// the game clock is the only clock the simulation has
+uint32_t get_current_time(void) {
+	return get_game_time();
+}
+
+static void end_frame(void) {
+	render_flush();
+	save_update();
+	fflush(stdout);
+	matrix_emulator_end_frame(&matrix);
+	terminal_emulator_end_frame(&terminal);
+}
+
+// runs the game for 'ms' milliseconds of game time, a millisecond at 
+// a time as the game loop would see it
+static void wait(uint32_t ms) {
+	while (ms-- && !is_game_over()) {
+		game_clock_advance(1);
+		update_game(get_game_time());
+		end_frame();
+	}
+}
+
+int main(int argc, char** argv) {
+	uint8_t level = 0;
+	uint32_t moves = 0;
+	int c;
+	
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-h") == 0) {
+			render_set_headless(1);
+		} else {
+			level = atoi(argv[i]);
+		}
+	}
+	FILE* output = stdout;
+	cookie_io_functions_t terminal_functions = {NULL, write_terminal, NULL, 
+			NULL};
+	stdout = fopencookie(NULL, "w", terminal_functions);
+	matrix_emulator_init(&matrix);
+	terminal_emulator_init(&terminal);
+	spi_matrix_emulator = &matrix;
+	
+	init_save();
+	game_clock_start();
+	initialise_game(level, 0);
+	save_start();
+	
+	while (!is_game_over() && (c = getchar()) != EOF) {
+		if (isdigit(c)) {
+			uint32_t ms = c - '0';
+			while (isdigit(c = getchar())) {
+				ms = ms * 10 + c - '0';
+			}
+			wait(ms);
+			continue;
+		}
+		switch (tolower(c)) {
+			case 'w':
+				moves += move_player(0, 1);
+				break;
+			case 'a':
+				moves += move_player(-1, 0);
+				break;
+			case 's':
+				moves += move_player(0, -1);
+				break;
+			case 'd':
+				moves += move_player(1, 0);
+				break;
+			case 'e':
+				inspect_facing();
+				break;
+			case 'c':
+				toggle_cheat();
+				break;
+			case 'b':
+				plant_bomb(get_game_time());
+				break;
+			case 'r':
+				// everything but the EEPROM is lost
+				matrix_emulator_init(&matrix);
+				terminal_emulator_init(&terminal);
+				init_save();
+				game_clock_start();
+				if (!save_resume()) {
+					fprintf(output, "no saved game to resume\n");
+					return 1;
+				}
+				break;
+			default:
+				continue;
+		}
+		update_game(get_game_time());
+		end_frame();
+	}
+	
+	for (uint8_t y = 1; y <= TERMINAL_ROWS; y++) {
+		fprintf(output, "%s\n", terminal_emulator_row(&terminal, y));
+	}
+	for (int8_t y = MATRIX_NUM_ROWS - 1; y >= 0; y--) {
+		for (uint8_t x = 0; x < MATRIX_NUM_COLUMNS; x++) {
+			fputc(matrix_emulator_symbol(matrix.pixels[y][x]), output);
+		}
+		fputc('\n', output);
+	}
+	fprintf(output, "game time %lu ms, %lu moves, score %u, %s\n",
+			(unsigned long)get_game_time(), (unsigned long)moves, 
+			get_total_score(), is_game_over() ? "game over" : "still playing");
+	fprintf(output, "matrix: %llu bytes, %llu commands, most in a frame "
+			"%lu bytes, %lu commands\n", 
+			(unsigned long long)matrix.counters.total_bytes, 
+			(unsigned long long)matrix.counters.total_commands,
+			(unsigned long)matrix.counters.max_bytes, 
+			(unsigned long)matrix.counters.max_commands);
+	fprintf(output, "terminal: %llu bytes, %llu commands, most in a frame "
+			"%lu bytes, %lu commands\n", 
+			(unsigned long long)terminal.counters.total_bytes, 
+			(unsigned long long)terminal.counters.total_commands,
+			(unsigned long)terminal.counters.max_bytes, 
+			(unsigned long)terminal.counters.max_commands);
+	fprintf(output, "EEPROM: %lu bytes programmed\n",
+			(unsigned long)storage_bytes_programmed);
+	return 0;
+}
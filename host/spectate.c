@@ -0,0 +1,192 @@
+/*
+ * spectate.c
+ *
+ * Author: William Sawyer
+ *
+ * Host viewer for the spectator feed (see spectator.h). The feed is read
+ * from stdin and the playing field is redrawn on the terminal whenever
+ * the feed pauses.
+ *
+ * Build and run with:
+ *     gcc -Ihost -I. -o spectate host/spectate.c
+ *     stty -F /dev/ttyUSB1 250000 raw && ./spectate < /dev/ttyUSB1
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <poll.h>
+
+#include "display.h"
+#include "levels.h"
+
+#define SPECTATOR 1
+#include "spectator.h"
+
+// the most bytes after the type of any record
+#define MAX_RECORD_DATA		(2 + SPECTATOR_ROW_LENGTH)
+
+static uint8_t field[WORLD_MAX_HEIGHT][WORLD_MAX_WIDTH];
+static uint8_t width, height, level;
+static uint8_t player_x, player_y;
+static uint8_t score, diamonds_available;
+static uint8_t game_over;
+static uint8_t synced; // a level record has been received
+
+// the character each object is shown as
+static const char symbols[NUM_OBJECTS + 1] = " @>+#D?*BxX";
+
+static char symbol(uint8_t object) {
+	return object < NUM_OBJECTS ? symbols[object] : '?';
+}
+
+static void draw(void) {
+	if (!synced) {
+		return;
+	}
+	printf("\x1b[H\x1b[2JLevel %u  Diamonds %u of %u%s\r\n", level, score,
+			diamonds_available, game_over ? "  GAME OVER" : "");
+	// the top row is printed first
+	for (int8_t y = height - 1; y >= 0; y--) {
+		for (uint8_t x = 0; x < width; x++) {
+			if (x == player_x && y == player_y) {
+				putchar(symbol(PLAYER));
+			} else {
+				putchar(symbol(field[y][x]));
+			}
+		}
+		printf("\r\n");
+	}
+	fflush(stdout);
+}
+
+// applies a record of type 'type' with 'length' data bytes, returns 0 if
+// the record is malformed
+static uint8_t apply(uint8_t type, const uint8_t* data, uint8_t length) {
+	switch (type) {
+		case SPECTATOR_LEVEL:
+			if (length != 4 || data[1] > 1 || data[2] > WORLD_MAX_WIDTH
+					|| data[3] > WORLD_MAX_HEIGHT) {
+				return 0;
+			}
+			level = data[0] | (data[1] << 7);
+			width = data[2];
+			height = data[3];
+			game_over = 0;
+			memset(field, UNDISCOVERED, sizeof(field));
+			synced = 1;
+			return 1;
+		case SPECTATOR_ROW: {
+			if (length < 2 || data[0] >= height) {
+				return 0;
+			}
+			uint8_t x = data[1];
+			for (uint8_t i = 2; i < length; i++) {
+				for (uint8_t count = (data[i] >> 4) + 1; count; count--) {
+					if (x < width) {
+						field[data[0]][x++] = data[i] & 0x0F;
+					}
+				}
+			}
+			return 1;
+		}
+		case SPECTATOR_SQUARE:
+			if (length != 3 || data[0] >= width || data[1] >= height) {
+				return 0;
+			}
+			field[data[1]][data[0]] = data[2];
+			return 1;
+		case SPECTATOR_PLAYER:
+			if (length != 2) {
+				return 0;
+			}
+			player_x = data[0];
+			player_y = data[1];
+			return 1;
+		case SPECTATOR_SCORE:
+			if (length != 2) {
+				return 0;
+			}
+			score = data[0];
+			diamonds_available = data[1];
+			return 1;
+		case SPECTATOR_GAME_OVER:
+			game_over = 1;
+			return length == 0;
+		default:
+			return 0;
+	}
+}
+
+// returns 1 if a record of type 'type' with 'length' data bytes is 
+// complete
+static uint8_t complete(uint8_t type, const uint8_t* data, uint8_t length) {
+	switch (type) {
+		case SPECTATOR_LEVEL:
+			return length == 4;
+		case SPECTATOR_SQUARE:
+			return length == 3;
+		case SPECTATOR_PLAYER:
+		case SPECTATOR_SCORE:
+			return length == 2;
+		case SPECTATOR_ROW: {
+			if (length < 2) {
+				return 0;
+			}
+			// the runs cover SPECTATOR_ROW_LENGTH squares, or up to the 
+			// end of the row
+			uint16_t squares = 0;
+			for (uint8_t i = 2; i < length; i++) {
+				squares += (data[i] >> 4) + 1;
+			}
+			return squares >= SPECTATOR_ROW_LENGTH 
+					|| data[1] + squares >= width;
+		}
+		default:
+			return 1;
+	}
+}
+
+// returns 1 if there is more of the feed waiting to be read
+static uint8_t feed_waiting(void) {
+	struct pollfd input = {0, POLLIN, 0};
+	return poll(&input, 1, 0) > 0;
+}
+
+int main(void) {
+	uint8_t type = 0; // the record being received, 0 between records
+	uint8_t data[MAX_RECORD_DATA];
+	uint8_t length = 0;
+	uint32_t errors = 0;
+	int c;
+
+	// read unbuffered, so that a pause in the feed can be seen
+	setvbuf(stdin, NULL, _IONBF, 0);
+	while ((c = getchar()) != EOF) {
+		if (c & 0x80) {
+			if (type) {
+				// the last record was cut short
+				errors++;
+			}
+			type = c;
+			length = 0;
+		} else if (type && length < MAX_RECORD_DATA) {
+			data[length++] = c;
+		} else {
+			// part of a record whose start was missed
+			continue;
+		}
+		if (complete(type, data, length)) {
+			if (!apply(type, data, length)) {
+				errors++;
+			}
+			type = 0;
+		}
+		if (!feed_waiting()) {
+			draw();
+		}
+	}
+	draw();
+	fprintf(stderr, "%lu malformed records\n", (unsigned long)errors);
+	return 0;
+}
@@ -0,0 +1,34 @@
+/*
+ * spi.c
+ *
+ * Author: William Sawyer
+ *
+ * Host replacement for spi.c. Bytes sent to the LED matrix are counted
+ * and passed to spi_matrix_emulator, if one has been set up, and to
+ * spi_byte_hook, if it is set.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "spi.h"
+#include "emulator.h"
+
+uint32_t spi_bytes_sent;
+MatrixEmulator* spi_matrix_emulator;
+void (*spi_byte_hook)(uint8_t byte);
+
+void spi_setup_master(uint8_t clockdivider) {
+	(void)clockdivider;
+}
+
+uint8_t spi_send_byte(uint8_t byte) {
+	spi_bytes_sent++;
+	if (spi_matrix_emulator) {
+		matrix_emulator_feed(spi_matrix_emulator, &byte, 1);
+	}
+	if (spi_byte_hook) {
+		spi_byte_hook(byte);
+	}
+	return 0;
+}
@@ -0,0 +1,38 @@
+/*
+ * storage.c
+ *
+ * Author: William Sawyer
+ *
+ * Host replacement for storage.c. The EEPROM is kept in memory, which
+ * starts erased, and writes are carried out straight away. The bytes
+ * which would have been programmed are counted.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "storage.h"
+
+#define EEPROM_SIZE	1024
+
+uint8_t storage_eeprom[EEPROM_SIZE] = {[0 ... EEPROM_SIZE - 1] = 0xFF};
+uint32_t storage_bytes_programmed;
+
+uint8_t storage_write(uint16_t address, const void* data, uint8_t length) {
+	const uint8_t* bytes = data;
+	for (uint8_t i = 0; i < length && address + i < EEPROM_SIZE; i++) {
+		if (storage_eeprom[address + i] != bytes[i]) {
+			storage_eeprom[address + i] = bytes[i];
+			storage_bytes_programmed++;
+		}
+	}
+	return 1;
+}
+
+uint8_t storage_busy(void) {
+	return 0;
+}
+
+void storage_read(uint16_t address, void* data, uint8_t length) {
+	memcpy(data, &storage_eeprom[address], length);
+}
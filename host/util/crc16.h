@@ -0,0 +1,22 @@
+/*
+ * crc16.h
+ *
+ * Author: William Sawyer
+ *
+ * Host stand-in for <util/crc16.h>, with the one CRC the game uses. It
+ * is the C version avr-libc gives for its assembly.
+ */
+
+#ifndef HOST_CRC16_H_
+#define HOST_CRC16_H_
+
+#include <stdint.h>
+
+static inline uint16_t _crc_ccitt_update(uint16_t crc, uint8_t data) {
+	data ^= crc & 0xFF;
+	data ^= data << 4;
+	return ((((uint16_t)data << 8) | (crc >> 8)) ^ (uint8_t)(data >> 4) 
+			^ ((uint16_t)data << 3));
+}
+
+#endif /* HOST_CRC16_H_ */
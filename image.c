@@ -0,0 +1,61 @@
+/*
+ * image.c
+ *
+ * Author: William Sawyer
+ *
+ * Decoding of run length encoded bitplane images. See image.h and 
+ * host/imgpack.c for the format.
+ */
+
+#include <avr/pgmspace.h>
+
+#include "image.h"
+
+void image_open(ImageReader* reader, const uint8_t* image) {
+	reader->planes = pgm_read_byte(&image[0]);
+	reader->palette = &image[1];
+	reader->pixel = 0;
+	
+	// each plane is preceded by its encoded length
+	const uint8_t* plane_start = &image[1 + (1 << reader->planes)];
+	for (uint8_t p = 0; p < reader->planes; p++) {
+		reader->plane[p].next = plane_start + 1;
+		reader->plane[p].run = 0;
+		plane_start += pgm_read_byte(plane_start) + 1;
+	}
+}
+
+// returns the next decoded byte of a plane
+static uint8_t image_next_byte(ImagePlane* plane) {
+	if (!plane->run) {
+		// start a new run - the top bit of the control byte says whether
+		// one byte is repeated, the rest is the length (less one)
+		uint8_t control = pgm_read_byte(plane->next++);
+		plane->repeating = control & 0x80;
+		plane->run = (control & 0x7F) + 1;
+		if (plane->repeating) {
+			plane->value = pgm_read_byte(plane->next++);
+		}
+	}
+	plane->run--;
+	if (plane->repeating) {
+		return plane->value;
+	}
+	return pgm_read_byte(plane->next++);
+}
+
+PixelColour image_next_pixel(ImageReader* reader) {
+	uint8_t bit = reader->pixel & 0x07;
+	uint8_t index = 0;
+	for (uint8_t p = 0; p < reader->planes; p++) {
+		ImagePlane* plane = &reader->plane[p];
+		if (bit == 0) {
+			plane->bits = image_next_byte(plane);
+		}
+		if (plane->bits & (0x80 >> bit)) {
+			index |= 1 << p;
+		}
+	}
+	reader->pixel++;
+	return pgm_read_byte(&reader->palette[index]);
+}
@@ -0,0 +1,48 @@
+/*
+ * image.h
+ *
+ * Author: William Sawyer
+ *
+ * Full screen images stored in program memory. Each image is a palette 
+ * of up to four colours and one or two bitplanes (bit n of a pixel's
+ * palette index is in plane n), each plane run length encoded. Images
+ * are produced from text drawings by host/imgpack.c.
+ *
+ * An ImageReader decodes the pixels in the order the LED matrix expects 
+ * them for a full screen update (bottom row first, left to right) 
+ * without needing a buffer for the whole screen.
+ */
+
+#ifndef IMAGE_H_
+#define IMAGE_H_
+
+#include <stdint.h>
+
+#include "pixel_colour.h"
+
+#define IMAGE_MAX_PLANES	2
+
+typedef struct {
+	const uint8_t* next;	// next byte of encoded data
+	uint8_t run;			// bytes left in the current run
+	uint8_t repeating;		// whether the current run repeats one byte
+	uint8_t value;			// the byte being repeated
+	uint8_t bits;			// the byte pixels are currently taken from
+} ImagePlane;
+
+typedef struct {
+	const uint8_t* palette;
+	uint8_t planes;
+	uint8_t pixel;			// index of the next pixel
+	ImagePlane plane[IMAGE_MAX_PLANES];
+} ImageReader;
+
+/* Start reading the given image (which must be in program memory).
+ */
+void image_open(ImageReader* reader, const uint8_t* image);
+
+/* Return the colour of the next pixel of the image.
+ */
+PixelColour image_next_pixel(ImageReader* reader);
+
+#endif /* IMAGE_H_ */
@@ -0,0 +1,42 @@
+/*
+ * images.c
+ *
+ * Author: William Sawyer
+ *
+ * Generated with host/imgpack.c from the drawings in images/ - edit 
+ * those and regenerate rather than editing these by hand.
+ */
+
+#include <avr/pgmspace.h>
+
+#include "images.h"
+
+const uint8_t miners_image[] PROGMEM = 
+		{
+			2,	// bitplanes
+			0x00, 0xF0, 0x0F, 0x00,	// palette
+			14,	// plane 0 length
+			0x83, 0x00, 0x08, 0x01, 0x00, 0x03, 0x80, 0x07, 0xC0, 0x03, 0x80, 0x01, 0x82, 0x00,
+			15,	// plane 1 length
+			0x83, 0x00, 0x0B, 0xE0, 0x11, 0x90, 0x11, 0x90, 0x15, 0x90, 0x1B, 0xE0, 0x11, 0x00, 0x00
+		};
+
+const uint8_t game_image[] PROGMEM = 
+		{
+			2,	// bitplanes
+			0x00, 0xF0, 0x0F, 0x00,	// palette
+			14,	// plane 0 length
+			0x0A, 0x09, 0x07, 0x09, 0x04, 0x0F, 0x07, 0x09, 0x04, 0x09, 0x07, 0x0F, 0x84, 0x00,
+			13,	// plane 1 length
+			0x85, 0x00, 0x09, 0xF0, 0x88, 0x90, 0x88, 0xB0, 0xA8, 0x80, 0xA8, 0xF0, 0xD8
+		};
+
+const uint8_t over_image[] PROGMEM = 
+		{
+			2,	// bitplanes
+			0x00, 0xF0, 0x0F, 0x00,	// palette
+			13,	// plane 0 length
+			0x85, 0x00, 0x81, 0xF0, 0x07, 0x90, 0x80, 0x90, 0xE0, 0x90, 0x80, 0xF0, 0xF0,
+			14,	// plane 1 length
+			0x05, 0x06, 0x09, 0x09, 0x0A, 0x09, 0x0E, 0x83, 0x09, 0x01, 0x00, 0x0E, 0x83, 0x00
+		};
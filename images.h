@@ -0,0 +1,18 @@
+/*
+ * images.h
+ *
+ * Author: William Sawyer
+ *
+ * Full screen images for the LED matrix, see image.h.
+ */
+
+#ifndef IMAGES_H_
+#define IMAGES_H_
+
+#include <stdint.h>
+
+extern const uint8_t miners_image[];	// "D <> M" start screen
+extern const uint8_t game_image[];		// "GAME" half of the game over screen
+extern const uint8_t over_image[];		// "OVER" half of the game over screen
+
+#endif /* IMAGES_H_ */
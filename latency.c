@@ -0,0 +1,147 @@
+/*
+ * latency.c
+ *
+ * Author: William Sawyer
+ *
+ * Input to display latency histograms. Latencies are bucketed with
+ * four buckets per power of two (so each bucket is within 25% of its
+ * neighbours) from 64us up to 256ms.
+ */
+
+#include <stdio.h>
+#include <avr/pgmspace.h>
+
+#include "latency.h"
+#include "terminalio.h"
+
+#if PROFILE
+
+#include "timer1.h"
+
+#define LATENCY_MIN_SHIFT	6	// anything faster than 64us goes in bucket 0
+#define LATENCY_MAX_SHIFT	18	// anything 256ms or slower goes in the last bucket
+#define LATENCY_SUB_BUCKETS	4
+#define LATENCY_NUM_BUCKETS ((LATENCY_MAX_SHIFT - LATENCY_MIN_SHIFT) \
+		* LATENCY_SUB_BUCKETS + 2)
+
+typedef struct {
+	uint16_t count;
+	uint32_t max;	// in microseconds
+	uint16_t buckets[LATENCY_NUM_BUCKETS];
+} LatencyHistogram;
+
+static LatencyHistogram idle, busy;
+
+// cycle count when the input waiting to be handled arrived
+static volatile uint32_t input_time;
+static volatile uint8_t input_pending;
+
+void latency_mark_input(void) {
+	if (!input_pending) {
+		input_time = get_cycle_count();
+		input_pending = 1;
+	}
+}
+
+void latency_discard(void) {
+	input_pending = 0;
+}
+
+// returns which bucket a latency (in microseconds) belongs in
+static uint8_t latency_bucket(uint32_t micros) {
+	if (micros < (1UL << LATENCY_MIN_SHIFT)) {
+		return 0;
+	}
+	uint8_t msb = LATENCY_MIN_SHIFT;
+	while (msb < LATENCY_MAX_SHIFT && (micros >> (msb + 1))) {
+		msb++;
+	}
+	if (msb >= LATENCY_MAX_SHIFT) {
+		return LATENCY_NUM_BUCKETS - 1;
+	}
+	// the two bits below the most significant bit pick the sub bucket
+	uint8_t sub = (micros >> (msb - 2)) & (LATENCY_SUB_BUCKETS - 1);
+	return (msb - LATENCY_MIN_SHIFT) * LATENCY_SUB_BUCKETS + sub + 1;
+}
+
+// returns the largest latency (in microseconds) that could be in a bucket
+static uint32_t latency_bucket_limit(uint8_t bucket) {
+	if (bucket == 0) {
+		return (1UL << LATENCY_MIN_SHIFT) - 1;
+	}
+	bucket--;
+	uint8_t msb = bucket / LATENCY_SUB_BUCKETS + LATENCY_MIN_SHIFT;
+	uint8_t sub = bucket % LATENCY_SUB_BUCKETS;
+	return ((uint32_t)(LATENCY_SUB_BUCKETS + sub + 1) << (msb - 2)) - 1;
+}
+
+void latency_input_handled(uint8_t is_busy) {
+	if (!input_pending) {
+		// the input was not timestamped
+		return;
+	}
+	uint32_t micros = (get_cycle_count() - input_time) / 8;
+	input_pending = 0;
+	
+	LatencyHistogram* h = is_busy ? &busy : &idle;
+	uint8_t bucket = latency_bucket(micros);
+	if (h->count != UINT16_MAX) {
+		h->count++;
+		h->buckets[bucket]++;
+	}
+	if (micros > h->max) {
+		h->max = micros;
+	}
+}
+
+// returns an upper bound on the given percentile of the histogram
+static uint32_t latency_percentile(LatencyHistogram* h, uint8_t percentile) {
+	// the number of samples which must be at or below the percentile,
+	// rounded up
+	uint16_t needed = ((uint32_t)h->count * percentile + 99) / 100;
+	uint16_t seen = 0;
+	for (uint8_t b = 0; b < LATENCY_NUM_BUCKETS; b++) {
+		seen += h->buckets[b];
+		if (seen >= needed) {
+			if (b == LATENCY_NUM_BUCKETS - 1) {
+				break;
+			}
+			return latency_bucket_limit(b);
+		}
+	}
+	return h->max;
+}
+
+static void latency_print(LatencyHistogram* h) {
+	printf_P(PSTR(" n=%u"), h->count);
+	if (h->count) {
+		printf_P(PSTR(" p50<=%luus p90<=%luus p99<=%luus max=%luus"),
+				latency_percentile(h, 50), latency_percentile(h, 90),
+				latency_percentile(h, 99), h->max);
+	}
+	printf_P(PSTR("\n"));
+	
+	h->count = 0;
+	h->max = 0;
+	for (uint8_t b = 0; b < LATENCY_NUM_BUCKETS; b++) {
+		h->buckets[b] = 0;
+	}
+}
+
+void latency_report(void) {
+	move_terminal_cursor(DEBUG_X, DEBUG_Y);
+	clear_to_end_of_screen();
+	printf_P(PSTR("Input latency\nidle"));
+	latency_print(&idle);
+	printf_P(PSTR("busy"));
+	latency_print(&busy);
+}
+
+#else
+
+void latency_report(void) {
+	move_terminal_cursor(DEBUG_X, DEBUG_Y);
+	printf_P(PSTR("Latency not compiled in (PROFILE=0)"));
+}
+
+#endif /* PROFILE */
@@ -0,0 +1,56 @@
+/*
+ * latency.h
+ *
+ * Author: William Sawyer
+ *
+ * Measures the time from an input arriving (a button push or a serial
+ * character, timestamped in the interrupt handler) to the end of the 
+ * display update it caused. Since spi_send_byte() busy waits, once the
+ * game has finished handling an input the last SPI byte of the update
+ * has been sent.
+ *
+ * Samples are kept in two histograms - one for when the game is "busy"
+ * (a bomb is flashing or the terminal still has output to send) and
+ * one for when it is not - so the effect of SPI and UART load can be 
+ * seen. Like the profiler, this is only compiled in when PROFILE is 1.
+ */
+
+#ifndef LATENCY_H_
+#define LATENCY_H_
+
+#include <stdint.h>
+
+#include "profile.h"
+
+#if PROFILE
+
+/* Record the time an input arrived. Called from interrupt handlers. If an
+ * earlier input has not been handled yet, this one is not timestamped.
+ */
+void latency_mark_input(void);
+
+/* Called once the game has handled the input (including updating the
+ * display). busy indicates whether the game was under SPI/UART load.
+ */
+void latency_input_handled(uint8_t busy);
+
+/* Forget the input waiting to be timed, if any. Call this when an input 
+ * is handled outside the game loop (on the start, pause or game over 
+ * screens), so the wait isn't counted in the next input's latency.
+ */
+void latency_discard(void);
+
+#else
+
+#define latency_mark_input()
+#define latency_input_handled(busy)
+#define latency_discard()
+
+#endif /* PROFILE */
+
+/* Print the 50th, 90th and 99th percentile and maximum latencies to the 
+ * terminal (below the game) and start recording afresh.
+ */
+void latency_report(void);
+
+#endif /* LATENCY_H_ */
@@ -0,0 +1,105 @@
+/*
+ * levels.c
+ *
+ * Author: William Sawyer
+ *
+ * Level layouts, see levels.h for the format. Generated by
+ * host/levelc.c from the maps in levels/, edit those instead.
+ */
+
+#include <avr/pgmspace.h>
+
+#include "levels.h"
+
+#if NUM_LEVELS != 3
+#error "NUM_LEVELS doesn't match the number of maps"
+#endif
+
+static const uint8_t level_1_terrain[] PROGMEM = 
+		{
+			0x80, 0x10, 0x42, 0x81, 0x40, 0x10, 0x11, 0x81, 0x80, 0x2A, 0x02, 0x86,
+			0x9A, 0x20, 0x98, 0xA0, 0x88, 0x10, 0x08, 0x08, 0x88, 0x2A, 0x01, 0x88,
+			0x88, 0x40, 0x9A, 0x84, 0x44, 0x80, 0x82, 0x88
+		};
+
+static const uint8_t level_1_visible[] PROGMEM = 
+		{
+			0x0F, 0x00, 0x0F, 0x00, 0x0F, 0x00, 0x07, 0x00, 0x00, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00
+		};
+
+static const uint8_t level_2_terrain[] PROGMEM = 
+		{
+			0x80, 0xA9, 0x4A, 0x20, 0x80, 0x05, 0x88, 0x2A, 0x40, 0x20, 0x08, 0x50,
+			0xAA, 0xA0, 0x09, 0x2A, 0x84, 0x00, 0x88, 0x44, 0xA9, 0x12, 0x84, 0x48,
+			0x00, 0x81, 0x8A, 0x88, 0x9A, 0xA2, 0x95, 0x84
+		};
+
+static const uint8_t level_2_visible[] PROGMEM = 
+		{
+			0x0F, 0x00, 0x0F, 0x00, 0x0F, 0x00, 0x07, 0x00, 0x00, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00
+		};
+
+static const uint8_t level_3_terrain[] PROGMEM = 
+		{
+			0x00, 0x00, 0x40, 0xA5, 0x5A, 0x09, 0x80, 0x00, 0x40, 0x19, 0x00, 0xA4,
+			0x66, 0x05, 0x00, 0x40, 0x00, 0x24, 0x40, 0x56, 0x15, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x94, 0xA8, 0x1A, 0x00, 0x00, 0x48, 0x00, 0x24, 0x04, 0x58,
+			0x1A, 0x00, 0x02, 0x10, 0x49, 0x00, 0x96, 0x00, 0x00, 0x00, 0x08, 0x00,
+			0x15, 0x55, 0x24, 0x50, 0x25, 0x00, 0x00, 0x90, 0xAA, 0x40, 0xA5, 0x10,
+			0x00, 0x95, 0x05, 0x00, 0x95, 0x65, 0x02, 0x24, 0x00, 0x08, 0x00, 0xA2,
+			0x99, 0x45, 0x02, 0x90, 0x05, 0x66, 0x25, 0x41, 0xA6, 0x69, 0x95, 0x00,
+			0x00, 0x40, 0x60, 0xA0, 0x66, 0x64, 0x80, 0x80, 0x2A, 0x80, 0x99, 0x81,
+			0x95, 0x99, 0xAA, 0x40, 0x00, 0x00, 0x00, 0x00, 0x60, 0x00, 0x40, 0x42,
+			0x16, 0x80, 0x95, 0x81, 0xA5, 0x66, 0x66, 0x56, 0x16, 0x98, 0x02, 0x00,
+			0x20, 0x00, 0x00, 0x69, 0x15, 0x80, 0x6A, 0x16, 0x5A, 0x56, 0x6A, 0x5A,
+			0x5A, 0x69, 0x01, 0x00, 0x10, 0x00, 0x05, 0x58, 0x16, 0x50, 0xA9, 0x09,
+			0x6A, 0x65, 0xA5, 0xA5, 0x55, 0x9A, 0x09, 0x00, 0x00, 0x00, 0x00, 0x68,
+			0x59, 0x60, 0x99, 0x06, 0xA6, 0x5A, 0x55, 0x55, 0x55, 0x99, 0x41, 0x08,
+			0x00, 0x00, 0x00, 0x08, 0x00, 0x00, 0x59, 0x05, 0xA9, 0x96, 0xA9, 0x9A,
+			0xA5, 0x00, 0x50, 0x0A, 0x00, 0x00, 0x20, 0x00, 0x00, 0x00, 0xA4, 0x02,
+			0xA6, 0x9A, 0x56, 0x99, 0x25, 0x00, 0x50, 0x2A, 0x00, 0x00, 0x01, 0x00,
+			0x00, 0x00, 0x00, 0x00, 0x59, 0xAA, 0xA9, 0x69, 0x19, 0x00, 0xA0, 0x09,
+			0x09, 0x00, 0x16, 0x10, 0x00, 0x00, 0x40, 0x00, 0x09, 0x60, 0x9A, 0x05,
+			0x40, 0x00, 0x54, 0x1A, 0x00, 0x00, 0x56, 0x00, 0x09, 0x24, 0x0A, 0x00,
+			0x05, 0x60, 0x6A, 0x99, 0x81, 0x61, 0xA5, 0xAA, 0x29, 0x08, 0x16, 0x00,
+			0x00, 0x00, 0x05, 0x00, 0x09, 0x60, 0x56, 0x5A, 0x00, 0x60, 0x01, 0x19,
+			0xA4, 0x06, 0x00, 0x00, 0x80, 0x09, 0x00, 0x00, 0x8A, 0x98, 0x59, 0x66,
+			0x01, 0xA4, 0x00, 0x00, 0x40, 0x02, 0x00, 0xA9, 0x90, 0x25, 0x00, 0x08,
+			0x99, 0x64, 0x99, 0x15, 0x00, 0x02, 0x50, 0x00, 0x00, 0x40, 0x00, 0x55,
+			0x50, 0x95, 0x50, 0x00, 0x99, 0x54, 0x59, 0x0A, 0x45, 0x02, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00, 0x40, 0x02, 0x59, 0x00, 0x9A, 0xA0, 0x0A, 0x00,
+			0x06, 0x00, 0x58, 0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x40, 0x00,
+			0x95, 0x00, 0x1A, 0x98, 0x20, 0x80, 0x65, 0x06, 0x80, 0x99, 0x00, 0x00,
+			0x00, 0x10, 0x00, 0x00, 0x69, 0x09, 0x64, 0x16, 0x00, 0x98, 0x66, 0x1A,
+			0x02, 0xA9, 0xA6, 0x20, 0x04, 0x00, 0x00, 0x02, 0x59, 0x1A, 0x40, 0x00,
+			0x05, 0x58, 0x96, 0xA9, 0x02, 0x99, 0xA9, 0x01, 0x00, 0x00, 0x61, 0x05
+		};
+
+static const uint8_t level_3_visible[] PROGMEM = 
+		{
+			0xFF, 0x0F, 0xF8, 0xFF, 0xFF, 0x3F, 0xF8, 0xFF, 0xFF, 0x1F, 0xFC, 0xFF,
+			0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x3F, 0xFC, 0xFF, 0xFF, 0xF9, 0xFF, 0xFF,
+			0x9F, 0xFF, 0xFF, 0xFF, 0xFC, 0xFE, 0xFF, 0xFF, 0x08, 0xFF, 0xFF, 0x7F,
+			0xF0, 0xFF, 0x7F, 0xFC, 0x00, 0xFE, 0xFF, 0xFF, 0xFB, 0xFF, 0xFC, 0xF8,
+			0x00, 0xF8, 0xFF, 0xFF, 0xFF, 0xFF, 0xFC, 0xF0, 0x00, 0x70, 0xFF, 0xFF,
+			0xFF, 0x7F, 0xFC, 0xE0, 0x00, 0x00, 0x18, 0xFF, 0xFF, 0x3F, 0x7C, 0xE0,
+			0x00, 0x00, 0x00, 0xFE, 0xFF, 0xFF, 0xFF, 0xE0, 0x00, 0x00, 0xF0, 0xFF,
+			0xFF, 0xFF, 0xFF, 0xE1, 0x00, 0x00, 0xF8, 0xF7, 0xFF, 0xFF, 0xFF, 0xFF,
+			0x00, 0x00, 0xFC, 0xC7, 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0xC0, 0xFF, 0xE7,
+			0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0xE0, 0xFF, 0xC3, 0xFF, 0xF9, 0xFF, 0xFF,
+			0x00, 0xC0, 0xFF, 0x8F, 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0x80, 0x7F, 0xFF,
+			0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0x80, 0xFF, 0xFF, 0xFF, 0xFF, 0xC7, 0xFF,
+			0x00, 0xC0, 0xFF, 0xFF, 0xFF, 0xFF, 0xE7, 0xFF, 0x00, 0xFC, 0xFF, 0xFF,
+			0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0xFE, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+			0x00, 0xFC, 0xFF, 0xE1, 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0xF8, 0x7F, 0xC0,
+			0x1F, 0xFF, 0xFF, 0xFF, 0x00, 0xF8, 0x3F, 0x80, 0x1F, 0xF0, 0xFF, 0xEF
+		};
+
+const Level levels[NUM_LEVELS] PROGMEM = 
+		{
+			{16, 8, 15, 4, 3, {{14, 0}, {4, 3}, {0, 4}}, level_1_terrain, level_1_visible},
+			{16, 8, 15, 1, 4, {{12, 0}, {7, 2}, {3, 6}, {12, 6}}, level_2_terrain, level_2_visible},
+			{64, 24, 63, 16, 8, {{4, 0}, {51, 2}, {28, 6}, {56, 12}, {45, 20}, {16, 21}, {44, 22}, {52, 23}}, level_3_terrain, level_3_visible}
+		};
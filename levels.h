@@ -0,0 +1,52 @@
+/*
+ * levels.h
+ *
+ * Author: William Sawyer
+ *
+ * Level layouts, stored in program memory. The terrain of each level is
+ * packed 2 bits per square (see the TERRAIN_ values below), four squares
+ * to a byte with the lowest bits first, going left to right along each 
+ * row from the bottom row (y = 0) up - the same layout game.c keeps in
+ * RAM, so loading a level is a straight copy. Diamonds and the exit sit 
+ * on empty terrain and are listed separately. The squares visible at the
+ * start of the level are packed 1 bit per square in the same order.
+ *
+ * levels.c is generated by host/levelc.c from the text maps in levels/,
+ * which also checks that each level can be played.
+ */
+
+#ifndef LEVELS_H_
+#define LEVELS_H_
+
+#include <stdint.h>
+#include <avr/pgmspace.h>
+
+// terrain values
+#define TERRAIN_EMPTY		0
+#define TERRAIN_BREAKABLE	1
+#define TERRAIN_UNBREAKABLE	2
+#define TERRAIN_INSPECTED	3
+
+// the largest world a level may have. game.c keeps the whole world in
+// RAM (a 64x24 world takes 576 bytes), so this is no bigger than the 
+// levels need.
+#define WORLD_MAX_WIDTH		64
+#define WORLD_MAX_HEIGHT	24
+
+#define MAX_DIAMONDS		16
+
+typedef struct {
+	uint8_t width;
+	uint8_t height;
+	uint8_t exit_x, exit_y;
+	uint8_t num_diamonds;
+	uint8_t diamonds[MAX_DIAMONDS][2];
+	const uint8_t* terrain;
+	const uint8_t* visible;
+} Level;
+
+#define NUM_LEVELS 3
+
+extern const Level levels[NUM_LEVELS] PROGMEM;
+
+#endif /* LEVELS_H_ */
@@ -0,0 +1,190 @@
+/*
+ * marquee.c
+ *
+ * Author: William Sawyer
+ */
+
+#include <string.h>
+#include <avr/pgmspace.h>
+
+#include "marquee.h"
+#include "ledmatrix.h"
+
+#define GLYPH_WIDTH		3
+#define GLYPH_HEIGHT	5
+// the row of the matrix the top of each glyph is drawn on
+#define GLYPH_TOP_ROW	6
+
+// each glyph is stored as 3 columns, the least significant bit of 
+// each being the top row
+static const uint8_t font[][GLYPH_WIDTH] PROGMEM = 
+		{
+			{0x00, 0x00, 0x00},	// ' '
+			{0x00, 0x17, 0x00},	// '!'
+			{0x04, 0x04, 0x04},	// '-'
+			{0x00, 0x0A, 0x00},	// ':'
+			{0x1F, 0x11, 0x1F},	// '0'
+			{0x12, 0x1F, 0x10},	// '1'
+			{0x1D, 0x15, 0x17},	// '2'
+			{0x11, 0x15, 0x1F},	// '3'
+			{0x07, 0x04, 0x1F},	// '4'
+			{0x17, 0x15, 0x1D},	// '5'
+			{0x1F, 0x15, 0x1D},	// '6'
+			{0x01, 0x1D, 0x03},	// '7'
+			{0x1F, 0x15, 0x1F},	// '8'
+			{0x17, 0x15, 0x1F},	// '9'
+			{0x1E, 0x05, 0x1E},	// 'A'
+			{0x1F, 0x15, 0x0A},	// 'B'
+			{0x0E, 0x11, 0x11},	// 'C'
+			{0x1F, 0x11, 0x0E},	// 'D'
+			{0x1F, 0x15, 0x11},	// 'E'
+			{0x1F, 0x05, 0x01},	// 'F'
+			{0x0E, 0x11, 0x1D},	// 'G'
+			{0x1F, 0x04, 0x1F},	// 'H'
+			{0x11, 0x1F, 0x11},	// 'I'
+			{0x08, 0x10, 0x0F},	// 'J'
+			{0x1F, 0x04, 0x1B},	// 'K'
+			{0x1F, 0x10, 0x10},	// 'L'
+			{0x1F, 0x06, 0x1F},	// 'M'
+			{0x1F, 0x01, 0x1E},	// 'N'
+			{0x0E, 0x11, 0x0E},	// 'O'
+			{0x1F, 0x05, 0x02},	// 'P'
+			{0x0E, 0x19, 0x1E},	// 'Q'
+			{0x1F, 0x05, 0x1A},	// 'R'
+			{0x12, 0x15, 0x09},	// 'S'
+			{0x01, 0x1F, 0x01},	// 'T'
+			{0x1F, 0x10, 0x1F},	// 'U'
+			{0x0F, 0x10, 0x0F},	// 'V'
+			{0x1F, 0x0C, 0x1F},	// 'W'
+			{0x1B, 0x04, 0x1B},	// 'X'
+			{0x03, 0x1C, 0x03},	// 'Y'
+			{0x19, 0x15, 0x13}	// 'Z'
+		};
+#define FONT_DIGITS		4
+#define FONT_LETTERS	14
+
+// sprites are stored as a width followed by that many columns. The top
+// 7 bits of each column are rows 7 down to 1 and the least significant 
+// bit picks the colour (1 red, 0 green)
+static const uint8_t diamond_sprite[] PROGMEM = {5, 16, 56, 124, 56, 16};
+static const uint8_t bomb_sprite[] PROGMEM = {5, 57, 125, 125, 57, 192};
+static PGM_P const sprites[MARQUEE_NUM_SPRITES] PROGMEM = 
+		{(PGM_P)diamond_sprite, (PGM_P)bomb_sprite};
+
+// the message being scrolled
+static char message_copy[MARQUEE_MAX_LENGTH + 1];
+static const char* message;
+static uint8_t message_in_flash;
+static PixelColour message_colour;
+
+// position within the message - the character being drawn, which column
+// of it is next and how many blank columns are left to scroll the 
+// message off the display once it has finished
+static uint8_t char_index;
+static uint8_t char_column;
+static uint8_t trailing_columns;
+
+void marquee_start(const char* text, PixelColour colour) {
+	strncpy(message_copy, text, MARQUEE_MAX_LENGTH);
+	message_copy[MARQUEE_MAX_LENGTH] = '\0';
+	message = message_copy;
+	message_in_flash = 0;
+	message_colour = colour;
+	char_index = 0;
+	char_column = 0;
+	trailing_columns = MATRIX_NUM_COLUMNS;
+}
+
+void marquee_start_P(PGM_P text, PixelColour colour) {
+	message = text;
+	message_in_flash = 1;
+	message_colour = colour;
+	char_index = 0;
+	char_column = 0;
+	trailing_columns = MATRIX_NUM_COLUMNS;
+}
+
+// returns the index into the font of character c
+static uint8_t glyph_index(char c) {
+	if (c >= 'a' && c <= 'z') {
+		c += 'A' - 'a';
+	}
+	if (c >= 'A' && c <= 'Z') {
+		return FONT_LETTERS + c - 'A';
+	} else if (c >= '0' && c <= '9') {
+		return FONT_DIGITS + c - '0';
+	} else if (c == '!') {
+		return 1;
+	} else if (c == '-') {
+		return 2;
+	} else if (c == ':') {
+		return 3;
+	}
+	return 0;
+}
+
+// fills in the next column of the message, returns 1 if this was the 
+// last column of the current character
+static uint8_t next_column(MatrixColumn column) {
+	char c;
+	if (message_in_flash) {
+		c = pgm_read_byte(&message[char_index]);
+	} else {
+		c = message[char_index];
+	}
+	
+	set_matrix_column_to_colour(column, COLOUR_BLACK);
+	if (c >= MARQUEE_SPRITE(0) && c < MARQUEE_SPRITE(MARQUEE_NUM_SPRITES)) {
+		PGM_P sprite = (PGM_P)pgm_read_ptr(&sprites[c - MARQUEE_SPRITE(0)]);
+		uint8_t width = pgm_read_byte(&sprite[0]);
+		if (char_column < width) {
+			uint8_t data = pgm_read_byte(&sprite[char_column + 1]);
+			PixelColour colour = (data & 0x01) ? COLOUR_RED : COLOUR_GREEN;
+			for (uint8_t row = 1; row < MATRIX_NUM_ROWS; row++) {
+				if (data & (1 << row)) {
+					column[row] = colour;
+				}
+			}
+		}
+		// a blank column is left after the sprite
+		return char_column++ == width;
+	}
+	
+	if (char_column < GLYPH_WIDTH) {
+		uint8_t data = pgm_read_byte(&font[glyph_index(c)][char_column]);
+		for (uint8_t row = 0; row < GLYPH_HEIGHT; row++) {
+			if (data & (1 << row)) {
+				column[GLYPH_TOP_ROW - row] = message_colour;
+			}
+		}
+	}
+	// a blank column is left after each character
+	return char_column++ == GLYPH_WIDTH;
+}
+
+uint8_t marquee_step(void) {
+	MatrixColumn column;
+	uint8_t at_end;
+	
+	if (message_in_flash) {
+		at_end = pgm_read_byte(&message[char_index]) == '\0';
+	} else {
+		at_end = message[char_index] == '\0';
+	}
+	
+	if (!at_end) {
+		if (next_column(column)) {
+			char_index++;
+			char_column = 0;
+		}
+	} else if (trailing_columns) {
+		set_matrix_column_to_colour(column, COLOUR_BLACK);
+		trailing_columns--;
+	} else {
+		return 1;
+	}
+	
+	ledmatrix_shift_display_left();
+	ledmatrix_update_column(MATRIX_NUM_COLUMNS - 1, column);
+	return 0;
+}
@@ -0,0 +1,52 @@
+/*
+ * marquee.h
+ *
+ * Author: William Sawyer
+ *
+ * Scrolls messages across the LED matrix from right to left. Rather
+ * than redrawing the whole display, each step shifts the display left
+ * (2 SPI bytes) and sends only the newly exposed column (10 SPI bytes).
+ * Text is drawn with a 3x5 font stored in program memory. A character
+ * from MARQUEE_SPRITE(0) to MARQUEE_SPRITE(MARQUEE_NUM_SPRITES-1) in the
+ * message draws a small sprite instead of text.
+ */
+
+#ifndef MARQUEE_H_
+#define MARQUEE_H_
+
+#include <stdint.h>
+#include <avr/pgmspace.h>
+
+#include "pixel_colour.h"
+
+// how often marquee_step() should be called (milliseconds)
+#define MARQUEE_STEP_DELAY	75
+
+// longest message that can be passed to marquee_start()
+#define MARQUEE_MAX_LENGTH	24
+
+// sprites which can be included in messages, e.g. 
+// "LEVEL 2 " SPRITE_DIAMOND
+#define MARQUEE_SPRITE(n)	((char)(0x01 + (n)))
+#define SPRITE_DIAMOND		"\x01"
+#define SPRITE_BOMB			"\x02"
+#define MARQUEE_NUM_SPRITES	2
+
+/* Start scrolling a message. The message is copied (and truncated to 
+ * MARQUEE_MAX_LENGTH characters). Letters (which are displayed in upper
+ * case), digits, spaces and the characters "!-:" are supported - anything
+ * else is shown as a space.
+ */
+void marquee_start(const char* message, PixelColour colour);
+
+/* As above, for a message stored in program memory. The message is not
+ * copied so may be of any length.
+ */
+void marquee_start_P(PGM_P message, PixelColour colour);
+
+/* Scroll the message along by one column. Returns 1 once the whole 
+ * message has scrolled off the left of the display, 0 otherwise.
+ */
+uint8_t marquee_step(void);
+
+#endif /* MARQUEE_H_ */
@@ -0,0 +1,96 @@
+/*
+ * memory.c
+ *
+ * Author: William Sawyer
+ *
+ * Stack painting and RAM usage reporting. Uses the symbols the avr-libc
+ * linker script defines for the boundaries of each section.
+ */
+
+#include <stdio.h>
+#include <avr/io.h>
+#include <avr/pgmspace.h>
+
+#include "memory.h"
+#include "terminalio.h"
+
+#define STACK_CANARY 0xC5
+
+extern uint8_t __data_start;
+extern uint8_t __data_end;
+extern uint8_t __bss_start;
+extern uint8_t __bss_end;
+extern uint8_t __heap_start;
+extern uint8_t _end;
+extern uint8_t __stack;
+extern void* __brkval;	// top of the heap, 0 if malloc has not been used
+
+/* Paint everything from the end of .bss up to the top of RAM with the
+ * canary. This runs in .init1, before the stack pointer is set up and 
+ * before r1 is cleared, so it is written in assembly and must not be 
+ * called.
+ */
+void memory_paint(void) __attribute__ ((naked, used, section(".init1")));
+
+void memory_paint(void) {
+	__asm volatile (
+		"	ldi r30, lo8(_end)\n"
+		"	ldi r31, hi8(_end)\n"
+		"	ldi r24, %0\n"
+		"	ldi r25, hi8(__stack)\n"
+		"	rjmp 2f\n"
+		"1:	st Z+, r24\n"
+		"2:	cpi r30, lo8(__stack)\n"
+		"	cpc r31, r25\n"
+		"	brlo 1b\n"
+		"	breq 1b\n"
+		:: "M" (STACK_CANARY)
+	);
+}
+
+// returns the lowest address the stack is free to grow into
+static uint8_t* heap_top(void) {
+	if (__brkval) {
+		return (uint8_t*)__brkval;
+	}
+	return &__heap_start;
+}
+
+// returns the first address (searching up from the heap) which has been
+// written over since being painted
+static uint8_t* lowest_used(void) {
+	uint8_t* p = heap_top();
+	while (p <= &__stack && *p == STACK_CANARY) {
+		p++;
+	}
+	return p;
+}
+
+uint16_t memory_data_size(void) {
+	return &__data_end - &__data_start;
+}
+
+uint16_t memory_bss_size(void) {
+	return &__bss_end - &__bss_start;
+}
+
+uint16_t memory_stack_high_water(void) {
+	return &__stack - lowest_used() + 1;
+}
+
+uint16_t memory_free_now(void) {
+	return (uint8_t*)SP - heap_top();
+}
+
+uint16_t memory_free_min(void) {
+	return lowest_used() - heap_top();
+}
+
+void memory_report(void) {
+	move_terminal_cursor(DEBUG_X, DEBUG_Y);
+	clear_to_end_of_screen();
+	printf_P(PSTR("RAM %u bytes: data %u, bss %u\n"), RAMEND - RAMSTART + 1,
+			memory_data_size(), memory_bss_size());
+	printf_P(PSTR("stack max %u, free now %u, free min %u\n"), 
+			memory_stack_high_water(), memory_free_now(), memory_free_min());
+}
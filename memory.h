@@ -0,0 +1,38 @@
+/*
+ * memory.h
+ *
+ * Author: William Sawyer
+ *
+ * RAM usage reporting. At startup (before main() runs) all RAM above
+ * the .data and .bss sections is painted with a canary value. The stack 
+ * grows down into this painted area, so the amount of paint left
+ * untouched shows how close the stack has ever come to the variables
+ * (and heap) below it.
+ */
+
+#ifndef MEMORY_H_
+#define MEMORY_H_
+
+#include <stdint.h>
+
+/* Return the size of the .data and .bss sections (initialised and zeroed
+ * global variables) in bytes.
+ */
+uint16_t memory_data_size(void);
+uint16_t memory_bss_size(void);
+
+/* Return the largest number of bytes the stack has ever used.
+ */
+uint16_t memory_stack_high_water(void);
+
+/* Return the number of bytes currently free between the top of the heap 
+ * and the stack, and the smallest that gap has ever been.
+ */
+uint16_t memory_free_now(void);
+uint16_t memory_free_min(void);
+
+/* Print the above to the terminal (below the game).
+ */
+void memory_report(void);
+
+#endif /* MEMORY_H_ */
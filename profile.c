@@ -0,0 +1,165 @@
+/*
+ * profile.c
+ *
+ * Author: William Sawyer
+ *
+ * Records cycle counts for the regions and busy waits marked with the
+ * macros in profile.h and prints them on request.
+ */
+
+#include <stdio.h>
+#include <avr/pgmspace.h>
+
+#include "profile.h"
+#include "terminalio.h"
+#include "timer0.h"
+
+#if PROFILE
+
+/* Totals are stored in units of 2^PROFILE_TOTAL_SHIFT cycles (32us at
+ * 8MHz) so that they take a long time to overflow (~38 hours). The cycle
+ * count itself wraps every ~9 minutes, which is fine for single entries
+ * and waits, but not for the time between dumps - that is measured in
+ * milliseconds with get_current_time() instead.
+ */
+#define PROFILE_TOTAL_SHIFT 8
+
+typedef struct {
+	uint32_t start;		// cycle count when the outermost entry happened
+	uint8_t depth;		// how many times the region has been entered
+	uint32_t count;
+	uint32_t total;		// in units of 2^PROFILE_TOTAL_SHIFT cycles
+	uint32_t max;
+	uint16_t buckets[PROFILE_NUM_BUCKETS];
+} ProfileRegion;
+
+typedef struct {
+	uint32_t count;
+	uint32_t total;		// in units of 2^PROFILE_TOTAL_SHIFT cycles
+} ProfileWait;
+
+static ProfileRegion regions[PROFILE_NUM_REGIONS];
+static ProfileWait waits[PROFILE_NUM_WAITS];
+static uint32_t profile_start;	// in milliseconds
+
+static const char loop_name[] PROGMEM = "loop    ";
+static const char move_name[] PROGMEM = "move    ";
+static const char dfs_name[] PROGMEM = "dfs     ";
+static const char square_name[] PROGMEM = "square  ";
+static const char printf_name[] PROGMEM = "printf  ";
+static const char level_name[] PROGMEM = "level   ";
+static PGM_P const region_names[PROFILE_NUM_REGIONS] PROGMEM = 
+		{loop_name, move_name, dfs_name, square_name, printf_name, level_name};
+
+static const char spi_name[] PROGMEM = "spi     ";
+static const char joystick_name[] PROGMEM = "joystick";
+static const char uart_name[] PROGMEM = "uart    ";
+static PGM_P const wait_names[PROFILE_NUM_WAITS] PROGMEM = 
+		{spi_name, joystick_name, uart_name};
+
+void profile_enter(uint8_t region) {
+	ProfileRegion* r = &regions[region];
+	if (r->depth++ == 0) {
+		r->start = get_cycle_count();
+	}
+}
+
+void profile_exit(uint8_t region) {
+	ProfileRegion* r = &regions[region];
+	if (--r->depth != 0) {
+		// still inside an outer entry of this region
+		return;
+	}
+	uint32_t cycles = get_cycle_count() - r->start;
+	
+	// find the power of two bucket this duration falls into
+	uint8_t bucket = 0;
+	uint32_t scaled = cycles >> (PROFILE_MIN_SHIFT + 1);
+	while (scaled && bucket < PROFILE_NUM_BUCKETS - 1) {
+		scaled >>= 1;
+		bucket++;
+	}
+	if (r->buckets[bucket] != UINT16_MAX) {
+		r->buckets[bucket]++;
+	}
+	
+	r->count++;
+	r->total += cycles >> PROFILE_TOTAL_SHIFT;
+	if (cycles > r->max) {
+		r->max = cycles;
+	}
+}
+
+void profile_wait(uint8_t wait, uint32_t start) {
+	waits[wait].count++;
+	waits[wait].total += (get_cycle_count() - start) >> PROFILE_TOTAL_SHIFT;
+}
+
+// returns the percentage of elapsed milliseconds which total makes up
+static uint8_t profile_share(uint32_t total, uint32_t elapsed) {
+	uint32_t share;
+	if (!elapsed) {
+		return 0;
+	}
+	// a unit of total is 32us, so the share is total * 3.2 / elapsed
+	if (total < (1UL << 28) && elapsed < (1UL << 29)) {
+		share = (total * 16) / (elapsed * 5);
+	} else {
+		share = ((total / elapsed) * 16) / 5;
+	}
+	// a region still open at the last dump can take a little more than
+	// its share
+	return share > 100 ? 100 : share;
+}
+
+void profile_dump(void) {
+	uint32_t elapsed = TIME_SINCE(get_current_time(), profile_start);
+	
+	move_terminal_cursor(DEBUG_X, DEBUG_Y);
+	clear_to_end_of_screen();
+	printf_P(PSTR("Profile over %lums\n"), elapsed);
+	
+	for (uint8_t i = 0; i < PROFILE_NUM_REGIONS; i++) {
+		ProfileRegion* r = &regions[i];
+		uint32_t mean = 0;
+		if (r->count && r->total < (1UL << (32 - PROFILE_TOTAL_SHIFT))) {
+			mean = (r->total << PROFILE_TOTAL_SHIFT) / r->count;
+		} else if (r->count) {
+			mean = (r->total / r->count) << PROFILE_TOTAL_SHIFT;
+		}
+		printf_P((PGM_P)pgm_read_word(&region_names[i]));
+		printf_P(PSTR(" n=%lu mean=%lu max=%lu %u%%\n "), r->count, mean,
+				r->max, profile_share(r->total, elapsed));
+		// only list the buckets which have something in them, as 
+		// log2(cycles):count
+		for (uint8_t b = 0; b < PROFILE_NUM_BUCKETS; b++) {
+			if (r->buckets[b]) {
+				printf_P(PSTR(" %u:%u"), b + PROFILE_MIN_SHIFT, r->buckets[b]);
+			}
+			r->buckets[b] = 0;
+		}
+		printf_P(PSTR("\n"));
+		r->count = 0;
+		r->total = 0;
+		r->max = 0;
+	}
+	
+	for (uint8_t i = 0; i < PROFILE_NUM_WAITS; i++) {
+		printf_P((PGM_P)pgm_read_word(&wait_names[i]));
+		printf_P(PSTR(" waits=%lu %u%%\n"), waits[i].count, 
+				profile_share(waits[i].total, elapsed));
+		waits[i].count = 0;
+		waits[i].total = 0;
+	}
+	
+	profile_start = get_current_time();
+}
+
+#else
+
+void profile_dump(void) {
+	move_terminal_cursor(DEBUG_X, DEBUG_Y);
+	printf_P(PSTR("Profiling not compiled in (PROFILE=0)"));
+}
+
+#endif /* PROFILE */
@@ -0,0 +1,86 @@
+/*
+ * profile.h
+ *
+ * Author: William Sawyer
+ *
+ * Lightweight cycle profiler built on timer1. Marked regions of code
+ * record a histogram of how many clock cycles they took (in power of
+ * two buckets), along with a count, running total and maximum. Busy
+ * waits on hardware record the total cycles spent spinning.
+ *
+ * Profiling is compiled in only when PROFILE is defined to 1 (e.g. by
+ * adding PROFILE=1 to the project's symbol definitions). Otherwise the 
+ * macros below expand to nothing and cost no time or RAM.
+ */
+
+#ifndef PROFILE_H_
+#define PROFILE_H_
+
+#include <stdint.h>
+
+#ifndef PROFILE
+#define PROFILE 0
+#endif
+
+// Profiled regions
+#define PROFILE_LOOP		0	// one iteration of the play_game loop
+#define PROFILE_MOVE		1	// move_player()
+#define PROFILE_DFS			2	// discoverable_dfs() (outermost call)
+#define PROFILE_SQUARE		3	// update_square_colour()
+#define PROFILE_PRINTF		4	// printf_P() calls to the terminal
+#define PROFILE_LEVEL		5	// a step of moving on to the next level
+#define PROFILE_NUM_REGIONS	6
+
+// Busy waits
+#define PROFILE_WAIT_SPI		0	// spi_send_byte() waiting for the transfer
+#define PROFILE_WAIT_JOYSTICK	1	// read_joystick() waiting for the ADC
+#define PROFILE_WAIT_UART		2	// uart_put_char() waiting for buffer space
+#define PROFILE_NUM_WAITS		3
+
+// Histogram bucket i counts durations of 2^(i+4) to 2^(i+5)-1 cycles.
+// The first bucket also counts anything shorter and the last bucket
+// anything longer.
+#define PROFILE_NUM_BUCKETS	16
+#define PROFILE_MIN_SHIFT	4
+
+#if PROFILE
+
+#include "timer1.h"
+
+/* Mark the start and end of a region. Regions may nest within
+ * themselves (e.g. through recursion) - only the outermost entry
+ * and exit are timed.
+ */
+#define PROFILE_ENTER(region)	profile_enter(region)
+#define PROFILE_EXIT(region)	profile_exit(region)
+
+/* Wrap a single statement (e.g. a printf_P call) in a region */
+#define PROFILE_CALL(region, statement) \
+	do { profile_enter(region); statement; profile_exit(region); } while (0)
+
+/* Time a busy wait. PROFILE_WAIT_START declares a local variable, so
+ * must appear in the same block as the matching PROFILE_WAIT_END.
+ */
+#define PROFILE_WAIT_START()	uint32_t profile_wait_start = get_cycle_count()
+#define PROFILE_WAIT_END(wait)	profile_wait(wait, profile_wait_start)
+
+void profile_enter(uint8_t region);
+void profile_exit(uint8_t region);
+void profile_wait(uint8_t wait, uint32_t start);
+
+#else
+
+#define PROFILE_ENTER(region)
+#define PROFILE_EXIT(region)
+#define PROFILE_CALL(region, statement) statement
+#define PROFILE_WAIT_START()
+#define PROFILE_WAIT_END(wait)
+
+#endif /* PROFILE */
+
+/* Print the recorded histograms to the terminal (below the game) and
+ * start recording afresh.
+ */
+void profile_dump(void);
+
+#endif /* PROFILE_H_ */
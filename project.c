@@ -1,295 +1,493 @@
-/*
- * project.c
- *
- * Main file for IN students
- *
- * Authors: Peter Sutton, Luke Kamols
- * Diamond Miners Inspiration: Daniel Cumming
- * Modified by William Sawyer
- */ 
-
-#include <avr/io.h>
-#include <avr/interrupt.h>
-#include <avr/pgmspace.h>
-#include <stdio.h>
-
-#include "game.h"
-#include "display.h"
-#include "ledmatrix.h"
-#include "buttons.h"
-#include "serialio.h"
-#include "terminalio.h"
-#include "timer0.h"
-#include "joystick.h"
-
-#define JOYSTICK_LOWER_BOUND	-200
-#define JOYSTICK_UPPER_BOUND	200
-
-void initialise_hardware(void);
-void start_screen(void);
-void new_game(void);
-void play_game(void);
-void handle_game_over(void);
-
-int main(void) {
-	// Setup hardware and call backs. This will turn on 
-	// interrupts.
-	initialise_hardware();
-	
-	// Show the splash screen message. Returns when display is complete
-	start_screen();
-	
-	// display(); // debugging joystick
-	
-	// Loop forever,
-	while(1) {
-		new_game();
-		play_game();
-		handle_game_over();
-	}
-}
-
-void initialise_hardware(void) {
-	ledmatrix_setup();
-	init_button_interrupts();
-	// Setup serial port for 19200 baud communication with no echo
-	// of incoming characters
-	init_serial_stdio(19200,0);
-	
-	init_timer0();
-	
-	init_adc();
-	
-	// Turn on global interrupts
-	sei();
-}
-
-void start_screen(void) {
-	// Clear terminal screen and output a message
-	clear_terminal();
-	move_terminal_cursor(10,10);
-	printf_P(PSTR("Diamond Miners"));
-	move_terminal_cursor(10,12);
-	printf_P(PSTR("CSSE2010 project by William Sawyer - 46963608"));
-	
-	// Output the static start screen and wait for a push button 
-	// to be pushed or a serial input of 's'
-	start_display();
-	
-	// Wait until a button is pressed, or 's' is pressed on the terminal
-	while(1) {
-		// First check for if a 's' is pressed
-		// There are two steps to this
-		// 1) collect any serial input (if available)
-		// 2) check if the input is equal to the character 's'
-		char serial_input = -1;
-		if (serial_input_available()) {
-			serial_input = fgetc(stdin);
-		}
-		// If the serial input is 's', then exit the start screen
-		if (serial_input == 's' || serial_input == 'S') {
-			break;
-		}
-		// Next check for any button presses
-		int8_t btn = button_pushed();
-		if (btn != NO_BUTTON_PUSHED) {
-			break;
-		}
-	}
-}
-
-void new_game(void) {
-	// Clear the serial terminal
-	clear_terminal();
-	
-	// Initialise the game and display
-	initialise_game(0, 0);
-	
-	// Clear a button push or serial input if any are waiting
-	// (The cast to void means the return value is ignored.)
-	(void) button_pushed();
-	clear_serial_input_buffer();
-}
-
-void play_game(void) {
-	uint32_t last_cursor_flash_time, last_detector_flash_time, last_bomb_flash_time, last_joystick_read_time, current_time;
-	uint32_t bomb_planted_time = 0;
-	uint32_t bomb_detonated_time = 0;
-    uint32_t manhattan_time = 0;
-	uint32_t pause_time = 0;
-	uint32_t bomb_delay;
-	int16_t joystick_x = 0;
-	int16_t joystick_y = 0;
-	uint8_t step_counter = 0;
-	uint8_t paused = 0;
-	uint8_t btn; //the button pushed
-	uint8_t first_successful;
-    char serial_input = -1;
-	
-	last_cursor_flash_time = get_current_time();
-    last_detector_flash_time = get_current_time();
-	last_joystick_read_time = get_current_time();
-	
-	// We play the game until it's over
-	while (!is_game_over()) {
-		while (!paused && !is_game_over()) {
-			// We need to check if any button has been pushed, this will be
-			// NO_BUTTON_PUSHED if no button has been pushed
-			btn = button_pushed();
-	
-			if (serial_input_available()) {
-				serial_input = fgetc(stdin);
-	        }
-
-			// check diagonal movement first
-			if (joystick_x > JOYSTICK_UPPER_BOUND && joystick_y > JOYSTICK_UPPER_BOUND) { // up and right
-				// first_successful allows us to try up and then right as well as right and then up
-				first_successful = move_player(0, 1);
-				step_counter += first_successful;
-				step_counter += move_player(1, 0);
-				if (!first_successful) {
-					step_counter += move_player(0, 1);
-				}
-			} else if (joystick_x < JOYSTICK_LOWER_BOUND && joystick_y > JOYSTICK_UPPER_BOUND) { // up and left
-				first_successful = move_player(0, 1);
-				step_counter += first_successful;
-				step_counter += move_player(-1, 0);
-				if (!first_successful) {
-					step_counter += move_player(0, 1);
-				}
-			} else if (joystick_x < JOYSTICK_LOWER_BOUND && joystick_y < JOYSTICK_LOWER_BOUND) { // down and left
-				first_successful = move_player(0, -1);
-				step_counter += first_successful;
-				step_counter += move_player(-1, 0);
-				if (!first_successful) {
-					step_counter += move_player(0, -1);
-				}
-			} else if (joystick_x > JOYSTICK_UPPER_BOUND && joystick_y < JOYSTICK_LOWER_BOUND) { // down and right
-				first_successful = move_player(0, -1);
-				step_counter += first_successful;
-				step_counter += move_player(1, 0);
-				if (!first_successful) {
-					step_counter += move_player(0, -1);
-				}
-			} else if (btn == BUTTON0_PUSHED || joystick_x > JOYSTICK_UPPER_BOUND
-					|| serial_input == 'd' || serial_input == 'D') { // move right
-				step_counter += move_player(1, 0);
-			} else if (btn == BUTTON1_PUSHED || joystick_y < JOYSTICK_LOWER_BOUND
-					|| serial_input == 's' || serial_input == 'S') { // move down
-	            step_counter += move_player(0, -1);
-			} else if (btn == BUTTON2_PUSHED || joystick_y > JOYSTICK_UPPER_BOUND
-					|| serial_input == 'w' || serial_input == 'W') { // move up
-	            step_counter += move_player(0, 1);
-			} else if (btn == BUTTON3_PUSHED || joystick_x < JOYSTICK_LOWER_BOUND
-					|| serial_input == 'a' || serial_input == 'A') { // move left
-	            step_counter += move_player(-1, 0);
-			} else if (serial_input == 'e'|| serial_input == 'E') {
-	            inspect_facing();
-			} else if (serial_input == 'c' || serial_input == 'C') {
-	            toggle_cheat();
-			} else if (serial_input == ' ') {
-				if (plant_bomb()) {
-					bomb_planted_time = get_current_time();
-					bomb_delay = 350;
-					last_bomb_flash_time = 0;
-				}
-			} else if (serial_input == 'p' || serial_input == 'P') {
-				pause_time = pause_game();
-				paused = 1;
-			}
-			
-			serial_input = -1;
-	
-			current_time = get_current_time();
-	
-			if (current_time >= last_cursor_flash_time + 500) {
-				// 500ms (0.5 second) has passed since the last time we
-				// flashed the cursor, so flash the cursor
-				flash_facing();
-				
-				// Update the most recent time the cursor was flashed
-				last_cursor_flash_time = current_time;
-			}
-			
-			manhattan_time = detect_diamond();
-	
-			if (manhattan_time == 0) {
-				clear_detector();
-			} else if (current_time >= last_detector_flash_time + manhattan_time) {
-				flash_detector();
-	
-				// update the most recent time the detector was flashed
-	            last_detector_flash_time = current_time;
-			}
-
-			if (bomb_planted_time) {
-				danger_light(in_danger());
-				if (current_time >= bomb_planted_time + BOMB_FUSE_TIME) {
-					detonate_bomb();
-					bomb_detonated_time = get_current_time();
-					bomb_planted_time = 0;
-					last_bomb_flash_time = 0;
-				}
-				if (!last_bomb_flash_time || current_time >= last_bomb_flash_time + bomb_delay) {
-					if (flash_bomb()) {
-						bomb_delay -= 75;
-					}
-					last_bomb_flash_time = get_current_time();
-				}
-			}
-
-			if (bomb_detonated_time && current_time >= bomb_detonated_time + EXPLOSION_DELAY) {
-				clear_explosion();
-				bomb_detonated_time = 0;
-			}
-
-			joystick_x = 0;
-			joystick_y = 0;
-			
-			if (current_time >= last_joystick_read_time + 200) {
-				// 200ms has passed since we last read the joystick, so read it again
-				joystick_x = read_joystick(1); // read joystick L/R at Pin A1
-				joystick_y = read_joystick(0); // read joystick U/D at Pin A0
-				last_joystick_read_time = get_current_time();
-			}
-	
-			if (step_counter < 100) {
-				seven_seg(step_counter);
-			} else {
-				seven_seg(99);
-			}
-		}
-		
-		while (paused && !is_game_over()) {
-			if (serial_input_available()) {
-				serial_input = fgetc(stdin);
-			}
-			if (serial_input == 'p' || serial_input == 'P') {
-				unpause_game(pause_time);
-				paused = 0;
-			}
-			serial_input = -1;
-		}
-	}
-	// We get here if the game is over.
-}
-
-void handle_game_over() {
-	uint32_t current_time;
-	uint32_t last_game_over_time = 0;
-	
-	move_terminal_cursor(10,14);
-	printf_P(PSTR("GAME OVER"));
-	move_terminal_cursor(10,15);
-	printf_P(PSTR("Press a button to start again"));
-	
-	while (button_pushed() == NO_BUTTON_PUSHED) {
-		current_time = get_current_time();
-		
-		if (current_time >= last_game_over_time + GAME_OVER_DELAY) {
-			show_game_over();
-			last_game_over_time = get_current_time();
-		}
-		
-	}
-}
+/*
+ * project.c
+ *
+ * Main file for IN students
+ *
+ * Authors: Peter Sutton, Luke Kamols
+ * Diamond Miners Inspiration: Daniel Cumming
+ * Modified by William Sawyer
+ */ 
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/pgmspace.h>
+#include <stdio.h>
+
+#include "game.h"
+#include "display.h"
+#include "ledmatrix.h"
+#include "buttons.h"
+#include "serialio.h"
+#include "terminalio.h"
+#include "timer0.h"
+#include "timer1.h"
+#include "gameclock.h"
+#include "joystick.h"
+#include "profile.h"
+#include "latency.h"
+#include "memory.h"
+#include "marquee.h"
+#include "spectator.h"
+#include "highscore.h"
+#include "save.h"
+#include "render.h"
+#include "trace.h"
+#include "snapshot.h"
+#include "autoplay.h"
+
+#define JOYSTICK_LOWER_BOUND	-200
+#define JOYSTICK_UPPER_BOUND	200
+
+// how long the start screen logo is shown before the message scrolls in
+#define SPLASH_DELAY	1000
+
+// how often the joystick is read, in coarse ticks (200ms)
+#define JOYSTICK_READ_TICKS	(200 / COARSE_TICK_MS)
+
+// the most serial keys acted on in one pass of the game loop in batch
+// input mode, so that the display keeps up with a script
+#define BATCH_INPUT_KEYS	32
+
+void initialise_hardware(void);
+uint8_t start_screen(void);
+uint8_t resume_game(void);
+void new_game(void);
+void play_game(void);
+void handle_game_over(void);
+static uint8_t handle_serial_input(char serial_input, uint8_t* paused);
+static void show_input_status(void);
+
+// whether every key waiting is acted on each pass of the game loop,
+// rather than one, and the serial characters lost this game
+static uint8_t batch_input;
+static uint16_t input_lost;
+
+int main(void) {
+	// Setup hardware and call backs. This will turn on 
+	// interrupts.
+	initialise_hardware();
+	
+	// Show the splash screen message. Returns when display is complete,
+	// and whether the saved game should be resumed
+	uint8_t resume = start_screen();
+	
+	// display(); // debugging joystick
+	
+	// Loop forever,
+	while(1) {
+		if (!resume || !resume_game()) {
+			new_game();
+		}
+		resume = 0;
+		play_game();
+		handle_game_over();
+	}
+}
+
+void initialise_hardware(void) {
+	ledmatrix_setup();
+	init_button_interrupts();
+	// Setup serial port for 19200 baud communication with no echo
+	// of incoming characters
+	init_serial_stdio(19200,0);
+	
+	init_timer0();
+	init_timer1();
+	init_spectator();
+	init_trace();
+	
+	init_adc();
+	
+	init_highscores();
+	init_save();
+	
+	// Turn on global interrupts
+	sei();
+}
+
+uint8_t start_screen(void) {
+	// Clear terminal screen and output a message
+	clear_terminal();
+	move_terminal_cursor(10,10);
+	printf_P(PSTR("Diamond Miners"));
+	move_terminal_cursor(10,12);
+	printf_P(PSTR("CSSE2010 project by William Sawyer - 46963608"));
+	if (save_available()) {
+		move_terminal_cursor(10,14);
+		printf_P(PSTR("Press r to resume the saved game"));
+	}
+	if (trace_after_reset()) {
+		// show what led up to the reset
+		trace_dump();
+	}
+	
+	// Output the static start screen and wait for a push button 
+	// to be pushed or a serial input of 's'
+	start_display();
+	
+	// after the splash delay, scroll the name of the game across the
+	// display (and repeat this until the game starts)
+	uint32_t current_time;
+	uint32_t next_marquee_time = get_current_time() + SPLASH_DELAY;
+	marquee_start_P(PSTR(SPRITE_DIAMOND " DIAMOND MINERS " SPRITE_DIAMOND), 
+			COLOUR_GREEN);
+	
+	// Wait until a button is pressed, or 's' is pressed on the terminal
+	while(1) {
+		// First check for if a 's' is pressed
+		// There are two steps to this
+		// 1) collect any serial input (if available)
+		// 2) check if the input is equal to the character 's'
+		char serial_input = -1;
+		if (serial_input_available()) {
+			serial_input = fgetc(stdin);
+		}
+		// If the serial input is 's', then exit the start screen
+		if (serial_input == 's' || serial_input == 'S') {
+			return 0;
+		}
+		if ((serial_input == 'r' || serial_input == 'R') && save_available()) {
+			return 1;
+		}
+		// Next check for any button presses
+		int8_t btn = button_pushed();
+		if (btn != NO_BUTTON_PUSHED) {
+			return 0;
+		}
+		
+		current_time = get_current_time();
+		if (TIME_REACHED(current_time, next_marquee_time)) {
+			if (marquee_step()) {
+				marquee_start_P(PSTR(SPRITE_DIAMOND " DIAMOND MINERS " 
+						SPRITE_DIAMOND), COLOUR_GREEN);
+			}
+			next_marquee_time = current_time + MARQUEE_STEP_DELAY;
+		}
+	}
+}
+
+// returns 0 if the saved game couldn't be resumed
+uint8_t resume_game(void) {
+	// the saved game's bombs carry on from game time 0
+	game_clock_start();
+	if (!save_resume()) {
+		return 0;
+	}
+	
+	(void) button_pushed();
+	clear_serial_input_buffer();
+	latency_discard();
+	return 1;
+}
+
+void new_game(void) {
+	// Clear the serial terminal
+	clear_terminal();
+	
+	// Initialise the game and display, game time starts from 0
+	game_clock_start();
+	initialise_game(0, 0);
+	save_start();
+	
+	// Clear a button push or serial input if any are waiting
+	// (The cast to void means the return value is ignored.)
+	(void) button_pushed();
+	clear_serial_input_buffer();
+	latency_discard();
+}
+
+void play_game(void) {
+	uint32_t last_detector_flash_time, current_time;
+	uint8_t last_joystick_read_time;
+    uint32_t manhattan_time = 0;
+	int16_t joystick_x = 0;
+	int16_t joystick_y = 0;
+	uint16_t step_counter = 0;
+	uint8_t level = get_level();
+	uint16_t level_start_steps = 0; // step_counter when the level started
+	uint8_t paused = 0;
+	int8_t btn; //the button pushed
+	uint8_t lost;
+    char serial_input = -1;
+	
+	// the game is timed by the game clock, inputs by the system clock
+    last_detector_flash_time = get_game_time();
+	last_joystick_read_time = get_coarse_time();
+	input_lost = 0;
+	show_input_status();
+	autoplay_reset();
+	
+	// We play the game until it's over
+	while (!is_game_over()) {
+		while (!paused && !is_game_over()) {
+			PROFILE_ENTER(PROFILE_LOOP);
+			TRACE_TIME_START();
+			
+			// We need to check if any button has been pushed, this will be
+			// NO_BUTTON_PUSHED if no button has been pushed
+			btn = button_pushed();
+	
+			// in batch input mode keys wait while the level changes, 
+			// rather than being thrown away
+			if (serial_input_available() 
+					&& !(batch_input && changing_level())) {
+				serial_input = fgetc(stdin);
+	        }
+
+			// check diagonal movement first, up or down then across is
+			// tried as well as across then up or down
+			if (joystick_x > JOYSTICK_UPPER_BOUND && joystick_y > JOYSTICK_UPPER_BOUND) { // up and right
+				step_counter += move_player_path(1, 1);
+			} else if (joystick_x < JOYSTICK_LOWER_BOUND && joystick_y > JOYSTICK_UPPER_BOUND) { // up and left
+				step_counter += move_player_path(-1, 1);
+			} else if (joystick_x < JOYSTICK_LOWER_BOUND && joystick_y < JOYSTICK_LOWER_BOUND) { // down and left
+				step_counter += move_player_path(-1, -1);
+			} else if (joystick_x > JOYSTICK_UPPER_BOUND && joystick_y < JOYSTICK_LOWER_BOUND) { // down and right
+				step_counter += move_player_path(1, -1);
+			} else if (btn == BUTTON0_PUSHED || joystick_x > JOYSTICK_UPPER_BOUND) { // move right
+				step_counter += move_player(1, 0);
+			} else if (btn == BUTTON1_PUSHED || joystick_y < JOYSTICK_LOWER_BOUND) { // move down
+	            step_counter += move_player(0, -1);
+			} else if (btn == BUTTON2_PUSHED || joystick_y > JOYSTICK_UPPER_BOUND) { // move up
+	            step_counter += move_player(0, 1);
+			} else if (btn == BUTTON3_PUSHED || joystick_x < JOYSTICK_LOWER_BOUND) { // move left
+	            step_counter += move_player(-1, 0);
+			}
+			if (serial_input != -1) {
+				step_counter += handle_serial_input(serial_input, &paused);
+			}
+			// in batch input mode the rest of the keys waiting are acted
+			// on too, until the game is paused or the level is finished
+			for (uint8_t keys = 1; batch_input && keys < BATCH_INPUT_KEYS 
+					&& serial_input_available() && !paused && !is_game_over() 
+					&& !changing_level(); keys++) {
+				step_counter += handle_serial_input(fgetc(stdin), &paused);
+			}
+			
+			// the rest of the pass shares one reading of the game clock
+			current_time = get_game_time();
+			step_counter += autoplay_update(current_time);
+			
+			lost = serial_input_lost();
+			if (lost) {
+				TRACE_EVENT(TRACE_INPUT_LOST, lost);
+				input_lost += lost;
+				show_input_status();
+			}
+			
+			if (get_level() != level) {
+				// the last move finished the level
+				highscore_level_finished(level, step_counter - level_start_steps);
+				level = get_level();
+				level_start_steps = step_counter;
+				// the terminal was cleared for the new level
+				show_input_status();
+			}
+			highscore_update();
+			save_update();
+			
+			// flash the cursor and update the bombs
+			update_game(current_time);
+			
+			// show everything that changed on this pass
+			render_flush();
+			
+			if (btn != NO_BUTTON_PUSHED || serial_input != -1) {
+				// any display update for this input has now been sent
+				latency_input_handled(bombs_in_play() || serial_output_pending());
+			}
+			
+			serial_input = -1;
+			
+			manhattan_time = detect_diamond();
+	
+			if (manhattan_time == 0) {
+				clear_detector();
+			} else if (TIME_SINCE(current_time, last_detector_flash_time) 
+					>= manhattan_time) {
+				flash_detector();
+	
+				// update the most recent time the detector was flashed
+	            last_detector_flash_time = current_time;
+			}
+
+			danger_light(in_danger());
+			spectator_update();
+
+			joystick_x = 0;
+			joystick_y = 0;
+			
+			if (TIME_SINCE_COARSE(get_coarse_time(), last_joystick_read_time) 
+					>= JOYSTICK_READ_TICKS) {
+				// 200ms has passed since we last read the joystick, so read it again
+				joystick_x = read_joystick(1); // read joystick L/R at Pin A1
+				joystick_y = read_joystick(0); // read joystick U/D at Pin A0
+				last_joystick_read_time = get_coarse_time();
+			}
+	
+			if (step_counter < 100) {
+				seven_seg(step_counter);
+			} else {
+				seven_seg(99);
+			}
+			
+			PROFILE_EXIT(PROFILE_LOOP);
+			TRACE_LONG_LOOP_END();
+		}
+		
+		while (paused && !is_game_over()) {
+			if (serial_input_available()) {
+				serial_input = fgetc(stdin);
+			}
+			if (serial_input == 'p' || serial_input == 'P') {
+				unpause_game();
+				paused = 0;
+				latency_discard();
+				// the coarse tick wraps every 2 seconds, so a longer pause
+				// could leave the joystick unread for most of a wrap, read
+				// it on the next pass instead
+				last_joystick_read_time = get_coarse_time()
+						- JOYSTICK_READ_TICKS;
+			}
+			serial_input = -1;
+		}
+	}
+	// We get here if the game is over.
+}
+
+// acts on a key from the serial terminal, returns the number of squares
+// the player moved
+static uint8_t handle_serial_input(char serial_input, uint8_t* paused) {
+	switch (serial_input) {
+		case 'd':
+		case 'D':
+			return move_player(1, 0);
+		case 's':
+		case 'S':
+			return move_player(0, -1);
+		case 'w':
+		case 'W':
+			return move_player(0, 1);
+		case 'a':
+		case 'A':
+			return move_player(-1, 0);
+		case 'e':
+		case 'E':
+			inspect_facing();
+			break;
+		case 'c':
+		case 'C':
+			toggle_cheat();
+			break;
+		case ' ':
+			plant_bomb(get_game_time());
+			break;
+		case 'p':
+		case 'P':
+			pause_game();
+			*paused = 1;
+			break;
+		case '+':
+		case '=':
+			change_game_speed(1);
+			break;
+		case '-':
+		case '_':
+			change_game_speed(0);
+			break;
+		case 'b':
+		case 'B':
+			batch_input = !batch_input;
+			show_input_status();
+			break;
+		case 'h':
+		case 'H':
+			profile_dump();
+			break;
+		case 'l':
+		case 'L':
+			latency_report();
+			break;
+		case 'm':
+		case 'M':
+			memory_report();
+			break;
+		case 't':
+		case 'T':
+			trace_dump();
+			break;
+		case 'q':
+		case 'Q':
+			snapshot_send();
+			break;
+		case 'o':
+		case 'O':
+			(void) autoplay_toggle();
+			show_input_status();
+			break;
+#if GAME_CLOCK_MANUAL
+		case '.':
+			// game time only moves on when the lockstep harness says so
+			game_clock_advance(1);
+			break;
+#endif
+	}
+	return 0;
+}
+
+static void show_input_status(void) {
+	update_input_status(batch_input, autoplay_active(), input_lost);
+}
+
+void handle_game_over() {
+	uint32_t current_time;
+	uint32_t next_step_time = get_current_time();
+	uint8_t screens_shown = 0;
+	char score_message[MARQUEE_MAX_LENGTH + 1];
+	
+	// there is nothing left to resume
+	save_discard();
+	
+	move_terminal_cursor(10,14);
+	printf_P(PSTR("GAME OVER"));
+	move_terminal_cursor(10,15);
+	printf_P(PSTR("Press a button to start again"));
+	
+	// the table is written to the EEPROM in the background while the game
+	// over screens are shown
+	highscore_show(highscore_game_over(get_total_score()));
+	
+	snprintf_P(score_message, sizeof(score_message), PSTR("SCORE %u " 
+			SPRITE_DIAMOND), get_total_score());
+	
+	// alternate between showing "GAME" and "OVER", then scroll the 
+	// score across the display and repeat
+	while (button_pushed() == NO_BUTTON_PUSHED) {
+		highscore_update();
+		current_time = get_current_time();
+		if (!TIME_REACHED(current_time, next_step_time)) {
+			continue;
+		}
+		
+		if (screens_shown < 2) {
+			show_game_over();
+			next_step_time = get_current_time() + GAME_OVER_DELAY;
+			if (++screens_shown == 2) {
+				// leave "OVER" up for the usual delay before the score 
+				// starts to push it off the display
+				marquee_start(score_message, COLOUR_ORANGE);
+				next_step_time += MARQUEE_STEP_DELAY;
+			}
+		} else {
+			if (marquee_step()) {
+				if (autoplay_active()) {
+					// the bot plays on, for soak testing
+					break;
+				}
+				screens_shown = 0;
+			}
+			next_step_time = current_time + (screens_shown 
+					? MARQUEE_STEP_DELAY : GAME_OVER_DELAY);
+		}
+	}
+}
@@ -0,0 +1,126 @@
+/*
+ * render.c
+ *
+ * Author: William Sawyer
+ */
+
+#include <stdint.h>
+
+#include "render.h"
+#include "display.h"
+#include "terminalio.h"
+#include "spectator.h"
+
+typedef struct {
+	uint8_t type;
+	uint8_t a, b, c;
+} RenderCommand;
+
+static RenderCommand list[RENDER_LIST_LENGTH];
+static uint8_t list_length;
+static uint8_t headless;
+// a redraw is waiting to be sent, with where the display will be
+static uint8_t redraw_pending;
+static uint8_t redraw_x, redraw_y;
+
+void render_add(uint8_t type, uint8_t a, uint8_t b, uint8_t c) {
+	if (headless) {
+		return;
+	}
+	if (list_length == RENDER_LIST_LENGTH) {
+		// rather than losing commands, send them early
+		render_flush();
+	}
+	RenderCommand* command = &list[list_length++];
+	command->type = type;
+	command->a = a;
+	command->b = b;
+	command->c = c;
+}
+
+void render_square(uint8_t x, uint8_t y, uint8_t object) {
+	if (!redraw_pending) {
+		render_add(RENDER_SQUARE, x, y, object);
+	}
+}
+
+void render_scroll(int8_t dx, int8_t dy) {
+	if (redraw_pending) {
+		redraw_x += dx;
+		redraw_y += dy;
+	} else {
+		render_add(RENDER_SCROLL, dx, dy, 0);
+	}
+}
+
+void render_redraw(uint8_t x, uint8_t y) {
+	if (headless) {
+		return;
+	}
+	// drop the display commands, the redraw covers them
+	uint8_t kept = 0;
+	for (uint8_t i = 0; i < list_length; i++) {
+		if (list[i].type != RENDER_SQUARE && list[i].type != RENDER_SCROLL) {
+			list[kept++] = list[i];
+		}
+	}
+	list_length = kept;
+	redraw_pending = 1;
+	redraw_x = x;
+	redraw_y = y;
+}
+
+void render_score(uint8_t score, uint8_t diamonds_available) {
+	render_add(RENDER_SCORE, score, diamonds_available, 0);
+}
+
+void render_cheat(uint8_t cheating) {
+	render_add(RENDER_CHEAT, cheating, 0, 0);
+}
+
+void render_flush(void) {
+	if (redraw_pending) {
+		// no display commands were kept after the redraw was asked for,
+		// so it can go first
+		redraw_pending = 0;
+		set_camera(redraw_x, redraw_y);
+		redraw_display();
+	}
+	for (uint8_t i = 0; i < list_length; i++) {
+		RenderCommand* command = &list[i];
+		switch (command->type) {
+			case RENDER_SQUARE:
+				update_square_colour(command->a, command->b, command->c);
+				break;
+			case RENDER_SCROLL:
+				scroll_camera((int8_t)command->a, (int8_t)command->b);
+				break;
+			case RENDER_SCORE:
+				update_score(command->a);
+				spectator_score(command->a, command->b);
+				break;
+			case RENDER_CHEAT:
+				update_cheat(command->a);
+				break;
+			case RENDER_FIELD:
+				spectator_square(command->a, command->b, command->c);
+				break;
+			case RENDER_PLAYER:
+				spectator_player(command->a, command->b);
+				break;
+			case RENDER_GAME_OVER:
+				spectator_game_over();
+				break;
+			case RENDER_RESYNC:
+				spectator_resync();
+				break;
+		}
+	}
+	list_length = 0;
+}
+
+void render_set_headless(uint8_t on) {
+	headless = on;
+	list_length = 0;
+	redraw_pending = 0;
+}
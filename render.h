@@ -0,0 +1,86 @@
+/*
+ * render.h
+ *
+ * Author: William Sawyer
+ *
+ * The game doesn't draw anything itself. As it changes, it adds compact
+ * commands to a render list, and once per pass of the game loop
+ * render_flush() hands them to the outputs: the LED matrix (display.c),
+ * the terminal (terminalio.c) and the spectator feed (spectator.h).
+ * In headless mode commands are thrown away as they are added, so the
+ * game runs at the speed of its logic alone.
+ *
+ * A redraw of the whole display replaces any square and scroll commands
+ * still in the list, and squares changed before it is sent are picked
+ * up by the redraw rather than added, so setting up a level costs one
+ * matrix update however much of it is revealed.
+ */
+
+#ifndef RENDER_H_
+#define RENDER_H_
+
+#include <stdint.h>
+
+#include "spectator.h"
+
+// the most commands held before they are flushed early
+#define RENDER_LIST_LENGTH	16
+
+// Render commands, followed by what their three bytes hold
+#define RENDER_SQUARE		0	// x, y, object to show on the display
+#define RENDER_SCROLL		1	// dx, dy to move the display by
+#define RENDER_SCORE		2	// score, diamonds available
+#define RENDER_CHEAT		3	// whether cheat mode is on
+#define RENDER_FIELD		4	// x, y, object now on the playing field
+#define RENDER_PLAYER		5	// x, y of the player
+#define RENDER_GAME_OVER	6
+#define RENDER_RESYNC		7	// send the spectators everything again
+
+/* Add a command to the list, flushing it first if it is full.
+ */
+void render_add(uint8_t type, uint8_t a, uint8_t b, uint8_t c);
+
+/* Show 'object' at square (x,y) of the playing field on the display.
+ */
+void render_square(uint8_t x, uint8_t y, uint8_t object);
+
+/* Move the display by (dx, dy) squares, each -1, 0 or 1 (see
+ * scroll_camera()).
+ */
+void render_scroll(int8_t dx, int8_t dy);
+
+/* Move the display so its bottom left corner shows square (x,y) and
+ * redraw all of it (see redraw_display()).
+ */
+void render_redraw(uint8_t x, uint8_t y);
+
+/* Show the score and cheat mode on the terminal.
+ */
+void render_score(uint8_t score, uint8_t diamonds_available);
+void render_cheat(uint8_t cheating);
+
+/* Report changes to the spectators, these are only kept if the
+ * spectator feed is compiled in.
+ */
+#if SPECTATOR
+#define render_field(x, y, object)	render_add(RENDER_FIELD, x, y, object)
+#define render_player(x, y)			render_add(RENDER_PLAYER, x, y, 0)
+#define render_game_over()			render_add(RENDER_GAME_OVER, 0, 0, 0)
+#define render_resync()				render_add(RENDER_RESYNC, 0, 0, 0)
+#else
+#define render_field(x, y, object)
+#define render_player(x, y)
+#define render_game_over()
+#define render_resync()
+#endif
+
+/* Send every command in the list to its output, in the order they were
+ * added, and empty the list.
+ */
+void render_flush(void);
+
+/* Throw away commands (1) or keep them (0, the default).
+ */
+void render_set_headless(uint8_t headless);
+
+#endif /* RENDER_H_ */
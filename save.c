@@ -0,0 +1,207 @@
+/*
+ * save.c
+ *
+ * Author: William Sawyer
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "save.h"
+#include "game.h"
+#include "storage.h"
+#include "timer0.h"
+
+// the header's valid byte once the copy is complete
+#define SAVE_VALID		0x5A
+
+// added into the checksum so that an erased (all 0xFF) header is never
+// valid
+#define CHECKSUM_SEED	0xA5
+
+// what save_update() does next
+#define SAVE_IDLE		0	// waiting for the next copy to be due
+#define SAVE_BLOCKS		1	// writing dirty blocks of the playing field
+#define SAVE_HEADER		2	// writing the header once no blocks are dirty
+
+typedef struct {
+	uint8_t valid;
+	SavedGame game;
+	uint16_t image_checksum;	// of the whole playing field
+	uint8_t checksum;			// of the header
+} SaveHeader;
+
+// the header as it is in the EEPROM, or is being written to it
+static SaveHeader header;
+// a bit for each block of the playing field changed since it was written
+static uint8_t dirty[(SAVE_NUM_BLOCKS + 7) / 8];
+// a copy of the block being written, so the game can change it meanwhile
+static uint8_t block[SAVE_BLOCK_SIZE];
+static uint8_t saving;	// a game is being kept
+static uint8_t state;
+static uint32_t last_save_time;
+
+static uint8_t header_checksum(const SaveHeader* saved) {
+	const uint8_t* bytes = (const uint8_t*)saved;
+	uint8_t sum = CHECKSUM_SEED;
+	for (uint8_t i = 0; i < offsetof(SaveHeader, checksum); i++) {
+		sum += bytes[i];
+	}
+	return sum;
+}
+
+// returns where the byte at 'offset' in the playing field is kept, blocks
+// never straddle the terrain and visibility
+static uint8_t* image_address(uint16_t offset) {
+	if (offset < SAVE_VISIBLE_OFFSET) {
+		return get_terrain_data() + offset - SAVE_TERRAIN_OFFSET;
+	}
+	return get_visible_data() + offset - SAVE_VISIBLE_OFFSET;
+}
+
+static uint16_t image_checksum(void) {
+	const uint8_t* bytes = get_terrain_data();
+	uint16_t sum = 0;
+	for (uint16_t i = 0; i < SAVE_VISIBLE_OFFSET; i++) {
+		sum += bytes[i];
+	}
+	bytes = get_visible_data();
+	for (uint16_t i = 0; i < SAVE_IMAGE_SIZE - SAVE_VISIBLE_OFFSET; i++) {
+		sum += bytes[i];
+	}
+	return sum;
+}
+
+// returns the first dirty block, or SAVE_NUM_BLOCKS if there are none
+static uint8_t next_dirty_block(void) {
+	for (uint8_t i = 0; i < SAVE_NUM_BLOCKS; i++) {
+		if (dirty[i >> 3] & (1 << (i & 7))) {
+			return i;
+		}
+	}
+	return SAVE_NUM_BLOCKS;
+}
+
+// marks the saved copy as not to be resumed
+static void invalidate(void) {
+	if (header.valid != 0) {
+		header.valid = 0;
+		storage_write(SAVE_EEPROM_START + offsetof(SaveHeader, valid),
+				&header.valid, 1);
+	}
+}
+
+void init_save(void) {
+	storage_read(SAVE_EEPROM_START, &header, sizeof(header));
+	saving = 0;
+	state = SAVE_IDLE;
+}
+
+uint8_t save_available(void) {
+	return header.valid == SAVE_VALID
+			&& header.checksum == header_checksum(&header);
+}
+
+uint8_t save_resume(void) {
+	if (!save_available()) {
+		return 0;
+	}
+	restore_saved_game(&header.game);
+	for (uint16_t offset = 0; offset < SAVE_IMAGE_SIZE;
+			offset += SAVE_BLOCK_SIZE) {
+		storage_read(SAVE_IMAGE_EEPROM_START + offset, image_address(offset),
+				SAVE_BLOCK_SIZE);
+	}
+	if (image_checksum() != header.image_checksum) {
+		return 0;
+	}
+	resume_game_display();
+	// the EEPROM already matches the game
+	memset(dirty, 0, sizeof(dirty));
+	saving = 1;
+	state = SAVE_IDLE;
+	last_save_time = get_current_time();
+	return 1;
+}
+
+void save_start(void) {
+	// the old copy no longer matches the game, the playing field has
+	// been marked dirty as the level was set up
+	invalidate();
+	saving = 1;
+	state = SAVE_IDLE;
+	last_save_time = get_current_time();
+}
+
+void save_discard(void) {
+	invalidate();
+	saving = 0;
+	state = SAVE_IDLE;
+}
+
+void save_mark_dirty(uint16_t offset) {
+	uint8_t i = offset / SAVE_BLOCK_SIZE;
+	dirty[i >> 3] |= 1 << (i & 7);
+}
+
+void save_mark_all(void) {
+	memset(dirty, 0xFF, sizeof(dirty));
+}
+
+void save_update(void) {
+	// one write is queued at a time, and the header and block buffer
+	// are left alone until it is done
+	if (!saving || storage_busy()) {
+		return;
+	}
+	uint8_t i = next_dirty_block();
+	uint32_t now;
+	switch (state) {
+		case SAVE_IDLE:
+			now = get_current_time();
+			if (TIME_SINCE(now, last_save_time) < SAVE_INTERVAL) {
+				return;
+			}
+			last_save_time = now;
+			if (i != SAVE_NUM_BLOCKS) {
+				// the copy is incomplete until the header is written
+				invalidate();
+				state = SAVE_BLOCKS;
+			} else {
+				state = SAVE_HEADER;
+			}
+			break;
+		case SAVE_BLOCKS:
+			if (i == SAVE_NUM_BLOCKS) {
+				state = SAVE_HEADER;
+				break;
+			}
+			dirty[i >> 3] &= ~(1 << (i & 7));
+			memcpy(block, image_address(i * SAVE_BLOCK_SIZE), SAVE_BLOCK_SIZE);
+			storage_write(SAVE_IMAGE_EEPROM_START + i * SAVE_BLOCK_SIZE, block,
+					SAVE_BLOCK_SIZE);
+			break;
+		case SAVE_HEADER: {
+			if (i != SAVE_NUM_BLOCKS) {
+				// blocks changed while the others were written
+				state = SAVE_BLOCKS;
+				break;
+			}
+			// every block now matches the EEPROM, so the header describes
+			// the game as it is now
+			SaveHeader next;
+			memset(&next, 0, sizeof(next));
+			next.valid = SAVE_VALID;
+			get_saved_game(&next.game);
+			next.image_checksum = image_checksum();
+			next.checksum = header_checksum(&next);
+			if (memcmp(&next, &header, sizeof(header)) != 0) {
+				header = next;
+				storage_write(SAVE_EEPROM_START, &header, sizeof(header));
+			}
+			state = SAVE_IDLE;
+			break;
+		}
+	}
+}
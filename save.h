@@ -0,0 +1,73 @@
+/*
+ * save.h
+ *
+ * Author: William Sawyer
+ *
+ * Keeps the game in progress in the EEPROM so it can be resumed after
+ * the power is lost. A whole copy of the game is about 600 bytes, which
+ * would take about two seconds to program, so instead the playing
+ * field is divided into blocks which are marked dirty as they change.
+ * Every few seconds the dirty blocks are written in the background (see
+ * storage.h), followed by a header with the rest of the game state and
+ * checksums. The header is marked invalid while blocks are being
+ * written, so a copy cut short by a power loss is never resumed.
+ */
+
+#ifndef SAVE_H_
+#define SAVE_H_
+
+#include <stdint.h>
+
+#include "levels.h"
+
+// where the packed terrain and visibility (see levels.h) are kept in the
+// saved playing field, for save_mark_dirty()
+#define SAVE_TERRAIN_OFFSET	0
+#define SAVE_VISIBLE_OFFSET	(WORLD_MAX_WIDTH * WORLD_MAX_HEIGHT / 4)
+#define SAVE_IMAGE_SIZE		(SAVE_VISIBLE_OFFSET \
+		+ WORLD_MAX_WIDTH * WORLD_MAX_HEIGHT / 8)
+
+// the playing field is written in blocks of this many bytes
+#define SAVE_BLOCK_SIZE		16
+#define SAVE_NUM_BLOCKS		(SAVE_IMAGE_SIZE / SAVE_BLOCK_SIZE)
+
+// the least time between copies being started, in ms, to limit EEPROM wear
+#define SAVE_INTERVAL		5000
+
+/* Check the EEPROM for a saved game.
+ */
+void init_save(void);
+
+/* Return 1 if there is a saved game which can be resumed.
+ */
+uint8_t save_available(void);
+
+/* Restore the saved game (see restore_saved_game() in game.h) and show
+ * it, then keep saving it as it is played. Returns 0, leaving the game
+ * to be started afresh, if the saved playing field can't be read back.
+ */
+uint8_t save_resume(void);
+
+/* Start keeping the game which has just been started.
+ */
+void save_start(void);
+
+/* Stop keeping the game and throw away the saved copy, for when the
+ * game is over.
+ */
+void save_discard(void);
+
+/* Mark the byte at 'offset' in the saved playing field as changed.
+ */
+void save_mark_dirty(uint16_t offset);
+
+/* Mark the whole playing field as changed, for when a level starts.
+ */
+void save_mark_all(void);
+
+/* Write the next part of the saved game if it is due and the EEPROM is
+ * free. Call this regularly while the game is played.
+ */
+void save_update(void);
+
+#endif /* SAVE_H_ */
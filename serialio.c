@@ -1,363 +1,474 @@
-/*
- * FILE: serialio.c
- *
- * Written by Peter Sutton.
- * 
- * Module to allow standard input/output routines to be used via 
- * serial port 0. The init_serial_stdio() method must be called before
- * any standard IO methods (e.g. printf). We use interrupt-based output
- * and a circular buffer to store output messages. (This allows us 
- * to print many characters at once to the buffer and have them 
- * output by the UART as speed permits.) If the buffer fills up, the
- * put method will either
- * (1) if interrupts are enabled, block until there is room in it, or
- * (2) if interrupts are disabled, will discard the character.
- * Input is blocking - requesting input from stdin will block
- * until a character is available. If interrupts are disabled when 
- * input is sought, then this will block forever.
- * The function input_available() can be used to test whether there is
- * input available to read from stdin.
- *
- */
-
-#include <stdio.h>
-#include <stdint.h>
-
-#include <avr/io.h>
-#include <avr/interrupt.h>
-
-#define SSD			PORTC
-#define SSD_CC		PORTD2
-#define DETECTOR	PORTD3
-#define DANGER		PORTD4
-#define JOY_UD		PORTA0
-#define JOY_LR		PORTA1
-
-/* System clock rate in Hz. (L at the end indicates this is a long constant) */
-#define SYSCLK 8000000L
-
-/* Global variables */
-/* Circular buffer to hold outgoing characters. The insert_pos variable
- * keeps track of the position (0 to OUTPUT_BUFFER_SIZE-1) that the next
- * outgoing character should be written to. bytes_in_buffer keeps
- * count of the number of characters currently stored in the buffer 
- * (ranging from 0 to OUTPUT_BUFFER_SIZE). This number of bytes immediately
- * prior to the current insert_pos are the bytes waiting to be output.
- * If the insert_pos reaches the end of the buffer it will wrap around
- * to the beginning (assuming those bytes have been output).
- * NOTE - OUTPUT_BUFFER_SIZE can not be larger than 255 without changing
- * the type of the variables below (currently defined as 8 bit unsigned ints).
- */
-#define OUTPUT_BUFFER_SIZE 255
-volatile char out_buffer[OUTPUT_BUFFER_SIZE];
-volatile uint8_t out_insert_pos;
-volatile uint8_t bytes_in_out_buffer;
-
-/* Circular buffer to hold incoming characters. Works on same principle
- * as output buffer
- */
-#define INPUT_BUFFER_SIZE 16
-volatile char input_buffer[INPUT_BUFFER_SIZE];
-volatile uint8_t input_insert_pos;
-volatile uint8_t bytes_in_input_buffer;
-volatile uint8_t input_overrun;
-
-/* Variable to keep track of whether incoming characters are to be echoed
- * back or not.
- */
-static int8_t do_echo;
-
-/* Function prototypes 
- */
-void init_serial_stdio(long baudrate, int8_t echo);
-static int uart_put_char(char, FILE*);
-static int uart_get_char(FILE*);
-
-uint8_t detector_visible = 1;
-uint8_t seven_seg_digit = 0; // 0 - ones, 1 - tens
-
-/* Setup a stream that uses the uart get and put functions. We will
- * make standard input and output use this stream below.
- */
-static FILE myStream = FDEV_SETUP_STREAM(uart_put_char, uart_get_char,
-		_FDEV_SETUP_RW);
-
-/* Seven segment display values */
-static const uint8_t ssd_values[10] = {63, 6, 91, 79, 102, 109, 125, 7, 127, 111};
-
-void seven_seg(uint8_t number) {
-	uint8_t tens = number / 10;
-	uint8_t ones = number % 10;
-
-	if (!seven_seg_digit) {
-		PORTD &= ~(1 << SSD_CC);
-		SSD = ssd_values[ones];
-	} else if (tens) {
-		PORTD |= 1 << SSD_CC;
-		SSD = ssd_values[tens];
-	}
-
-	seven_seg_digit = 1 - seven_seg_digit;
-}
-
-void flash_detector(void) {
-	detector_visible = 1 - detector_visible;
-	if (detector_visible) {
-		PORTD |= 1 << DETECTOR;
-	} else {
-		PORTD &= ~(1 << DETECTOR);
-	}
-}
-
-void clear_detector(void) {
-	detector_visible = 0;
-	PORTD &= ~(1 << DETECTOR);
-}
-
-void danger_light(uint8_t on) {
-	if (on) {
-		PORTD |= (1 << DANGER);
-	} else {
-		PORTD &= ~(1 << DANGER);
-	}
-}
-
-void init_serial_stdio(long baudrate, int8_t echo) {
-	uint16_t ubrr;
-	/*
-	 * Initialise our buffers
-	*/
-	out_insert_pos = 0;
-	bytes_in_out_buffer = 0;
-	input_insert_pos = 0;
-	bytes_in_input_buffer = 0;
-	input_overrun = 0;
-	
-	/*
-	 * Record whether we're going to echo characters or not
-	*/
-	do_echo = echo;
-	
-	/* Configure the serial port baud rate */
-	/* (This differs from the datasheet formula so that we get 
-	 * rounding to the nearest integer while using integer division
-	 * (which truncates)).
-	*/
-	ubrr = ((SYSCLK / (8 * baudrate)) + 1)/2 - 1;
-	UBRR0 = ubrr;
-	
-	/*
-	 * Enable transmission and receiving via UART. We don't enable
-	 * the UDR empty interrupt here (we wait until we've got a
-	 * character to transmit).
-	 * NOTE: Interrupts must be enabled globally for this
-	 * library to work, but we do not do this here.
-	*/
-	UCSR0B = (1<<RXEN0)|(1<<TXEN0);
-	
-	/*
-	 * Enable receive complete interrupt 
-	*/
-	UCSR0B  |= (1 <<RXCIE0);
-
-	/* Set up our stream so the put and get functions below are used 
-	 * to write/read characters via the serial port when we use
-	 * stdio functions
-	*/
-	stdout = &myStream;
-	stdin = &myStream;
-	
-	/*
-	 * Port A: Input
-	 * Port B: Input
-	 * Port C: Output
-	 * Port D: [0-1] - TX/RX
-	 *	       [2-7] - Output
-	 */
-	DDRC = 0xFF;
-	DDRD = 0xFC;
-}
-
-int8_t serial_input_available(void) {
-	return (bytes_in_input_buffer != 0);
-}
-
-void clear_serial_input_buffer(void) {
-	/* Just adjust our buffer data so it looks empty */
-	input_insert_pos = 0;
-	bytes_in_input_buffer = 0;
-}
-
-static int uart_put_char(char c, FILE* stream) {
-	uint8_t interrupts_enabled;
-	
-	/* Add the character to the buffer for transmission (if there 
-	 * is space to do so). If not we wait until the buffer has space.
-	 * If the character is \n, we output \r (carriage return)
-	 * also.
-	*/
-	if (c == '\n') {
-		uart_put_char('\r', stream);
-	}
-	
-	/* If the buffer is full and interrupts are disabled then we
-	 * abort - we don't output the character since the buffer will
-	 * never be emptied if interrupts are disabled. If the buffer is full
-	 * and interrupts are enabled then we loop until the buffer has 
-	 * enough space. The bytes_in_buffer variable will get modified by the
-	 * ISR which extracts bytes from the buffer.
-	*/
-	interrupts_enabled = bit_is_set(SREG, SREG_I);
-	while (bytes_in_out_buffer >= OUTPUT_BUFFER_SIZE) {
-		if (!interrupts_enabled) {
-			return 1;
-		}		
-		/* else do nothing */
-	}
-	
-	/* Add the character to the buffer for transmission if there
-	 * is space to do so. We advance the insert_pos to the next
-	 * character position. If this is beyond the end of the buffer
-	 * we wrap around back to the beginning of the buffer 
-	 * NOTE: we disable interrupts before modifying the buffer. This
-	 * prevents the ISR from modifying the buffer at the same time.
-	 * We reenable them if they were enabled when we entered the
-	 * function.
-	*/	
-	cli();
-	out_buffer[out_insert_pos++] = c;
-	bytes_in_out_buffer++;
-	if (out_insert_pos == OUTPUT_BUFFER_SIZE) {
-		/* Wrap around buffer pointer if necessary */
-		out_insert_pos = 0;
-	}
-	/* Reenable interrupts (UDR Empty interrupt may have been
-	 * disabled) - we ensure it is now enabled so that it will
-	 * fire and deal with the next character in the buffer. */
-	UCSR0B |= (1 << UDRIE0);
-	if (interrupts_enabled) {
-		sei();
-	}
-	return 0;
-}
-
-int uart_get_char(FILE* stream) {
-	/* Wait until we've received a character */
-	while (bytes_in_input_buffer == 0) {
-		/* do nothing */
-	}
-	
-	/*
-	 * Turn interrupts off and remove a character from the input
-	 * buffer. We reenable interrupts if they were on.
-	 * The pending character is the one which is byte_in_input_buffer
-	 * characters before the insert position (taking into account
-	 * that we may need to wrap around).
-	 */
-	uint8_t interrupts_enabled = bit_is_set(SREG, SREG_I);
-	cli();
-	char c;
-	if (input_insert_pos - bytes_in_input_buffer < 0) {
-		/* Need to wrap around */
-		c = input_buffer[input_insert_pos - bytes_in_input_buffer
-				+ INPUT_BUFFER_SIZE];
-	} else {
-		c = input_buffer[input_insert_pos - bytes_in_input_buffer];
-	}
-	
-	/* Decrement our count of bytes in the input buffer */
-	bytes_in_input_buffer--;
-	if (interrupts_enabled) {
-		sei();
-	}	
-	return c;
-}
-
-/*
- * Define the interrupt handler for UART Data Register Empty (i.e. 
- * another character can be taken from our buffer and written out)
- */
-ISR(USART0_UDRE_vect) 
-{
-	/* Check if we have data in our buffer */
-	if (bytes_in_out_buffer > 0) {
-		/* Yes we do - remove the pending byte and output it
-		 * via the UART. The pending byte (character) is the
-		 * one which is "bytes_in_buffer" characters before the 
-		 * insert_pos (taking into account that we may 
-		 * need to wrap around to the end of the buffer).
-		 */
-		char c;
-		if (out_insert_pos - bytes_in_out_buffer < 0) {
-			/* Need to wrap around */
-			c = out_buffer[out_insert_pos - bytes_in_out_buffer
-				+ OUTPUT_BUFFER_SIZE];
-		} else {
-			c = out_buffer[out_insert_pos - bytes_in_out_buffer];
-		}
-		/* Decrement our count of the number of bytes in the 
-		 * buffer 
-		 */
-		bytes_in_out_buffer--;
-		
-		/* Output the character via the UART */
-		UDR0 = c;
-	} else {
-		/* No data in the buffer. We disable the UART Data
-		 * Register Empty interrupt because otherwise it 
-		 * will trigger again immediately this ISR exits. 
-		 * The interrupt is reenabled when a character is
-		 * placed in the buffer.
-		 */
-		UCSR0B &= ~(1<<UDRIE0);
-	}
-}
-
-/*
- * Define the interrupt handler for UART Receive Complete (i.e. 
- * we can read a character. The character is read and placed in
- * the input buffer.
- */
-
-ISR(USART0_RX_vect) 
-{
-	/* Read the character - we ignore the possibility of overrun. */
-	char c;
-	c = UDR0;
-		
-	if (do_echo && bytes_in_out_buffer < OUTPUT_BUFFER_SIZE) {
-		/* If echoing is enabled and there is output buffer
-		 * space, echo the received character back to the UART.
-		 * (If there is no output buffer space, characters
-		 * will be lost.)
-		 */
-		uart_put_char(c, 0);
-	}
-	
-	/* 
-	 * Check if we have space in our buffer. If not, set the overrun
-	 * flag and throw away the character. (We never clear the 
-	 * overrun flag - it's up to the programmer to check/clear
-	 * this flag if desired.)
-	 */
-	if (bytes_in_input_buffer >= INPUT_BUFFER_SIZE) {
-		input_overrun = 1;
-	} else {
-		/* If the character is a carriage return, turn it into a
-		 * linefeed 
-		*/
-		if (c == '\r') {
-			c = '\n';
-		}
-		
-		/* 
-		 * There is room in the input buffer 
-		 */
-		input_buffer[input_insert_pos++] = c;
-		bytes_in_input_buffer++;
-		if (input_insert_pos == INPUT_BUFFER_SIZE) {
-			/* Wrap around buffer pointer if necessary */
-			input_insert_pos = 0;
-		}
-	}
-}
+/*
+ * FILE: serialio.c
+ *
+ * Written by Peter Sutton.
+ * 
+ * Module to allow standard input/output routines to be used via 
+ * serial port 0. The init_serial_stdio() method must be called before
+ * any standard IO methods (e.g. printf). We use interrupt-based output
+ * and a circular buffer to store output messages. (This allows us 
+ * to print many characters at once to the buffer and have them 
+ * output by the UART as speed permits.) If the buffer fills up, the
+ * put method will either
+ * (1) if interrupts are enabled, block until there is room in it, or
+ * (2) if interrupts are disabled, will discard the character.
+ * Input is blocking - requesting input from stdin will block
+ * until a character is available. If interrupts are disabled when 
+ * input is sought, then this will block forever.
+ * The function input_available() can be used to test whether there is
+ * input available to read from stdin.
+ *
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+
+#include "serialio.h"
+#include "profile.h"
+#include "latency.h"
+#include "trace.h"
+
+#include "spectator.h"
+
+#define SSD			PORTC
+#define SSD_CC		PORTD2
+#if SPECTATOR
+// pin D3 is TXD1, used for the spectator feed
+#define DETECTOR	PORTD5
+#else
+#define DETECTOR	PORTD3
+#endif
+#define DANGER		PORTD4
+#define JOY_UD		PORTA0
+#define JOY_LR		PORTA1
+
+/* System clock rate in Hz. (L at the end indicates this is a long constant) */
+#define SYSCLK 8000000L
+
+/* Global variables */
+/* Circular buffer to hold outgoing characters. The insert_pos variable
+ * keeps track of the position (0 to OUTPUT_BUFFER_SIZE-1) that the next
+ * outgoing character should be written to. bytes_in_buffer keeps
+ * count of the number of characters currently stored in the buffer 
+ * (ranging from 0 to OUTPUT_BUFFER_SIZE). This number of bytes immediately
+ * prior to the current insert_pos are the bytes waiting to be output.
+ * If the insert_pos reaches the end of the buffer it will wrap around
+ * to the beginning (assuming those bytes have been output).
+ * NOTE - OUTPUT_BUFFER_SIZE can not be larger than 255 without changing
+ * the type of the variables below (currently defined as 8 bit unsigned ints).
+ */
+#define OUTPUT_BUFFER_SIZE 255
+volatile char out_buffer[OUTPUT_BUFFER_SIZE];
+volatile uint8_t out_insert_pos;
+volatile uint8_t bytes_in_out_buffer;
+
+/* Circular buffer to hold incoming characters. Works on same principle
+ * as output buffer. It is big enough for a script to send a burst of
+ * keys while the game loop is busy (e.g. redrawing after a level change).
+ */
+#define INPUT_BUFFER_SIZE 64
+volatile char input_buffer[INPUT_BUFFER_SIZE];
+volatile uint8_t input_insert_pos;
+volatile uint8_t bytes_in_input_buffer;
+// characters thrown away since serial_input_lost() was last called
+volatile uint8_t input_overrun;
+
+#if SERIAL_FLOW_CONTROL
+/* XOFF is sent when the input buffer is down to this many free bytes,
+ * leaving room for what the sender has already queued (USB serial 
+ * adapters can have a few bytes in flight), and XON once it has
+ * drained to a quarter full.
+ */
+#define INPUT_HEADROOM		16
+#define INPUT_RESUME		(INPUT_BUFFER_SIZE / 4)
+static volatile uint8_t input_stopped;
+// XON or XOFF waiting to be sent ahead of the output buffer, 0 if none
+static volatile uint8_t flow_char;
+
+static void send_flow_char(uint8_t c);
+#endif
+
+/* Variable to keep track of whether incoming characters are to be echoed
+ * back or not.
+ */
+static int8_t do_echo;
+
+/* Function prototypes 
+ */
+void init_serial_stdio(long baudrate, int8_t echo);
+static int uart_put_char(char, FILE*);
+static int uart_get_char(FILE*);
+
+uint8_t detector_visible = 1;
+uint8_t seven_seg_digit = 0; // 0 - ones, 1 - tens
+
+/* Setup a stream that uses the uart get and put functions. We will
+ * make standard input and output use this stream below.
+ */
+static FILE myStream = FDEV_SETUP_STREAM(uart_put_char, uart_get_char,
+		_FDEV_SETUP_RW);
+
+/* Seven segment display values */
+static const uint8_t ssd_values[10] = {63, 6, 91, 79, 102, 109, 125, 7, 127, 111};
+
+void seven_seg(uint8_t number) {
+	uint8_t tens = number / 10;
+	uint8_t ones = number % 10;
+
+	if (!seven_seg_digit) {
+		PORTD &= ~(1 << SSD_CC);
+		SSD = ssd_values[ones];
+	} else if (tens) {
+		PORTD |= 1 << SSD_CC;
+		SSD = ssd_values[tens];
+	}
+
+	seven_seg_digit = 1 - seven_seg_digit;
+}
+
+void flash_detector(void) {
+	detector_visible = 1 - detector_visible;
+	if (detector_visible) {
+		PORTD |= 1 << DETECTOR;
+	} else {
+		PORTD &= ~(1 << DETECTOR);
+	}
+}
+
+void clear_detector(void) {
+	detector_visible = 0;
+	PORTD &= ~(1 << DETECTOR);
+}
+
+void danger_light(uint8_t on) {
+	if (on) {
+		PORTD |= (1 << DANGER);
+	} else {
+		PORTD &= ~(1 << DANGER);
+	}
+}
+
+void init_serial_stdio(long baudrate, int8_t echo) {
+	uint16_t ubrr;
+	/*
+	 * Initialise our buffers
+	*/
+	out_insert_pos = 0;
+	bytes_in_out_buffer = 0;
+	input_insert_pos = 0;
+	bytes_in_input_buffer = 0;
+	input_overrun = 0;
+	
+	/*
+	 * Record whether we're going to echo characters or not
+	*/
+	do_echo = echo;
+	
+	/* Configure the serial port baud rate */
+	/* (This differs from the datasheet formula so that we get 
+	 * rounding to the nearest integer while using integer division
+	 * (which truncates)).
+	*/
+	ubrr = ((SYSCLK / (8 * baudrate)) + 1)/2 - 1;
+	UBRR0 = ubrr;
+	
+	/*
+	 * Enable transmission and receiving via UART. We don't enable
+	 * the UDR empty interrupt here (we wait until we've got a
+	 * character to transmit).
+	 * NOTE: Interrupts must be enabled globally for this
+	 * library to work, but we do not do this here.
+	*/
+	UCSR0B = (1<<RXEN0)|(1<<TXEN0);
+	
+	/*
+	 * Enable receive complete interrupt 
+	*/
+	UCSR0B  |= (1 <<RXCIE0);
+
+	/* Set up our stream so the put and get functions below are used 
+	 * to write/read characters via the serial port when we use
+	 * stdio functions
+	*/
+	stdout = &myStream;
+	stdin = &myStream;
+	
+	/*
+	 * Port A: Input
+	 * Port B: Input
+	 * Port C: Output
+	 * Port D: [0-1] - TX/RX
+	 *	       [2-7] - Output
+	 */
+	DDRC = 0xFF;
+	DDRD = 0xFC;
+}
+
+int8_t serial_input_available(void) {
+	return (bytes_in_input_buffer != 0);
+}
+
+uint8_t serial_input_lost(void) {
+	uint8_t interrupts_enabled = bit_is_set(SREG, SREG_I);
+	cli();
+	uint8_t lost = input_overrun;
+	input_overrun = 0;
+	if (interrupts_enabled) {
+		sei();
+	}
+	return lost;
+}
+
+uint8_t serial_output_pending(void) {
+	return bytes_in_out_buffer;
+}
+
+void clear_serial_input_buffer(void) {
+	/* Just adjust our buffer data so it looks empty */
+	uint8_t interrupts_enabled = bit_is_set(SREG, SREG_I);
+	cli();
+	input_insert_pos = 0;
+	bytes_in_input_buffer = 0;
+#if SERIAL_FLOW_CONTROL
+	if (input_stopped) {
+		send_flow_char(XON);
+	}
+#endif
+	if (interrupts_enabled) {
+		sei();
+	}
+}
+
+#if SERIAL_FLOW_CONTROL
+/* Send XON or XOFF ahead of anything in the output buffer, otherwise it
+ * could be stuck behind a whole screen of output. Called with interrupts
+ * off.
+ */
+static void send_flow_char(uint8_t c) {
+	input_stopped = (c == XOFF);
+	flow_char = c;
+	UCSR0B |= (1 << UDRIE0);
+}
+#endif
+
+static int uart_put_char(char c, FILE* stream) {
+	/* If the character is \n, we output \r (carriage return)
+	 * also.
+	*/
+	if (c == '\n') {
+		uart_put_char('\r', stream);
+	}
+	return serial_put_raw(c);
+}
+
+int8_t serial_put_raw(uint8_t c) {
+	uint8_t interrupts_enabled;
+	
+	/* Add the character to the buffer for transmission (if there 
+	 * is space to do so). If not we wait until the buffer has space.
+	*/
+	/* If the buffer is full and interrupts are disabled then we
+	 * abort - we don't output the character since the buffer will
+	 * never be emptied if interrupts are disabled. If the buffer is full
+	 * and interrupts are enabled then we loop until the buffer has 
+	 * enough space. The bytes_in_buffer variable will get modified by the
+	 * ISR which extracts bytes from the buffer.
+	*/
+	interrupts_enabled = bit_is_set(SREG, SREG_I);
+	if (bytes_in_out_buffer >= OUTPUT_BUFFER_SIZE) {
+		if (!interrupts_enabled) {
+			return 1;
+		}
+		PROFILE_WAIT_START();
+		TRACE_TIME_START();
+		while (bytes_in_out_buffer >= OUTPUT_BUFFER_SIZE) {
+			/* do nothing */
+		}
+		PROFILE_WAIT_END(PROFILE_WAIT_UART);
+		TRACE_UART_STALL_END();
+	}
+	
+	/* Add the character to the buffer for transmission if there
+	 * is space to do so. We advance the insert_pos to the next
+	 * character position. If this is beyond the end of the buffer
+	 * we wrap around back to the beginning of the buffer 
+	 * NOTE: we disable interrupts before modifying the buffer. This
+	 * prevents the ISR from modifying the buffer at the same time.
+	 * We reenable them if they were enabled when we entered the
+	 * function.
+	*/	
+	cli();
+	out_buffer[out_insert_pos++] = c;
+	bytes_in_out_buffer++;
+	if (out_insert_pos == OUTPUT_BUFFER_SIZE) {
+		/* Wrap around buffer pointer if necessary */
+		out_insert_pos = 0;
+	}
+	/* Reenable interrupts (UDR Empty interrupt may have been
+	 * disabled) - we ensure it is now enabled so that it will
+	 * fire and deal with the next character in the buffer. */
+	UCSR0B |= (1 << UDRIE0);
+	if (interrupts_enabled) {
+		sei();
+	}
+	return 0;
+}
+
+int uart_get_char(FILE* stream) {
+	/* Wait until we've received a character */
+	while (bytes_in_input_buffer == 0) {
+		/* do nothing */
+	}
+	
+	/*
+	 * Turn interrupts off and remove a character from the input
+	 * buffer. We reenable interrupts if they were on.
+	 * The pending character is the one which is byte_in_input_buffer
+	 * characters before the insert position (taking into account
+	 * that we may need to wrap around).
+	 */
+	uint8_t interrupts_enabled = bit_is_set(SREG, SREG_I);
+	cli();
+	char c;
+	if (input_insert_pos - bytes_in_input_buffer < 0) {
+		/* Need to wrap around */
+		c = input_buffer[input_insert_pos - bytes_in_input_buffer
+				+ INPUT_BUFFER_SIZE];
+	} else {
+		c = input_buffer[input_insert_pos - bytes_in_input_buffer];
+	}
+	
+	/* Decrement our count of bytes in the input buffer */
+	bytes_in_input_buffer--;
+#if SERIAL_FLOW_CONTROL
+	if (input_stopped && bytes_in_input_buffer <= INPUT_RESUME) {
+		send_flow_char(XON);
+	}
+#endif
+	if (interrupts_enabled) {
+		sei();
+	}	
+	return c;
+}
+
+/*
+ * Define the interrupt handler for UART Data Register Empty (i.e. 
+ * another character can be taken from our buffer and written out)
+ */
+ISR(USART0_UDRE_vect) 
+{
+#if SERIAL_FLOW_CONTROL
+	/* Flow control jumps the queue */
+	if (flow_char) {
+		UDR0 = flow_char;
+		flow_char = 0;
+		return;
+	}
+#endif
+	/* Check if we have data in our buffer */
+	if (bytes_in_out_buffer > 0) {
+		/* Yes we do - remove the pending byte and output it
+		 * via the UART. The pending byte (character) is the
+		 * one which is "bytes_in_buffer" characters before the 
+		 * insert_pos (taking into account that we may 
+		 * need to wrap around to the end of the buffer).
+		 */
+		char c;
+		if (out_insert_pos - bytes_in_out_buffer < 0) {
+			/* Need to wrap around */
+			c = out_buffer[out_insert_pos - bytes_in_out_buffer
+				+ OUTPUT_BUFFER_SIZE];
+		} else {
+			c = out_buffer[out_insert_pos - bytes_in_out_buffer];
+		}
+		/* Decrement our count of the number of bytes in the 
+		 * buffer 
+		 */
+		bytes_in_out_buffer--;
+		
+		/* Output the character via the UART */
+		UDR0 = c;
+	} else {
+		/* No data in the buffer. We disable the UART Data
+		 * Register Empty interrupt because otherwise it 
+		 * will trigger again immediately this ISR exits. 
+		 * The interrupt is reenabled when a character is
+		 * placed in the buffer.
+		 */
+		UCSR0B &= ~(1<<UDRIE0);
+	}
+}
+
+/*
+ * Define the interrupt handler for UART Receive Complete (i.e. 
+ * we can read a character. The character is read and placed in
+ * the input buffer.
+ */
+
+ISR(USART0_RX_vect) 
+{
+	/* Read the character. If the UART had to drop a character because
+	 * this interrupt was held off too long it is counted as lost. (The
+	 * flag must be read before the data register.)
+	 */
+	char c;
+	uint8_t hardware_overrun = UCSR0A & (1 << DOR0);
+	c = UDR0;
+	if (hardware_overrun && input_overrun < 255) {
+		input_overrun++;
+	}
+#if SERIAL_FLOW_CONTROL
+	/* The terminal's own XON/XOFF aren't keys */
+	if (c == XON || c == XOFF) {
+		return;
+	}
+#endif
+	latency_mark_input();
+		
+	if (do_echo && bytes_in_out_buffer < OUTPUT_BUFFER_SIZE) {
+		/* If echoing is enabled and there is output buffer
+		 * space, echo the received character back to the UART.
+		 * (If there is no output buffer space, characters
+		 * will be lost.)
+		 */
+		uart_put_char(c, 0);
+	}
+	
+	/* 
+	 * Check if we have space in our buffer. If not, count the
+	 * character as lost and throw it away. (The count is reported by
+	 * the game loop, see serial_input_lost().)
+	 */
+	if (bytes_in_input_buffer >= INPUT_BUFFER_SIZE) {
+		if (input_overrun < 255) {
+			input_overrun++;
+		}
+	} else {
+		/* If the character is a carriage return, turn it into a
+		 * linefeed 
+		*/
+		if (c == '\r') {
+			c = '\n';
+		}
+		
+		/* 
+		 * There is room in the input buffer 
+		 */
+		input_buffer[input_insert_pos++] = c;
+		bytes_in_input_buffer++;
+		if (input_insert_pos == INPUT_BUFFER_SIZE) {
+			/* Wrap around buffer pointer if necessary */
+			input_insert_pos = 0;
+		}
+#if SERIAL_FLOW_CONTROL
+		/* Ask the sender to stop before the buffer fills */
+		if (!input_stopped && bytes_in_input_buffer 
+				>= INPUT_BUFFER_SIZE - INPUT_HEADROOM) {
+			send_flow_char(XOFF);
+		}
+#endif
+	}
+}
@@ -1,47 +1,77 @@
-/*
- * serialio.h
- *
- * Author: Peter Sutton
- * 
- * Module to allow standard input/output routines to be used via 
- * serial port 0. The init_serial_stdio() method must be called before
- * any standard IO methods (e.g. printf). We use interrupt-based serial
- * IO and a circular buffer to store output messages. (This allows us 
- * to print many characters at once to the buffer and have them 
- * output by the UART as speed permits.) Interrupts must be enabled 
- * globally for this module to work (after init_serial_stdio() is called).
- *
- */
-
-#ifndef SERIALIO_H_
-#define SERIALIO_H_
-
-#include <stdint.h>
-
-void flash_detector(void);
-void clear_detector(void);
-void danger_light(uint8_t on);
-
-/* Initialise serial IO using the UART. baudrate specifies the desired
- * baud rate (e.g. 19200) and echo determines whether incoming characters
- * are echoed back to the UART output as they are received (zero means no
- * echo, non-zero means echo)
- */
-void init_serial_stdio(long baudrate, int8_t echo);
-
-/* Test if input is available from the serial port. Return 0 if not,
- * non-zero otherwise. If there is input available then it can be read
- * with a suitable standard IO library function, e.g. fgetc().
- */
-int8_t serial_input_available(void);
-
-/* Discard any input waiting to be read from the serial port. (Characters may
- * have been typed when we didn't want them - clear them.
- */
-void clear_serial_input_buffer(void);
-
-/* Displays number on the seven segment display.
- */
-void seven_seg(uint8_t number);
-
+/*
+ * serialio.h
+ *
+ * Author: Peter Sutton
+ * 
+ * Module to allow standard input/output routines to be used via 
+ * serial port 0. The init_serial_stdio() method must be called before
+ * any standard IO methods (e.g. printf). We use interrupt-based serial
+ * IO and a circular buffer to store output messages. (This allows us 
+ * to print many characters at once to the buffer and have them 
+ * output by the UART as speed permits.) Interrupts must be enabled 
+ * globally for this module to work (after init_serial_stdio() is called).
+ *
+ */
+
+#ifndef SERIALIO_H_
+#define SERIALIO_H_
+
+#include <stdint.h>
+
+/* Software flow control of the input: XOFF (ctrl-S) is sent when the
+ * input buffer is nearly full and XON (ctrl-Q) once it has drained, so a
+ * script sending keys at full speed doesn't lose any, as long as the
+ * terminal honours them. Define SERIAL_FLOW_CONTROL to 0 to leave it
+ * out.
+ */
+#ifndef SERIAL_FLOW_CONTROL
+#define SERIAL_FLOW_CONTROL 1
+#endif
+
+#define XON		0x11
+#define XOFF	0x13
+
+void flash_detector(void);
+void clear_detector(void);
+void danger_light(uint8_t on);
+
+/* Initialise serial IO using the UART. baudrate specifies the desired
+ * baud rate (e.g. 19200) and echo determines whether incoming characters
+ * are echoed back to the UART output as they are received (zero means no
+ * echo, non-zero means echo)
+ */
+void init_serial_stdio(long baudrate, int8_t echo);
+
+/* Test if input is available from the serial port. Return 0 if not,
+ * non-zero otherwise. If there is input available then it can be read
+ * with a suitable standard IO library function, e.g. fgetc().
+ */
+int8_t serial_input_available(void);
+
+/* Return the number of characters received which had to be thrown away
+ * (the input buffer was full or the UART was overrun) since this was last
+ * called, up to 255.
+ */
+uint8_t serial_input_lost(void);
+
+/* Send a byte as it is, without the \r added before \n by stdout, for
+ * binary data. Like stdout it waits for room in the output buffer, and
+ * returns non-zero if the byte was thrown away because interrupts are
+ * off.
+ */
+int8_t serial_put_raw(uint8_t c);
+
+/* Return the number of characters still waiting to be sent.
+ */
+uint8_t serial_output_pending(void);
+
+/* Discard any input waiting to be read from the serial port. (Characters may
+ * have been typed when we didn't want them - clear them.
+ */
+void clear_serial_input_buffer(void);
+
+/* Displays number on the seven segment display.
+ */
+void seven_seg(uint8_t number);
+
 #endif /* SERIALIO_H_ */
\ No newline at end of file
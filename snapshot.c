@@ -0,0 +1,78 @@
+/*
+ * snapshot.c
+ *
+ * Author: William Sawyer
+ *
+ * Sends the frame described in snapshot.h.
+ */
+
+#include <stdint.h>
+#include <util/crc16.h>
+
+#include "snapshot.h"
+#include "serialio.h"
+#include "game.h"
+#include "gameclock.h"
+
+static uint16_t crc;
+
+// sends a byte of the frame, escaped if need be
+static void put_byte(uint8_t byte) {
+	crc = _crc_ccitt_update(crc, byte);
+	if (byte == SNAPSHOT_FLAG || byte == SNAPSHOT_ESCAPE || byte == XON 
+			|| byte == XOFF) {
+		serial_put_raw(SNAPSHOT_ESCAPE);
+		byte ^= 0x20;
+	}
+	serial_put_raw(byte);
+}
+
+static void put_word(uint16_t word) {
+	put_byte(word);
+	put_byte(word >> 8);
+}
+
+static void put_bytes(const uint8_t* bytes, uint16_t length) {
+	while (length--) {
+		put_byte(*bytes++);
+	}
+}
+
+void snapshot_send(void) {
+	SavedGame game;
+	get_saved_game(&game);
+	uint16_t squares = (uint16_t)get_world_width() * get_world_height();
+	uint32_t game_time = get_game_time();
+	
+	crc = 0xFFFF;
+	serial_put_raw(SNAPSHOT_FLAG);
+	put_byte(SNAPSHOT_VERSION);
+	put_byte(game.level);
+	put_byte(get_world_width());
+	put_byte(get_world_height());
+	put_byte(game.total_score);
+	put_byte(game.score);
+	put_byte(get_diamonds_available());
+	put_byte((game.cheating ? SNAPSHOT_CHEATING : 0)
+			| (game.exit_present ? SNAPSHOT_EXIT : 0)
+			| (changing_level() ? SNAPSHOT_CHANGING : 0));
+	put_byte(game.player_x);
+	put_byte(game.player_y);
+	put_byte(game.facing_x);
+	put_byte(game.facing_y);
+	put_word(game.diamonds_collected);
+	put_word(game_time);
+	put_word(game_time >> 16);
+	put_byte(game_clock_get_scale());
+	for (uint8_t i = 0; i < MAX_BOMBS; i++) {
+		put_byte(game.bomb_x[i]);
+		put_byte(game.bomb_y[i]);
+		put_word(game.bomb_age[i]);
+	}
+	put_bytes(get_terrain_data(), squares / 4);
+	put_bytes(get_visible_data(), squares / 8);
+	// the crc isn't part of what it covers
+	uint16_t frame_crc = crc;
+	put_word(frame_crc);
+	serial_put_raw(SNAPSHOT_FLAG);
+}
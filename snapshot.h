@@ -0,0 +1,56 @@
+/*
+ * snapshot.h
+ *
+ * Author: William Sawyer
+ *
+ * The whole game state in one binary frame on the terminal's serial
+ * port, sent when q is pressed, so that a bot or monitoring tool can sync
+ * in one round trip rather than scraping the terminal.
+ *
+ * The frame is framed and escaped as in HDLC: it starts and ends with
+ * SNAPSHOT_FLAG, and SNAPSHOT_FLAG, SNAPSHOT_ESCAPE, XON and XOFF in the
+ * frame are sent as SNAPSHOT_ESCAPE followed by the byte xor 0x20. Once
+ * unescaped the frame holds (numbers are little endian):
+ *
+ *     version         SNAPSHOT_VERSION
+ *     level           from 1
+ *     width, height   of the playing field
+ *     total score     from the levels before this one
+ *     score           diamonds collected on this level
+ *     diamonds        available on this level
+ *     flags           SNAPSHOT_CHEATING, SNAPSHOT_EXIT, SNAPSHOT_CHANGING
+ *     player x, y
+ *     facing x, y     the square the player is facing
+ *     collected       16 bits, a bit for each diamond collected
+ *     game time       32 bits, ms (see gameclock.h)
+ *     speed           game clock scale, GAME_CLOCK_SCALE_ONE is normal
+ *     bombs           MAX_BOMBS of x, y, and the ms since the bomb was
+ *                     lit (16 bits), NO_BOMB if it isn't lit
+ *     terrain         width * height / 4 bytes, packed as in levels.h
+ *     visible         width * height / 8 bytes, packed as in levels.h
+ *     crc             16 bits, CRC-16/MCRF4XX (_crc_ccitt_update() from
+ *                     0xFFFF) of everything before it
+ *
+ * That is 35 bytes of state, and 48 bytes of playing field on a level
+ * the size of the display. The frame goes through the output buffer
+ * with anything printed, so it can be sent while the game is played.
+ */
+
+#ifndef SNAPSHOT_H_
+#define SNAPSHOT_H_
+
+#define SNAPSHOT_VERSION	1
+
+#define SNAPSHOT_FLAG		0x7E
+#define SNAPSHOT_ESCAPE		0x7D
+
+// bits of the flags byte
+#define SNAPSHOT_CHEATING	0x01	// cheat mode is on
+#define SNAPSHOT_EXIT		0x02	// the exit is still on the playing field
+#define SNAPSHOT_CHANGING	0x04	// moving on to the next level
+
+/* Send a snapshot of the game to the terminal.
+ */
+void snapshot_send(void);
+
+#endif /* SNAPSHOT_H_ */
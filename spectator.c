@@ -0,0 +1,188 @@
+/*
+ * spectator.c
+ *
+ * Author: William Sawyer
+ *
+ * Records are placed whole into a circular buffer and sent by the 
+ * USART1 data register empty interrupt.
+ */
+
+#include <stdint.h>
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+
+#include "spectator.h"
+
+#if SPECTATOR
+
+#include "game.h"
+#include "display.h"
+
+#define SPECTATOR_BUFFER_SIZE	64
+
+// the most bytes a record can take
+#define MAX_RECORD_LENGTH		(3 + SPECTATOR_ROW_LENGTH)
+
+// progress through a resync
+#define RESYNC_DONE		0
+#define RESYNC_LEVEL	1	// the level record is next
+#define RESYNC_ROWS		2	// the rows are being sent
+#define RESYNC_PENDING	3	// start again from the level record
+
+static volatile uint8_t spectator_buffer[SPECTATOR_BUFFER_SIZE];
+static volatile uint8_t spectator_head;	// where the next byte is added
+static volatile uint8_t spectator_tail;	// the next byte to send
+static volatile uint8_t spectator_length;
+
+static uint8_t resync_state;
+static uint8_t resync_x, resync_y;	// the next square to send
+
+void init_spectator(void) {
+	// 250000 baud is exact from 8MHz in double speed mode
+	UBRR1 = 8000000L / (8 * SPECTATOR_BAUD) - 1;
+	UCSR1A = (1 << U2X1);
+	// 8 data bits, no parity, 1 stop bit, transmit only
+	UCSR1C = (1 << UCSZ11) | (1 << UCSZ10);
+	UCSR1B = (1 << TXEN1);
+	spectator_resync();
+}
+
+static uint8_t spectator_space(void) {
+	return SPECTATOR_BUFFER_SIZE - spectator_length;
+}
+
+// adds a record of 'length' bytes to the buffer, there must be room
+static void spectator_send(const uint8_t* record, uint8_t length) {
+	for (uint8_t i = 0; i < length; i++) {
+		spectator_buffer[spectator_head] = record[i];
+		if (++spectator_head == SPECTATOR_BUFFER_SIZE) {
+			spectator_head = 0;
+		}
+	}
+	// the interrupt handler only ever reduces the length
+	uint8_t interrupts_on = bit_is_set(SREG, SREG_I);
+	cli();
+	spectator_length += length;
+	UCSR1B |= (1 << UDRIE1);
+	if (interrupts_on) {
+		sei();
+	}
+}
+
+// sends a record reporting a change, or resyncs if there isn't room
+// 'resynced' is non-zero if a resync in progress has already sent the
+// part of the game this change is to
+static void spectator_change(const uint8_t* record, uint8_t length, 
+		uint8_t resynced) {
+	if (resync_state != RESYNC_DONE && !resynced) {
+		// the resync will include this change
+		return;
+	}
+	if (spectator_space() < length) {
+		resync_state = RESYNC_PENDING;
+		return;
+	}
+	spectator_send(record, length);
+}
+
+void spectator_resync(void) {
+	resync_state = RESYNC_PENDING;
+}
+
+// adds the next part of the row at (resync_x, resync_y) to 'record' as
+// runs, returns the length of the record
+static uint8_t spectator_row(uint8_t* record) {
+	uint8_t length = 3;
+	uint8_t end = resync_x + SPECTATOR_ROW_LENGTH;
+	if (end > get_world_width()) {
+		end = get_world_width();
+	}
+	record[0] = SPECTATOR_ROW;
+	record[1] = resync_y;
+	record[2] = resync_x;
+	while (resync_x < end) {
+		uint8_t object = get_object_at(resync_x, resync_y);
+		uint8_t count = 1;
+		while (resync_x + count < end && count < 8 
+				&& get_object_at(resync_x + count, resync_y) == object) {
+			count++;
+		}
+		record[length++] = ((count - 1) << 4) | object;
+		resync_x += count;
+	}
+	return length;
+}
+
+void spectator_update(void) {
+	uint8_t record[MAX_RECORD_LENGTH];
+	
+	if (resync_state == RESYNC_PENDING) {
+		resync_state = RESYNC_LEVEL;
+	}
+	while (resync_state != RESYNC_DONE && spectator_space() >= MAX_RECORD_LENGTH) {
+		if (resync_state == RESYNC_LEVEL) {
+			record[0] = SPECTATOR_LEVEL;
+			// the level goes past 127 as the levels cycle, so is sent
+			// 7 bits at a time
+			record[1] = get_level() & 0x7F;
+			record[2] = get_level() >> 7;
+			record[3] = get_world_width();
+			record[4] = get_world_height();
+			spectator_send(record, 5);
+			resync_x = 0;
+			resync_y = 0;
+			resync_state = RESYNC_ROWS;
+		} else if (resync_y < get_world_height()) {
+			spectator_send(record, spectator_row(record));
+			if (resync_x == get_world_width()) {
+				resync_x = 0;
+				resync_y++;
+			}
+		} else {
+			resync_state = RESYNC_DONE;
+			spectator_player(get_player_x(), get_player_y());
+			spectator_score(get_score(), get_diamonds_available());
+			if (is_game_over()) {
+				spectator_game_over();
+			}
+		}
+	}
+}
+
+void spectator_square(uint8_t x, uint8_t y, uint8_t object) {
+	uint8_t record[4] = {SPECTATOR_SQUARE, x, y, object};
+	// squares in rows before the next one to be sent have been sent
+	spectator_change(record, 4, resync_state == RESYNC_ROWS 
+			&& (y < resync_y || (y == resync_y && x < resync_x)));
+}
+
+void spectator_player(uint8_t x, uint8_t y) {
+	uint8_t record[3] = {SPECTATOR_PLAYER, x, y};
+	spectator_change(record, 3, 0);
+}
+
+void spectator_score(uint8_t score, uint8_t diamonds_available) {
+	uint8_t record[3] = {SPECTATOR_SCORE, score, diamonds_available};
+	spectator_change(record, 3, 0);
+}
+
+void spectator_game_over(void) {
+	uint8_t record[1] = {SPECTATOR_GAME_OVER};
+	spectator_change(record, 1, 0);
+}
+
+ISR(USART1_UDRE_vect) {
+	if (spectator_length > 0) {
+		UDR1 = spectator_buffer[spectator_tail];
+		if (++spectator_tail == SPECTATOR_BUFFER_SIZE) {
+			spectator_tail = 0;
+		}
+		spectator_length--;
+	} else {
+		// nothing left to send, this is reenabled when a record is added
+		UCSR1B &= ~(1 << UDRIE1);
+	}
+}
+
+#endif /* SPECTATOR */
@@ -0,0 +1,82 @@
+/*
+ * spectator.h
+ *
+ * Author: William Sawyer
+ *
+ * A feed of the game for spectators, sent on USART1 (TXD1, pin D3) at
+ * SPECTATOR_BAUD, independently of the terminal on USART0. When a level
+ * starts (or the feed falls behind) the whole playing field is sent, 
+ * and from then on only the changes the game makes to it, the player's
+ * moves and the score. host/spectate.c shows the feed on a terminal.
+ *
+ * The feed is a sequence of records. Each starts with one of the record
+ * types below, and every other byte is less than 0x80, so a viewer can
+ * pick up the feed part way through. Squares are given as object codes
+ * (see display.h). A run byte gives a count less 1 in bits 4 to 6 and
+ * an object in bits 0 to 3. The level is sent as its low 7 bits then
+ * its top bit, as it can go past 127.
+ *
+ * The feed is only compiled in when SPECTATOR is defined to 1. TXD1 is
+ * the pin normally used for the diamond detector LED, so the detector 
+ * is moved to pin D5 when it is.
+ */
+
+#ifndef SPECTATOR_H_
+#define SPECTATOR_H_
+
+#include <stdint.h>
+
+#ifndef SPECTATOR
+#define SPECTATOR 0
+#endif
+
+#define SPECTATOR_BAUD			250000
+
+// record types
+#define SPECTATOR_LEVEL			0xA0	// level (low 7 bits, top bit),
+										// width, height
+#define SPECTATOR_ROW			0xA1	// y, x, runs of up to 
+										// SPECTATOR_ROW_LENGTH squares
+#define SPECTATOR_SQUARE		0xA2	// x, y, object
+#define SPECTATOR_PLAYER		0xA3	// x, y
+#define SPECTATOR_SCORE			0xA4	// score, diamonds available
+#define SPECTATOR_GAME_OVER		0xA5
+
+#define SPECTATOR_ROW_LENGTH	16
+
+#if SPECTATOR
+
+/* Set up USART1 to send the feed.
+ */
+void init_spectator(void);
+
+/* Send the whole playing field again, from the next call to 
+ * spectator_update().
+ */
+void spectator_resync(void);
+
+/* Send as much of a resync as there is room for. Call this regularly.
+ */
+void spectator_update(void);
+
+/* Report changes to the game. If there isn't room to send one, the feed
+ * is resynchronised instead - the game is never held up.
+ */
+void spectator_square(uint8_t x, uint8_t y, uint8_t object);
+void spectator_player(uint8_t x, uint8_t y);
+void spectator_score(uint8_t score, uint8_t diamonds_available);
+void spectator_game_over(void);
+
+#else
+
+#define init_spectator()
+#define spectator_resync()
+#define spectator_update()
+#define spectator_square(x, y, object)
+#define spectator_player(x, y)
+#define spectator_score(score, diamonds_available)
+#define spectator_game_over()
+
+#endif /* SPECTATOR */
+
+#endif /* SPECTATOR_H_ */
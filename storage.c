@@ -0,0 +1,79 @@
+/*
+ * storage.c
+ *
+ * Author: William Sawyer
+ */
+
+#include <stdint.h>
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/eeprom.h>
+
+#include "storage.h"
+
+typedef struct {
+	uint16_t address;
+	const uint8_t* data;
+	uint8_t length;
+} StorageWrite;
+
+// queued writes, the first of which is in progress
+static StorageWrite queue[STORAGE_QUEUE_LENGTH];
+static volatile uint8_t queue_start;
+static volatile uint8_t queue_length;
+
+uint8_t storage_write(uint16_t address, const void* data, uint8_t length) {
+	uint8_t queued = 0;
+	uint8_t interrupts_on = bit_is_set(SREG, SREG_I);
+	cli();
+	if (queue_length < STORAGE_QUEUE_LENGTH) {
+		StorageWrite* write = 
+				&queue[(queue_start + queue_length) % STORAGE_QUEUE_LENGTH];
+		write->address = address;
+		write->data = data;
+		write->length = length;
+		queue_length++;
+		queued = 1;
+		// the interrupt fires as soon as the EEPROM is ready
+		EECR |= (1 << EERIE);
+	}
+	if (interrupts_on) {
+		sei();
+	}
+	return queued;
+}
+
+uint8_t storage_busy(void) {
+	return queue_length;
+}
+
+void storage_read(uint16_t address, void* data, uint8_t length) {
+	eeprom_read_block(data, (const void*)address, length);
+}
+
+ISR(EE_READY_vect) {
+	while (queue_length) {
+		StorageWrite* write = &queue[queue_start];
+		while (write->length) {
+			uint8_t value = *write->data++;
+			uint16_t address = write->address++;
+			write->length--;
+			EEAR = address;
+			EECR |= (1 << EERE);
+			if (EEDR != value) {
+				// erase and write the byte, the interrupt fires again
+				// when it is done
+				EEDR = value;
+				EECR |= (1 << EEMPE);
+				EECR |= (1 << EEPE);
+				return;
+			}
+		}
+		// this write is done
+		queue_start = (queue_start + 1) % STORAGE_QUEUE_LENGTH;
+		queue_length--;
+	}
+	// nothing more to write
+	EECR &= ~(1 << EERIE);
+}
@@ -0,0 +1,44 @@
+/*
+ * storage.h
+ *
+ * Author: William Sawyer
+ *
+ * Deferred writes to the 1KB EEPROM. Programming an EEPROM byte takes 
+ * about 3.4ms, so rather than waiting for each byte, writes are queued
+ * and carried out a byte at a time by the EEPROM ready interrupt. Bytes
+ * which already hold the value being written are skipped, which saves
+ * both time and wear.
+ */
+
+#ifndef STORAGE_H_
+#define STORAGE_H_
+
+#include <stdint.h>
+
+// How the EEPROM is divided up
+#define HIGHSCORE_EEPROM_START	0x000
+#define HIGHSCORE_EEPROM_SIZE	0x0C0
+#define SAVE_EEPROM_START		0x0C0	// saved game header
+#define SAVE_IMAGE_EEPROM_START	0x100	// saved playing field
+#define SAVE_IMAGE_EEPROM_SIZE	0x300
+
+// the most writes which can be queued at once
+#define STORAGE_QUEUE_LENGTH	4
+
+/* Queue 'length' bytes from 'data' to be written to the EEPROM at
+ * 'address'. The data is not copied, so it must not be changed until
+ * the write is done (see storage_busy()). Returns 1 if the write was
+ * queued, 0 if the queue is full.
+ */
+uint8_t storage_write(uint16_t address, const void* data, uint8_t length);
+
+/* Return the number of writes queued or in progress.
+ */
+uint8_t storage_busy(void);
+
+/* Read 'length' bytes from the EEPROM at 'address' into 'data'. This 
+ * waits for any byte being programmed, but not for queued writes.
+ */
+void storage_read(uint16_t address, void* data, uint8_t length);
+
+#endif /* STORAGE_H_ */
@@ -1,102 +1,137 @@
-/*
- * terminalio.c
- *
- * Author: Peter Sutton
- */
-
-#include <stdio.h>
-#include <stdint.h>
-
-#include <avr/pgmspace.h>
-
-#include "terminalio.h"
-
-void move_terminal_cursor(int x, int y) {
-    printf_P(PSTR("\x1b[%d;%dH"), y, x);
-}
-
-void normal_display_mode(void) {
-	printf_P(PSTR("\x1b[0m"));
-}
-
-void reverse_video(void) {
-	printf_P(PSTR("\x1b[7m"));
-}
-
-void clear_terminal(void) {
-	printf_P(PSTR("\x1b[2J"));
-}
-
-void clear_to_end_of_line(void) {
-	printf_P(PSTR("\x1b[K"));
-}
-
-void set_display_attribute(DisplayParameter parameter) {
-	printf_P(PSTR("\x1b[%dm"), parameter);
-}
-
-void hide_cursor() {
-	printf_P(PSTR("\x1b[?25l"));
-}
-
-void show_cursor() {
-	printf_P(PSTR("\x1b[?25h"));
-}
-
-void enable_scrolling_for_whole_display(void) {
-	printf_P(PSTR("\x1b[r"));
-}
-
-void set_scroll_region(int8_t y1, int8_t y2) {
-	printf_P(PSTR("\x1b[%d;%dr"), y1, y2);
-}
-
-void scroll_down(void) {
-	printf_P(PSTR("\x1bM"));	// ESC-M
-}
-
-void scroll_up(void) {
-	printf_P(PSTR("\x1b\x44"));	// ESC-D
-}
-
-void draw_horizontal_line(int8_t y, int8_t start_x, int8_t end_x) {
-	int8_t i;
-	move_terminal_cursor(start_x, y);
-	reverse_video();
-	for (i = start_x; i <= end_x; i++) {
-		printf(" ");	/* No need to use printf_P - printing 
-						 * a single character gets optimised
-						 * to a putchar call 
-						 */
-	}
-	normal_display_mode();
-}
-
-void draw_vertical_line(int8_t x, int8_t start_y, int8_t end_y) {
-	int8_t i;
-	move_terminal_cursor(x, start_y);
-	reverse_video();
-	for (i = start_y; i < end_y; i++) {
-		printf(" ");
-		/* Move down one and back to the left one */
-		printf_P(PSTR("\x1b[B\x1b[D"));
-	}
-	printf(" ");
-	normal_display_mode();
-}
-
-void update_score(uint8_t score) {
-	move_terminal_cursor(EDIT_SCORE_X, SCORE_Y);
-	printf_P(PSTR("%u"), score);
-	move_terminal_cursor(0, 0); // gets cursor out of the way
-}
-
-void update_cheat(uint8_t cheating) {
-	move_terminal_cursor(EDIT_CHEAT_X, CHEAT_Y);
-	if (cheating) {
-		printf_P(PSTR("Enabled ")); // trailing space to match length of "disabled"
-	} else {
-		printf_P(PSTR("Disabled"));
-	}
-	move_terminal_cursor(0, 0); // gets cursor out of the way
-}
\ No newline at end of file
+/*
+ * terminalio.c
+ *
+ * Author: Peter Sutton
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include <avr/pgmspace.h>
+
+#include "terminalio.h"
+#include "profile.h"
+#include "gameclock.h"
+
+void move_terminal_cursor(int x, int y) {
+    PROFILE_CALL(PROFILE_PRINTF, printf_P(PSTR("\x1b[%d;%dH"), y, x));
+}
+
+void normal_display_mode(void) {
+	printf_P(PSTR("\x1b[0m"));
+}
+
+void reverse_video(void) {
+	printf_P(PSTR("\x1b[7m"));
+}
+
+void clear_terminal(void) {
+	PROFILE_CALL(PROFILE_PRINTF, printf_P(PSTR("\x1b[2J")));
+}
+
+void clear_to_end_of_line(void) {
+	PROFILE_CALL(PROFILE_PRINTF, printf_P(PSTR("\x1b[K")));
+}
+
+void clear_to_end_of_screen(void) {
+	printf_P(PSTR("\x1b[J"));
+}
+
+void set_display_attribute(DisplayParameter parameter) {
+	printf_P(PSTR("\x1b[%dm"), parameter);
+}
+
+void hide_cursor() {
+	printf_P(PSTR("\x1b[?25l"));
+}
+
+void show_cursor() {
+	printf_P(PSTR("\x1b[?25h"));
+}
+
+void enable_scrolling_for_whole_display(void) {
+	printf_P(PSTR("\x1b[r"));
+}
+
+void set_scroll_region(int8_t y1, int8_t y2) {
+	printf_P(PSTR("\x1b[%d;%dr"), y1, y2);
+}
+
+void scroll_down(void) {
+	printf_P(PSTR("\x1bM"));	// ESC-M
+}
+
+void scroll_up(void) {
+	printf_P(PSTR("\x1b\x44"));	// ESC-D
+}
+
+void draw_horizontal_line(int8_t y, int8_t start_x, int8_t end_x) {
+	int8_t i;
+	move_terminal_cursor(start_x, y);
+	reverse_video();
+	for (i = start_x; i <= end_x; i++) {
+		printf(" ");	/* No need to use printf_P - printing 
+						 * a single character gets optimised
+						 * to a putchar call 
+						 */
+	}
+	normal_display_mode();
+}
+
+void draw_vertical_line(int8_t x, int8_t start_y, int8_t end_y) {
+	int8_t i;
+	move_terminal_cursor(x, start_y);
+	reverse_video();
+	for (i = start_y; i < end_y; i++) {
+		printf(" ");
+		/* Move down one and back to the left one */
+		printf_P(PSTR("\x1b[B\x1b[D"));
+	}
+	printf(" ");
+	normal_display_mode();
+}
+
+void update_score(uint8_t score) {
+	move_terminal_cursor(EDIT_SCORE_X, SCORE_Y);
+	PROFILE_CALL(PROFILE_PRINTF, printf_P(PSTR("%u"), score));
+	move_terminal_cursor(0, 0); // gets cursor out of the way
+}
+
+void update_cheat(uint8_t cheating) {
+	move_terminal_cursor(EDIT_CHEAT_X, CHEAT_Y);
+	if (cheating) {
+		// trailing space to match length of "disabled"
+		PROFILE_CALL(PROFILE_PRINTF, printf_P(PSTR("Enabled ")));
+	} else {
+		PROFILE_CALL(PROFILE_PRINTF, printf_P(PSTR("Disabled")));
+	}
+	move_terminal_cursor(0, 0); // gets cursor out of the way
+}
+
+void update_speed(uint8_t scale) {
+	move_terminal_cursor(SPEED_X, SPEED_Y);
+	clear_to_end_of_line();
+	if (scale > GAME_CLOCK_SCALE_ONE) {
+		PROFILE_CALL(PROFILE_PRINTF, printf_P(PSTR("Speed: %ux"), 
+				scale / GAME_CLOCK_SCALE_ONE));
+	} else if (scale < GAME_CLOCK_SCALE_ONE) {
+		PROFILE_CALL(PROFILE_PRINTF, printf_P(PSTR("Speed: 1/%ux"), 
+				GAME_CLOCK_SCALE_ONE / scale));
+	}
+	move_terminal_cursor(0, 0); // gets cursor out of the way
+}
+
+void update_input_status(uint8_t batch, uint8_t autoplay, uint16_t lost) {
+	move_terminal_cursor(INPUT_X, INPUT_Y);
+	clear_to_end_of_line();
+	if (autoplay) {
+		PROFILE_CALL(PROFILE_PRINTF, printf_P(PSTR("Autoplay  ")));
+	}
+	if (batch) {
+		PROFILE_CALL(PROFILE_PRINTF, printf_P(PSTR("Batch Input  ")));
+	}
+	if (lost) {
+		PROFILE_CALL(PROFILE_PRINTF, printf_P(PSTR("Input Lost: %u"), lost));
+	}
+	move_terminal_cursor(0, 0); // gets cursor out of the way
+}
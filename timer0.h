@@ -1,35 +1,60 @@
-/*
- * timer0.h
- *
- * Author: Peter Sutton
- *
- * We set up timer 0 to give us an interrupt
- * every millisecond. Tasks that have to occur
- * regularly (every millisecond or few) can be added 
- * to the interrupt handler (in timer0.c) or can
- * be added to the main event loop that checks the
- * clock tick value. This value (32 bits) can be 
- * obtained using the get_clock_ticks() function.
- * (Any tasks undertaken in the interrupt handler
- * should be kept short so that we don't run the 
- * risk of missing an interrupt in future.)
- */
-
-#ifndef TIMER0_H_
-#define TIMER0_H_
-
-#include <stdint.h>
-
-/* Set up our timer to give us an interrupt every millisecond
- * and update our time reference.
- */
-void init_timer0(void);
-
-void set_current_time(uint32_t time);
-
-/* Return the current clock tick value - milliseconds since the timer was
- * initialised.
- */
-uint32_t get_current_time(void);
-
+/*
+ * timer0.h
+ *
+ * Author: Peter Sutton
+ *
+ * We set up timer 0 to give us an interrupt
+ * every millisecond. Tasks that have to occur
+ * regularly (every millisecond or few) can be added 
+ * to the interrupt handler (in timer0.c) or can
+ * be added to the main event loop that checks the
+ * clock tick value. This value (32 bits) can be 
+ * obtained using the get_clock_ticks() function.
+ * (Any tasks undertaken in the interrupt handler
+ * should be kept short so that we don't run the 
+ * risk of missing an interrupt in future.)
+ */
+
+#ifndef TIMER0_H_
+#define TIMER0_H_
+
+#include <stdint.h>
+
+/* Set up our timer to give us an interrupt every millisecond
+ * and update our time reference.
+ */
+void init_timer0(void);
+
+/* Return the current clock tick value - milliseconds since the timer was
+ * initialised.
+ */
+uint32_t get_current_time(void);
+
+/* Return the low 16 bits of the clock tick value, which is quicker to
+ * read. It wraps around every 65.5 seconds.
+ */
+uint16_t get_current_time_16(void);
+
+// the coarse tick counts this many milliseconds, a power of two
+#define COARSE_TICK_MS	8
+
+/* Return the coarse tick, which goes up by one every COARSE_TICK_MS. It
+ * is a single byte, so unlike the clock tick it is read without turning
+ * interrupts off, for checks made on every pass of the game loop. It
+ * wraps around every 2 seconds.
+ */
+uint8_t get_coarse_time(void);
+
+/* Times which wrap around. TIME_SINCE gives the milliseconds (or coarse
+ * ticks) from 'then' to 'now', which is right across a wraparound as long
+ * as they are less than a wrap apart. TIME_REACHED is 1 once 'now' is at
+ * or after 'when', which must be less than half a wrap away. Comparing
+ * times directly (now >= then + delay) goes wrong when 'then + delay'
+ * wraps past zero.
+ */
+#define TIME_SINCE(now, then)			((uint32_t)((now) - (then)))
+#define TIME_SINCE_16(now, then)		((uint16_t)((now) - (then)))
+#define TIME_SINCE_COARSE(now, then)	((uint8_t)((now) - (then)))
+#define TIME_REACHED(now, when)			((int32_t)((now) - (when)) >= 0)
+
 #endif
\ No newline at end of file
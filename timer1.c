@@ -0,0 +1,65 @@
+/*
+ * timer1.c
+ *
+ * Author: William Sawyer
+ *
+ * We run timer1 without a prescaler and count its overflows so
+ * that the number of clock cycles since startup can be read.
+ */
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+
+#include "timer1.h"
+
+#if PROFILE
+
+/* Number of times the 16 bit counter has overflowed - this forms the
+ * upper 16 bits of the cycle count. */
+static volatile uint16_t timer1_overflows;
+
+void init_timer1(void) {
+	timer1_overflows = 0;
+	
+	/* Clear the timer */
+	TCNT1 = 0;
+	
+	/* Normal mode (count up to 0xFFFF and wrap around) with no
+	 * prescaler. This starts the timer running.
+	 */
+	TCCR1A = 0;
+	TCCR1B = (1<<CS10);
+	
+	/* Make sure the overflow flag is cleared by writing a 1 to it 
+	 * and enable the overflow interrupt.
+	 */
+	TIFR1 = (1<<TOV1);
+	TIMSK1 |= (1<<TOIE1);
+}
+
+uint32_t get_cycle_count(void) {
+	uint16_t low, high;
+	
+	/* Disable interrupts so the counter and overflow count are read
+	 * together. If the counter has overflowed since the interrupt last 
+	 * ran (the flag is still set) and the low half has wrapped around, 
+	 * account for the pending overflow ourselves.
+	 */
+	uint8_t interruptsOn = bit_is_set(SREG, SREG_I);
+	cli();
+	low = TCNT1;
+	high = timer1_overflows;
+	if ((TIFR1 & (1<<TOV1)) && low < 0x8000) {
+		high++;
+	}
+	if (interruptsOn) {
+		sei();
+	}
+	return ((uint32_t)high << 16) | low;
+}
+
+ISR(TIMER1_OVF_vect) {
+	timer1_overflows++;
+}
+
+#endif /* PROFILE */
@@ -0,0 +1,42 @@
+/*
+ * timer1.h
+ *
+ * Author: William Sawyer
+ *
+ * Timer 1 is left free-running at the full 8MHz system clock so it can
+ * be used as a cycle counter for profiling and latency measurement.
+ * The 16 bit counter overflows every 8.192ms; overflows are counted
+ * in an interrupt so a 32 bit cycle count can be obtained with
+ * get_cycle_count(). (The 32 bit count wraps after ~9 minutes, so it
+ * should only be used to measure intervals shorter than that.)
+ *
+ * Only the profiler reads the count, so timer 1 is only set up when 
+ * PROFILE is 1, and other builds don't take its overflow interrupt.
+ */
+
+#ifndef TIMER1_H_
+#define TIMER1_H_
+
+#include <stdint.h>
+
+#include "profile.h"
+
+#if PROFILE
+
+/* Start timer 1 counting system clock cycles and enable the overflow
+ * interrupt.
+ */
+void init_timer1(void);
+
+/* Return the number of system clock cycles since init_timer1() was
+ * called (modulo 2^32).
+ */
+uint32_t get_cycle_count(void);
+
+#else
+
+#define init_timer1()
+
+#endif /* PROFILE */
+
+#endif /* TIMER1_H_ */
@@ -0,0 +1,191 @@
+/*
+ * trace.c
+ *
+ * Author: William Sawyer
+ *
+ * Keeps the ring of trace records described in trace.h and prints it on
+ * request.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <avr/io.h>
+#include <avr/wdt.h>
+#include <avr/pgmspace.h>
+
+#include "trace.h"
+#include "timer0.h"
+#include "terminalio.h"
+
+#if TRACE
+
+// marks a ring which has been set up, rather than left over from power up
+#define TRACE_MAGIC		0x7A3C
+
+typedef struct {
+	uint8_t delta;		// ms since the record before, 255 if longer
+	uint8_t event;
+	uint16_t payload;
+} TraceRecord;
+
+typedef struct {
+	uint16_t magic;
+	uint8_t head;		// where the next record goes, wraps at 256
+	uint16_t last_time;	// low 16 bits of the time of the last record
+	TraceRecord records[TRACE_LENGTH];
+} TraceRing;
+
+// neither of these is cleared by the C startup code
+static TraceRing ring __attribute__ ((section(".noinit")));
+static uint8_t reset_cause __attribute__ ((section(".noinit")));
+
+static uint8_t kept;		// the ring was kept from before a reset
+static uint8_t dumping;		// don't record the printing of the ring
+
+/* Save and clear the reset flags, and turn the watchdog off in case it
+ * caused the reset (it stays on afterwards, and would reset again before
+ * main() could do anything). This runs in .init3, before any variables
+ * are set up, and must not be called.
+ */
+void trace_get_reset_cause(void) __attribute__ ((naked, used,
+		section(".init3")));
+
+void trace_get_reset_cause(void) {
+	reset_cause = MCUSR;
+	MCUSR = 0;
+	wdt_disable();
+}
+
+static TraceRecord* add_record(uint8_t event) {
+	uint16_t now = get_current_time_16();
+	uint16_t delta = TIME_SINCE_16(now, ring.last_time);
+	ring.last_time = now;
+	TraceRecord* record = &ring.records[ring.head++ & (TRACE_LENGTH - 1)];
+	record->delta = delta > 255 ? 255 : delta;
+	record->event = event;
+	return record;
+}
+
+void trace_event(uint8_t event, uint16_t payload) {
+	if (dumping) {
+		return;
+	}
+	add_record(event)->payload = payload;
+}
+
+void trace_uart_stall(uint16_t start) {
+	if (dumping) {
+		return;
+	}
+	uint16_t waited = TIME_SINCE_16(get_current_time_16(), start);
+	if (waited > 255) {
+		waited = 255;
+	}
+	// a long print stalls on most characters, so back to back stalls are
+	// added up in one record rather than pushing everything else out
+	TraceRecord* last = &ring.records[(ring.head - 1) & (TRACE_LENGTH - 1)];
+	if (last->event == TRACE_UART_STALL) {
+		uint8_t waits = last->payload >> 8;
+		uint16_t total = (last->payload & 0xFF) + waited;
+		if (waits < 255) {
+			waits++;
+		}
+		last->payload = (uint16_t)waits << 8 | (total > 255 ? 255 : total);
+	} else {
+		add_record(TRACE_UART_STALL)->payload = 1 << 8 | waited;
+	}
+}
+
+void trace_long_loop(uint16_t start) {
+	uint16_t took = TIME_SINCE_16(get_current_time_16(), start);
+	if (took >= TRACE_LONG_LOOP_MS) {
+		trace_event(TRACE_LONG_LOOP, took);
+	}
+}
+
+void init_trace(void) {
+	// RAM can't be trusted after the power has been off
+	kept = ring.magic == TRACE_MAGIC && !(reset_cause & (1 << PORF))
+			&& (reset_cause & ((1 << WDRF) | (1 << EXTRF)));
+	if (!kept) {
+		memset(&ring, 0, sizeof(ring));
+		ring.magic = TRACE_MAGIC;
+	}
+	ring.last_time = get_current_time_16();
+	trace_event(TRACE_RESET, reset_cause);
+}
+
+uint8_t trace_after_reset(void) {
+	return kept;
+}
+
+static const char none_name[] PROGMEM = "";
+static const char reset_name[] PROGMEM = "reset";
+static const char move_name[] PROGMEM = "move";
+static const char reveal_name[] PROGMEM = "dfs";
+static const char bomb_name[] PROGMEM = "bomb";
+static const char explode_name[] PROGMEM = "boom";
+static const char level_name[] PROGMEM = "level";
+static const char game_over_name[] PROGMEM = "over";
+static const char uart_name[] PROGMEM = "uart";
+static const char loop_name[] PROGMEM = "loop";
+static const char lost_name[] PROGMEM = "lost";
+static PGM_P const event_names[TRACE_NUM_EVENTS] PROGMEM =
+		{none_name, reset_name, move_name, reveal_name, bomb_name,
+		explode_name, level_name, game_over_name, uart_name, loop_name,
+		lost_name};
+
+void trace_dump(void) {
+	dumping = 1;
+	move_terminal_cursor(DEBUG_X, DEBUG_Y);
+	clear_to_end_of_screen();
+	printf_P(PSTR("Trace, oldest first (+ms event payload)%S\n"),
+			kept ? PSTR(" from before the reset") : PSTR(""));
+	uint8_t shown = 0;
+	for (uint8_t i = 0; i < TRACE_LENGTH; i++) {
+		TraceRecord* record =
+				&ring.records[(uint8_t)(ring.head + i) & (TRACE_LENGTH - 1)];
+		if (record->event == TRACE_NONE || record->event >= TRACE_NUM_EVENTS) {
+			continue;
+		}
+		printf_P(PSTR("+%-3u %-5S "), record->delta,
+				(PGM_P)pgm_read_ptr(&event_names[record->event]));
+		switch (record->event) {
+			case TRACE_MOVE:
+			case TRACE_REVEAL:
+			case TRACE_BOMB:
+			case TRACE_EXPLODE:
+				printf_P(PSTR("%2u,%-5u"), record->payload & 0xFF,
+						record->payload >> 8);
+				break;
+			case TRACE_UART_STALL:
+				printf_P(PSTR("%ux%-4u"), record->payload >> 8,
+						record->payload & 0xFF);
+				break;
+			default:
+				printf_P(PSTR("%-8u"), record->payload);
+				break;
+		}
+		// four records to a line
+		if (++shown % 4 == 0) {
+			printf_P(PSTR("\n"));
+		}
+	}
+	dumping = 0;
+}
+
+#else
+
+void init_trace(void) {
+}
+
+uint8_t trace_after_reset(void) {
+	return 0;
+}
+
+void trace_dump(void) {
+	move_terminal_cursor(DEBUG_X, DEBUG_Y);
+	printf_P(PSTR("Tracing not compiled in (TRACE=0)"));
+}
+
+#endif /* TRACE */
@@ -0,0 +1,101 @@
+/*
+ * trace.h
+ *
+ * Author: William Sawyer
+ *
+ * Post-mortem trace. The game records what it does (moves, reveals,
+ * bombs, levels loading, waits for the serial port, lost input and slow
+ * passes of the game loop) as 4 byte records in a small ring in RAM, overwriting
+ * the oldest. The ring is kept in .noinit, which the C startup code
+ * doesn't clear, so after a watchdog reset or the reset button it still
+ * holds what led up to the reset and is shown on the start screen. It
+ * can also be shown at any time during the game (the t key).
+ *
+ * Recording an event costs a function call and a few loads and stores,
+ * so tracing is left on in firmware builds. Define TRACE to 0 to leave
+ * it out, as host builds do. PROFILE builds leave it out too, as there
+ * isn't the RAM for both the ring and the profiler's histograms.
+ */
+
+#ifndef TRACE_H_
+#define TRACE_H_
+
+#include <stdint.h>
+
+#ifndef TRACE
+#include "profile.h"
+#if defined(__AVR__) && !PROFILE
+#define TRACE 1
+#else
+#define TRACE 0
+#endif
+#endif
+
+// records kept, a power of two
+#define TRACE_LENGTH		32
+
+// Events, followed by what their payload holds
+#define TRACE_NONE			0
+#define TRACE_RESET			1	// MCUSR, why the microcontroller was reset
+#define TRACE_MOVE			2	// x, y the player moved (or stayed) to
+#define TRACE_REVEAL		3	// x, y a discoverable_dfs() started from
+#define TRACE_BOMB			4	// x, y a bomb was planted at
+#define TRACE_EXPLODE		5	// x, y of an exploding bomb
+#define TRACE_LEVEL			6	// level which was loaded
+#define TRACE_GAME_OVER		7	// total score
+#define TRACE_UART_STALL	8	// waits (high byte), ms (low byte)
+#define TRACE_LONG_LOOP		9	// ms one pass of the game loop took
+#define TRACE_INPUT_LOST	10	// serial characters thrown away
+#define TRACE_NUM_EVENTS	11
+
+// a pass of the game loop taking this many ms or more is recorded
+#define TRACE_LONG_LOOP_MS	16
+
+// payload for events at a square
+#define TRACE_XY(x, y)		((uint8_t)(x) | (uint16_t)(y) << 8)
+
+#if TRACE
+
+#include "timer0.h"
+
+/* Record an event. Only called from the main program, not interrupt
+ * handlers.
+ */
+#define TRACE_EVENT(event, payload)	trace_event(event, payload)
+
+/* Time a wait for the serial port or a pass of the game loop.
+ * TRACE_TIME_START declares a local variable, so must appear in the same
+ * block as the matching TRACE_UART_STALL_END or TRACE_LONG_LOOP_END.
+ */
+#define TRACE_TIME_START()		uint16_t trace_start = get_current_time_16()
+#define TRACE_UART_STALL_END()	trace_uart_stall(trace_start)
+#define TRACE_LONG_LOOP_END()	trace_long_loop(trace_start)
+
+void trace_event(uint8_t event, uint16_t payload);
+void trace_uart_stall(uint16_t start);
+void trace_long_loop(uint16_t start);
+
+#else
+
+#define TRACE_EVENT(event, payload)
+#define TRACE_TIME_START()
+#define TRACE_UART_STALL_END()
+#define TRACE_LONG_LOOP_END()
+
+#endif /* TRACE */
+
+/* Keep the trace left from before a reset if there is one, otherwise
+ * start a new one. Call after the timer and serial port are set up.
+ */
+void init_trace(void);
+
+/* Return 1 if the microcontroller was reset other than by turning it on,
+ * and the trace from before the reset was kept.
+ */
+uint8_t trace_after_reset(void);
+
+/* Print the trace to the terminal (below the game), oldest first.
+ */
+void trace_dump(void);
+
+#endif /* TRACE_H_ */